@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "fmt.h"
+#include "format.h"
+#include "formatbulk.h"
+#include "formathex.h"
+#include "lzcodec.h"
+
+// 统计堆内存分配次数，用于计算allocations/op
+static std::atomic<std::size_t> s_allocs { 0 };
+
+void* operator new(std::size_t size)
+{
+    s_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+using jumper::Fmt;
+
+namespace {
+
+class User {
+public:
+    User(unsigned id, const std::string& name)
+        : m_id(id), m_name(name) {}
+
+    unsigned m_id;
+    std::string m_name;
+};
+
+std::ostream& operator<<(std::ostream& oss, const User& user)
+{
+    return oss << "id:" << user.m_id << ",name:" << user.m_name;
+}
+
+// 与User相同的输出，但通过formatter特化直接写入缓冲区
+class FastUser: public User {
+public:
+    using User::User;
+};
+
+// 只统计字节数的输出目标
+class CountingSink: public jumper::FmtSink {
+public:
+    bool flush(const char*, std::size_t len) override
+    {
+        m_bytes += len;
+        return true;
+    }
+
+    std::size_t m_bytes = 0;
+};
+
+} // namespace
+
+namespace jumper {
+template<>
+struct formatter<FastUser> {
+    void format(FmtBuffer& buf, const FastUser& user, const std::string&) const
+    {
+        buf.append("id:", 3);
+        jumper_inner::write_value(buf, user.m_id);
+        buf.append(",name:", 6);
+        buf.append(user.m_name);
+    }
+};
+} // namespace jumper
+
+namespace {
+
+// 防止编译器优化掉被测代码
+std::size_t s_sink = 0;
+
+// 单项测试结果
+struct Result {
+    std::string name;
+    std::size_t iters;
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// 运行一项测试：先预热，再计时iters次
+Result run(const std::string& name, std::size_t iters,
+    const std::function<std::size_t()>& op)
+{
+    for (std::size_t i = 0; i != iters / 10 + 1; ++i)
+    {
+        s_sink += op();
+    }
+
+    auto allocs = s_allocs.load(std::memory_order_relaxed);
+    auto begin = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != iters; ++i)
+    {
+        s_sink += op();
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocs = s_allocs.load(std::memory_order_relaxed) - allocs;
+
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+
+    return { name, iters, ns / iters, static_cast<double>(allocs) / iters };
+}
+
+void print_csv(const std::vector<Result>& results)
+{
+    std::printf("name,iters,ns_per_op,allocs_per_op\n");
+    for (const auto& r: results)
+    {
+        std::printf("%s,%zu,%.2f,%.2f\n", r.name.c_str(), r.iters, r.nsPerOp, r.allocsPerOp);
+    }
+}
+
+void print_json(const std::vector<Result>& results)
+{
+    std::printf("[\n");
+    for (std::size_t i = 0; i != results.size(); ++i)
+    {
+        const auto& r = results[i];
+        std::printf("  {\"name\": \"%s\", \"iters\": %zu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.2f}%s\n",
+            r.name.c_str(), r.iters, r.nsPerOp, r.allocsPerOp,
+            i + 1 == results.size() ? "" : ",");
+    }
+    std::printf("]\n");
+}
+
+} // namespace
+
+/// 用法：format_bench [--json] [--iters N]
+/// 默认输出CSV，每项测试的耗时(ns/op)和堆内存分配次数(allocs/op)
+int main(int argc, char *argv[])
+{
+    bool json = false;
+    std::size_t iters = 200000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == std::strcmp(argv[i], "--json"))
+        {
+            json = true;
+        }
+        else if (0 == std::strcmp(argv[i], "--iters") && i + 1 < argc)
+        {
+            iters = std::strtoul(argv[++i], nullptr, 10);
+        }
+    }
+
+    const char* fmtStr = "loop index: {}, a = {}, b = {}";
+    Fmt fmt(fmtStr);
+    const char* mixedStr = "id={} price={} sym={} user={}";
+    Fmt mixed(mixedStr);
+    User user(7, "Jumper");
+    std::string sym("AAPL");
+    std::vector<Result> results;
+
+    results.push_back(run("fmt_construct", iters, [&]() {
+        Fmt f(fmtStr);
+        return f.subs().size();
+    }));
+
+    // 逐段追加N个片段构造Fmt，每次只解析新增的部分，总耗时应随N线性增长
+    const std::size_t appendCounts[] = { 50, 200, 800 };
+    for (auto n: appendCounts)
+    {
+        results.push_back(run("fmt_append_" + std::to_string(n), iters / n + 1, [n]() {
+            Fmt f("report:");
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                f += " col={}";
+            }
+            return f.subs().size();
+        }));
+    }
+
+    results.push_back(run("fmtview_construct", iters, [&]() {
+        jumper::FmtView f(fmtStr);
+        return f.size();
+    }));
+
+    results.push_back(run("format_literal", iters, [&]() {
+        return jumper::format(fmtStr, 1, 2, 3).size();
+    }));
+
+    results.push_back(run("format_reused_fmt", iters, [&]() {
+        return jumper::format(fmt, 1, 2, 3).size();
+    }));
+
+    jumper::FmtView view(fmtStr);
+    results.push_back(run("format_reused_fmtview", iters, [&]() {
+        return jumper::format(view, 1, 2, 3).size();
+    }));
+
+    results.push_back(run("format_mixed", iters, [&]() {
+        return jumper::format(mixed, 12345, 3.14159, sym, user).size();
+    }));
+
+    FastUser fastUser(7, "Jumper");
+    results.push_back(run("format_mixed_formatter", iters, [&]() {
+        return jumper::format(mixed, 12345, 3.14159, sym, fastUser).size();
+    }));
+
+    std::vector<int> batch { 101, 102, 103, 104, 105, 106, 107, 108 };
+    results.push_back(run("format_vector", iters, [&]() {
+        return jumper::format("batch={}", batch).size();
+    }));
+
+    results.push_back(run("snprintf_ints", iters, [&]() {
+        char buf[128];
+        return static_cast<std::size_t>(std::snprintf(buf, sizeof(buf),
+            "loop index: %d, a = %d, b = %d", 1, 2, 3));
+    }));
+
+    results.push_back(run("ostringstream_ints", iters, [&]() {
+        std::ostringstream oss;
+        oss << "loop index: " << 1 << ", a = " << 2 << ", b = " << 3;
+        return oss.str().size();
+    }));
+
+    results.push_back(run("ostringstream_mixed", iters, [&]() {
+        std::ostringstream oss;
+        oss << "id=" << 12345 << " price=" << 3.14159 << " sym=" << sym << " user=" << user;
+        return oss.str().size();
+    }));
+
+    // 清理不可信的字符串：干净的ASCII与memcpy对比，以及含中文和控制字符的输入
+    std::string cleanText(4096, 'a');
+    for (std::size_t i = 0; i < cleanText.size(); i += 7)
+    {
+        cleanText[i] = ' ';
+    }
+    std::string copied;
+    results.push_back(run("memcpy_4k", iters, [&]() {
+        copied.assign(cleanText);
+        return copied.size();
+    }));
+
+    results.push_back(run("sanitize_clean_4k", iters, [&]() {
+        copied.clear();
+        jumper::sanitize_to(copied, cleanText.data(), cleanText.size());
+        return copied.size();
+    }));
+
+    std::string mixedText;
+    while (mixedText.size() < 4096)
+    {
+        mixedText += "user=\xe4\xb8\xad\xe6\x96\x87 id=42\tok\n";
+    }
+    results.push_back(run("sanitize_mixed_4k", iters, [&]() {
+        copied.clear();
+        jumper::sanitize_to(copied, mixedText.data(), mixedText.size());
+        return copied.size();
+    }));
+
+    results.push_back(run("format_sanitized", iters, [&]() {
+        return jumper::format_sanitized(mixed, 12345, 3.14159, sym, fastUser).size();
+    }));
+
+    // 二进制数据：逐字节snprintf拼接与hex()/hexdump()对比
+    std::vector<unsigned char> payload(4096);
+    for (std::size_t i = 0; i != payload.size(); ++i)
+    {
+        payload[i] = static_cast<unsigned char>(i * 131);
+    }
+    results.push_back(run("hex_bytewise_4k", iters / 100 + 1, [&]() {
+        std::string out;
+        char digits[4];
+        for (auto byte: payload)
+        {
+            std::snprintf(digits, sizeof(digits), "%02x ", byte);
+            out += digits;
+        }
+        return out.size();
+    }));
+
+    results.push_back(run("hex_4k", iters, [&]() {
+        return jumper::format("{}", jumper::hex(payload)).size();
+    }));
+
+    results.push_back(run("hexdump_4k", iters / 10 + 1, [&]() {
+        return jumper::format("{}", jumper::hexdump(payload)).size();
+    }));
+
+    // 压缩log文件的数据块：带时间戳的典型log行
+    // 格式说明不会被解释，秒和毫秒预先补零，保证时间戳是定宽的"12:00:01.002"
+    std::string block;
+    char stamp[16];
+    for (int i = 0; block.size() < jumper::kLzBlockSize; ++i)
+    {
+        std::snprintf(stamp, sizeof(stamp), "%02d.%03d", i / 100 % 60, i % 1000);
+        block += jumper::format("2024-05-01 12:00:{} [INFO] 4711 order {} filled {} @ {}\n",
+            stamp, 100000 + i, i % 50 * 100, 3.25 + i % 13 * 0.25);
+    }
+    block.resize(jumper::kLzBlockSize);
+    std::string packed;
+    results.push_back(run("lz_encode_64k", iters / 1000 + 1, [&]() {
+        packed.clear();
+        jumper::lz_encode_block(block.data(), block.size(), packed);
+        return packed.size();
+    }));
+
+    std::string unpacked;
+    results.push_back(run("lz_decode_64k", iters / 1000 + 1, [&]() {
+        std::size_t consumed = 0;
+        unpacked.clear();
+        jumper::lz_decode_block(packed.data(), packed.size(), unpacked, consumed);
+        return unpacked.size();
+    }));
+
+    // 批量格式化10万行，对比单线程与多线程
+    std::vector<std::tuple<int, std::string, double>> rows;
+    for (int i = 0; i != 100000; ++i)
+    {
+        rows.emplace_back(i, sym, i * 0.5);
+    }
+    Fmt rowFmt("id={} sym={} px={}\n");
+    unsigned cores = std::max(2u, std::thread::hardware_concurrency());
+    for (auto threads: { 1u, cores })
+    {
+        results.push_back(run("format_bulk_100k_" + std::to_string(threads) + "t",
+            iters / 20000 + 1, [&, threads]() {
+                jumper::BulkResult out;
+                jumper::format_bulk(rowFmt, rows, out, threads);
+                return out.data.size();
+            }));
+    }
+
+    // 100万个元素的容器：完整格式化为字符串与分段输出到FmtSink对比
+    std::vector<int> huge(1 << 20, 12345);
+    results.push_back(run("format_1m", iters / 20000 + 1, [&]() {
+        return jumper::format("{}", huge).size();
+    }));
+
+    results.push_back(run("format_to_sink_1m", iters / 20000 + 1, [&]() {
+        CountingSink sink;
+        jumper::format_to_sink(sink, "{}", huge);
+        return sink.m_bytes;
+    }));
+
+    // 输出到/dev/null，对比直接写FILE*与std::fprintf
+    std::FILE* devNull = std::fopen("/dev/null", "w");
+    if (devNull)
+    {
+        results.push_back(run("println_file", iters, [&]() {
+            return static_cast<std::size_t>(jumper::println(devNull, fmt, 1, 2, 3));
+        }));
+
+        results.push_back(run("fprintf_file", iters, [&]() {
+            return static_cast<std::size_t>(std::fprintf(devNull,
+                "loop index: %d, a = %d, b = %d\n", 1, 2, 3));
+        }));
+        std::fclose(devNull);
+    }
+
+    if (json)
+    {
+        print_json(results);
+    }
+    else
+    {
+        print_csv(results);
+    }
+
+    return s_sink == 0 ? 1 : 0;
+}
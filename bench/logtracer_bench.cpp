@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logtracer.h"
+
+using jumper::LogConfig;
+using jumper::LogLevel;
+using jumper::LogTracer;
+
+namespace {
+
+/**
+  * @brief HDR方式的延迟直方图：小于128ns的值精确记录，之后每个2的幂区间分为64个桶，
+  *        相对误差不超过1/64，记录只是一次数组自增
+*/
+class Histogram {
+public:
+    // 每个2的幂区间的桶数（2^kSubBits）
+    static const int kSubBits = 6;
+    // 最多记录到2^40ns（约18分钟）
+    static const int kMaxBits = 40;
+    static const std::size_t kBucketCount = (kMaxBits - kSubBits + 1) << kSubBits;
+
+    Histogram()
+        : m_counts(kBucketCount, 0) {}
+
+    inline void record(std::uint64_t ns)
+    {
+        ++m_counts[index(ns)];
+        ++m_total;
+        m_max = std::max(m_max, ns);
+    }
+
+    void merge(const Histogram& other)
+    {
+        for (std::size_t i = 0; i != kBucketCount; ++i)
+        {
+            m_counts[i] += other.m_counts[i];
+        }
+        m_total += other.m_total;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    // 第q分位数（0 < q <= 1）所在桶的上界，不超过实际的最大值
+    std::uint64_t percentile(double q) const
+    {
+        auto rank = static_cast<std::uint64_t>(q * m_total + 0.5);
+        std::uint64_t seen = 0;
+
+        rank = std::max<std::uint64_t>(rank, 1);
+        for (std::size_t i = 0; i != kBucketCount; ++i)
+        {
+            seen += m_counts[i];
+            if (seen >= rank)
+            {
+                return std::min(upper(i), m_max);
+            }
+        }
+
+        return m_max;
+    }
+
+    inline std::uint64_t max() const
+    {
+        return m_max;
+    }
+
+private:
+    static inline std::size_t index(std::uint64_t ns)
+    {
+        const std::uint64_t limit = (std::uint64_t(1) << kMaxBits) - 1;
+        ns = std::min(ns, limit);
+        if (ns < (2u << kSubBits))
+        {
+            return static_cast<std::size_t>(ns);
+        }
+
+        // 最高位之后保留kSubBits位
+        int shift = 63 - __builtin_clzll(ns) - kSubBits;
+
+        return (static_cast<std::size_t>(shift) << kSubBits) + static_cast<std::size_t>(ns >> shift);
+    }
+
+    static inline std::uint64_t upper(std::size_t i)
+    {
+        if (i < (2u << kSubBits))
+        {
+            return i;
+        }
+
+        auto shift = (i >> kSubBits) - 1;
+        auto mantissa = i - (shift << kSubBits);
+
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total = 0;
+    std::uint64_t m_max = 0;
+};
+
+// 一组测试参数
+struct Case {
+    std::string output;
+    unsigned threads;
+    std::size_t size;
+    std::string mix;
+};
+
+// 命令行参数
+struct Options {
+    std::vector<unsigned> threads { 1, 4, 16, 64 };
+    std::vector<std::size_t> sizes { 32, 256, 4096 };
+    std::vector<std::string> mixes { "info", "mixed" };
+    std::vector<std::string> outputs { "null", "file" };
+    std::string mode = "buffered";
+    std::string path = "./logtracer_bench.log";
+    std::string layout;
+    std::string profile = "off";
+    std::size_t records = 200000;
+};
+
+// 按逗号分割参数
+std::vector<std::string> split(const std::string& value)
+{
+    std::vector<std::string> items;
+    std::size_t begin = 0;
+
+    while (begin <= value.size())
+    {
+        auto end = std::min(value.find(',', begin), value.size());
+        if (end > begin)
+        {
+            items.push_back(value.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+
+    return items;
+}
+
+// 生成每次调用的级别：info全部为INFO；mixed为60% DEBUG（被过滤）、30% INFO、8% WARNING、2% ERROR
+std::vector<LogLevel> make_levels(const std::string& mix, std::size_t count, unsigned seed)
+{
+    std::vector<LogLevel> levels(count, jumper::LV_INFO);
+    std::mt19937 rng(seed);
+
+    if ("mixed" == mix)
+    {
+        for (auto& lv: levels)
+        {
+            auto r = rng() % 100;
+            lv = (r < 60) ? jumper::LV_DEBUG : (r < 90) ? jumper::LV_INFO
+                : (r < 98) ? jumper::LV_WARNING : jumper::LV_ERROR;
+        }
+    }
+
+    return levels;
+}
+
+// 按级别输出一条log，内容为序号加上payload
+inline void log_one(LogLevel lv, std::size_t seq, const std::string& payload)
+{
+    switch (lv)
+    {
+    case jumper::LV_DEBUG:
+        LogTracer::LoglnDebug("seq={} {}", seq, payload);
+        break;
+    case jumper::LV_INFO:
+        LogTracer::LoglnInfo("seq={} {}", seq, payload);
+        break;
+    case jumper::LV_WARNING:
+        LogTracer::LoglnWarning("seq={} {}", seq, payload);
+        break;
+    default:
+        LogTracer::LoglnError("seq={} {}", seq, payload);
+        break;
+    }
+}
+
+// 应用一组测试的输出配置，null为关闭终端且不写文件，只剩格式化和加锁的开销
+bool apply_output(const Options& options, const std::string& output)
+{
+    std::string text("level = INFO\nconsole = off\nprofile = " + options.profile + "\n");
+    if ("file" == output)
+    {
+        text += "file.path = " + options.path + "\nfile.mode = " + options.mode + "\n";
+    }
+    if (!options.layout.empty())
+    {
+        text += "layout = " + options.layout + "\n";
+    }
+
+    LogConfig config;
+    std::string error;
+    if (!config.Parse(text, error))
+    {
+        std::fprintf(stderr, "logtracer_bench: bad config: %s\n", error.c_str());
+        return false;
+    }
+    LogTracer::ApplyConfig(config);
+
+    return true;
+}
+
+// 运行一组测试，所有线程就绪后同时开始，每次调用的耗时记入直方图
+void run(const Options& options, const Case& c)
+{
+    auto perThread = std::max<std::size_t>(options.records / c.threads, 1);
+    std::string payload(c.size, 'x');
+    std::vector<Histogram> histograms(c.threads);
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> ready { 0 };
+    std::atomic<bool> go { false };
+
+    for (unsigned t = 0; t != c.threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            auto levels = make_levels(c.mix, perThread, t + 1);
+            auto& histogram = histograms[t];
+
+            // 预热：填充线程内的缓冲区
+            for (std::size_t i = 0; i != std::min<std::size_t>(perThread / 10 + 1, 1000); ++i)
+            {
+                log_one(levels[i], i, payload);
+            }
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            for (std::size_t i = 0; i != perThread; ++i)
+            {
+                auto begin = std::chrono::steady_clock::now();
+                log_one(levels[i], i, payload);
+                auto end = std::chrono::steady_clock::now();
+                histogram.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()));
+            }
+        });
+    }
+
+    while (ready.load() != c.threads)
+    {
+        std::this_thread::yield();
+    }
+    auto begin = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    Histogram total;
+    for (const auto& histogram: histograms)
+    {
+        total.merge(histogram);
+    }
+    auto calls = perThread * c.threads;
+
+    std::printf("%s,%u,%zu,%s,%zu,%.0f,%llu,%llu,%llu,%llu\n", c.output.c_str(), c.threads, c.size,
+        c.mix.c_str(), calls, calls / seconds,
+        static_cast<unsigned long long>(total.percentile(0.5)),
+        static_cast<unsigned long long>(total.percentile(0.99)),
+        static_cast<unsigned long long>(total.percentile(0.999)),
+        static_cast<unsigned long long>(total.max()));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+/// 用法：logtracer_bench [--threads 1,4,16,64] [--sizes 32,256,4096] [--mix info,mixed]
+///                       [--output null,file] [--mode buffered] [--path FILE] [--layout PATTERN]
+///                       [--profile on|off] [--records N]
+/// 每组参数输出一行CSV：总吞吐(records/s)以及单次调用延迟的p50、p99、p99.9和最大值(ns)
+/// records为每组测试所有线程的总调用次数，mixed中的DEBUG调用被过滤，也计入调用次数和延迟
+int main(int argc, char *argv[])
+{
+    Options options;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string key(argv[i]);
+        std::string value(argv[i + 1]);
+
+        if ("--threads" == key || "--sizes" == key)
+        {
+            auto items = split(value);
+            if ("--threads" == key)
+            {
+                options.threads.clear();
+            }
+            else
+            {
+                options.sizes.clear();
+            }
+            for (const auto& item: items)
+            {
+                auto n = std::strtoul(item.c_str(), nullptr, 10);
+                if ("--threads" == key)
+                {
+                    options.threads.push_back(std::max(1u, static_cast<unsigned>(n)));
+                }
+                else
+                {
+                    options.sizes.push_back(n);
+                }
+            }
+        }
+        else if ("--mix" == key)
+        {
+            options.mixes = split(value);
+        }
+        else if ("--output" == key)
+        {
+            options.outputs = split(value);
+        }
+        else if ("--mode" == key)
+        {
+            options.mode = value;
+        }
+        else if ("--path" == key)
+        {
+            options.path = value;
+        }
+        else if ("--layout" == key)
+        {
+            options.layout = value;
+        }
+        else if ("--profile" == key)
+        {
+            options.profile = value;
+        }
+        else if ("--records" == key)
+        {
+            options.records = std::max<std::size_t>(std::strtoul(value.c_str(), nullptr, 10), 1);
+        }
+        else
+        {
+            std::fprintf(stderr, "logtracer_bench: unknown option %s\n", key.c_str());
+            return 1;
+        }
+    }
+
+    for (const auto& output: options.outputs)
+    {
+        if ("null" != output && "file" != output)
+        {
+            std::fprintf(stderr, "logtracer_bench: unknown output %s\n", output.c_str());
+            return 1;
+        }
+    }
+    for (const auto& mix: options.mixes)
+    {
+        if ("info" != mix && "mixed" != mix)
+        {
+            std::fprintf(stderr, "logtracer_bench: unknown mix %s\n", mix.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("output,threads,msg_size,mix,calls,records_per_s,p50_ns,p99_ns,p99_9_ns,max_ns\n");
+    for (const auto& output: options.outputs)
+    {
+        for (auto threads: options.threads)
+        {
+            for (auto size: options.sizes)
+            {
+                for (const auto& mix: options.mixes)
+                {
+                    // 每组测试从空文件开始：先切换到不写文件的配置，删除后重新打开
+                    if (!apply_output(options, "null"))
+                    {
+                        return 1;
+                    }
+                    std::remove(options.path.c_str());
+                    if (!apply_output(options, output))
+                    {
+                        return 1;
+                    }
+                    run(options, { output, threads, size, mix });
+                }
+            }
+        }
+    }
+
+    LogTracer::FinalTracer();
+    std::remove(options.path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace jumper {
+
+/**
+  * @brief 崩溃飞行记录器，每个线程在内存中保留最近N条log记录（包括低于当前log级别的记录）
+  * @note 收到SIGSEGV、SIGABRT、SIGBUS时，信号处理函数直接使用write()将所有线程的记录转储到文件
+  * @note 每个线程的环形缓冲区只在首次记录时分配一次，之后记录log不会再分配内存，也不加锁
+  * @note 单条记录超过kSlotSize的部分会被截断
+*/
+class FlightRecorder {
+public:
+    /// 单条记录的最大字节数（包含log头部）
+    static const std::size_t kSlotSize = 256;
+
+    /// 开启飞行记录器，设置转储文件路径以及每个线程保留的记录条数，并安装致命信号处理函数
+    /// 记录条数只在第一次开启时生效，转储路径超过内部缓冲长度时返回false
+    static bool Enable(const std::string& dumpPath = "./logtracer.crash",
+        std::size_t capacity = 256);
+
+    /// 关闭飞行记录器并恢复原有的信号处理函数，已记录的内容仍然保留
+    static void Disable();
+
+    /// 飞行记录器是否开启
+    inline static bool IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// 向当前线程的环形缓冲区追加一条记录，header和body会被拼接为一条记录
+    static void Record(const std::string& header, const std::string& body);
+
+    /// 将所有线程的记录按从旧到新的顺序写入fd，异步信号安全
+    static void Dump(int fd);
+
+private:
+    // 致命信号处理函数
+    static void on_signal(int sig);
+
+    // 是否开启
+    static std::atomic<bool> s_enabled;
+};
+
+} // namespace jumper
+
+#endif // FLIGHTRECORDER_H
@@ -1,10 +1,14 @@
 #ifndef FMT_H
 #define FMT_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <deque>
 #include <stack>
+#include <vector>
 
 // Debug宏开关，默认关闭
 #ifndef JDEBUG
@@ -19,6 +23,7 @@ namespace jumper {
 using std::string;
 using std::deque;
 using std::stack;
+using std::vector;
 using std::pair;
 
 #ifdef JDEBUG
@@ -34,6 +39,7 @@ using StrPos = string::size_type;
   * @brief Fmt创建格式化字符串所需的格式，以"{}"包含每个需要格式化的参数
   * @note 转义'{'请使用"{{"，转义'}'请使用"}}"，最终不会被格式化，而是输出一个'{'或者'}'
   * @note Fmt对象不允许拷贝，只能移动，请使用移动语义(std::move(fmt))
+  * @note 使用+、+=追加格式时只解析新增的部分，结果与直接解析拼接后的完整格式串相同
 */
 class Fmt {
 public:
@@ -41,13 +47,19 @@ public:
 
     /// 接受一个string对象作为格式构造Fmt，不允许隐式类型转换
     explicit Fmt(const string& fmt)
-        : m_fmt(fmt), m_buf(fmt.length(), '\0')
     {
-        dispose();
+        reset(fmt.length());
+        append(fmt.data(), fmt.length());
     }
 
-    /// 接受一个C字符串作为格式构造Fmt（委托构造）
-    explicit Fmt(const char* fmt) : Fmt(string(fmt)) {}
+    /// 接受一个C字符串作为格式构造Fmt
+    explicit Fmt(const char* fmt)
+    {
+        auto len = ::strlen(fmt);
+
+        reset(len);
+        append(fmt, len);
+    }
 
     // Fmt对象不允许拷贝
     Fmt(const Fmt&) = delete;
@@ -55,23 +67,18 @@ public:
 
     // Fmt对象可以移动
     Fmt(Fmt&& fmt) noexcept : m_status(fmt.m_status),
-        m_fmt(std::move(fmt.m_fmt)), m_buf(std::move(fmt.m_buf)),
-        m_subStrDeque(std::move(fmt.m_subStrDeque))
+        m_fmt(std::move(fmt.m_fmt)),
+        m_subStrDeque(std::move(fmt.m_subStrDeque)),
+        m_specs(std::move(fmt.m_specs)),
+        m_state(std::move(fmt.m_state))
     {
-        fmt.m_status = false;
-        fmt.m_buf.clear();
-        fmt.m_fmt.clear();
-        fmt.m_subStrDeque.clear();
+        fmt.clear();
     }
 
     Fmt& operator=(Fmt&& fmt) noexcept
     {
         std::move(fmt).swap(*this);
-
-        fmt.m_status = false;
-        fmt.m_buf.clear();
-        fmt.m_fmt.clear();
-        fmt.m_subStrDeque.clear();
+        fmt.clear();
 
         return *this;
     }
@@ -79,34 +86,34 @@ public:
     // Fmt对象支持使用+追加格式
     Fmt& operator+(const Fmt& fmt)
     {
-        return *this + fmt.m_fmt;
+        return *this + fmt.to_str();
     }
 
     // Fmt对象支持使用+=追加格式
     Fmt& operator+=(const Fmt& fmt)
     {
-        return *this + fmt.m_fmt;
+        return *this + fmt.to_str();
     }
 
     
     // Fmt对象支持使用+追加格式
     Fmt& operator+(const char* fmt)
     {
-        return *this + string(fmt);
+        append(fmt, ::strlen(fmt));
+
+        return *this;
     }
 
     // Fmt对象支持使用+=追加格式
     Fmt& operator+=(const char* fmt)
     {
-        return *this + string(fmt);
+        return *this + fmt;
     }
 
     // Fmt对象支持使用+追加格式
     Fmt& operator+(const std::string& fmt)
     {
-        m_fmt += fmt;
-        m_buf.resize(m_fmt.length(), '\0');
-        dispose();
+        append(fmt.data(), fmt.length());
 
         return *this;
     }
@@ -114,35 +121,35 @@ public:
     // Fmt对象支持使用+=追加格式
     Fmt& operator+=(const std::string& fmt)
     {
-        m_fmt += fmt;
-        m_buf.resize(m_fmt.length(), '\0');
-        dispose();
-
-        return *this;
+        return *this + fmt;
     }
 
     /// 重新设置当前Fmt对象中的格式
     inline Fmt& set_fmt(string&& fmt)
     {
-        m_status = true;
-        m_fmt = std::move(fmt);
-        fmt.clear();
-        m_buf.resize(m_fmt.length(), '\0');
+        string str(std::move(fmt));
 
-        dispose();
+        fmt.clear();
+        reset(str.length());
+        append(str.data(), str.length());
 
         return *this;
     }
 
     inline Fmt& set_fmt(const char* fmt)
     {
-        return set_fmt(std::string(fmt));
+        auto len = ::strlen(fmt);
+
+        reset(len);
+        append(fmt, len);
+
+        return *this;
     }
 
     /// 获取Fmt对象中的格式，如果Fmt中的格式解析失败了，返回空串
     inline const string& to_str() const
     {
-        return m_fmt;
+        return m_status ? m_fmt : empty_str();
     }
 
     /// Fmt对象中的格式解析成功了，返回true，使用Fmt对象前请务必确认
@@ -155,16 +162,53 @@ public:
     /// 返回存放子串队列的不可变引用
     inline const deque<string>& subs() const
     {
-        return m_subStrDeque;
+        static const deque<string> s_empty;
+
+        return m_status ? m_subStrDeque : s_empty;
+    }
+
+    /// 第index个格式符"{}"中的内容（格式说明），例如"{x}"对应"x"，没有内容时返回空串
+    inline const string& spec(std::size_t index) const
+    {
+        return m_status && index < m_specs.size() ? m_specs[index] : empty_str();
     }
 
     // 调试使用，Fmt对象中格式解析失败时，buf中会保存成功的部分串
     inline const string& buf() const
     {
-        return m_buf;
+        return m_status ? empty_str() : m_fmt;
     }
     
 private:
+    // 追加解析时需要保留的状态
+    struct ParseState {
+        // 待配对的'{'在格式串中的位置
+        vector<StrPos> lPosBrackets;
+        // 所有配对成功的'{'和'}'的位置，按配对顺序保存
+        vector<pair<StrPos, StrPos>> brackets;
+        // 尾串在格式串中的起始位置，以及已经复制到尾串中的末尾位置
+        StrPos tailPos = 0;
+        StrPos tailEnd = 0;
+        // 格式串末尾的'{'或'}'，其含义取决于下一个字符（是否构成转义）
+        char pending = '\0';
+        // 出现了无法恢复的错误（多余的'}'）
+        bool error = false;
+        // 出现了嵌套的格式符，之后每次都根据brackets重新切割
+        bool nested = false;
+        // 末尾的'}'被暂时视为配对成功，若追加的内容以'}'开头则需要撤销
+        bool tentative = false;
+        // 撤销暂时配对时需要恢复的尾串起始位置和格式说明数量
+        StrPos undoTailPos = 0;
+        std::size_t undoSpecs = 0;
+    };
+
+    static const string& empty_str()
+    {
+        static const string s_empty;
+
+        return s_empty;
+    }
+
     // 交换两个Fmt对象
     inline void swap(Fmt& fmt)
     {
@@ -172,123 +216,504 @@ private:
 
         swap(this->m_status, fmt.m_status);
         swap(this->m_fmt, fmt.m_fmt);
-        swap(this->m_buf, fmt.m_buf);
         swap(this->m_subStrDeque, fmt.m_subStrDeque);
+        swap(this->m_specs, fmt.m_specs);
+        swap(this->m_state, fmt.m_state);
+    }
+
+    // 被移动后的状态，之后追加的格式将重新开始解析
+    inline void clear()
+    {
+        m_status = false;
+        m_fmt.clear();
+        m_subStrDeque.clear();
+        m_specs.clear();
+        m_state = ParseState();
+    }
+
+    // 重新开始解析，len为预计的格式串长度
+    inline void reset(std::size_t len)
+    {
+        clear();
+        m_status = true;
+        m_fmt.reserve(len);
+        m_subStrDeque.emplace_back();
     }
 
-    // 在构造Fmt对象和重新设置格式时自动调用. 解析Fmt中的格式，失败会设置status为false
     // 解析规则："{{"和"}}"被视为转义，在格式串中对应一个'{'或者'}';
     // '{'和'}'必须配对，一个'{'必须对应一个'}'，且'}'不能出现在'{'左侧;
     // 从所有解析的'{'和'}'处，将整个格式串切割成数个子串保存;
-    // 一对成功配对的'{'和'}'之间的内容也会被保留，并被切割为一个子串存储.
-    void dispose()
+    // 一对成功配对的'{'和'}'之间的内容也会被保留，作为格式说明保存.
+    // 追加len个字符并只解析这部分，格式串末尾的'{'和'}'要等到下一个字符才能确定含义
+    void append(const char* data, std::size_t len)
     {
-        m_status = true;
-        m_buf.clear();
-        m_subStrDeque.clear();
+        auto& st = m_state;
 
-        // 没有格式符，不需要格式化
-        if (string::npos == m_fmt.find('{') && string::npos == m_fmt.find('}'))
+        if (st.error || 0 == len)
         {
-            m_subStrDeque.emplace_back(m_fmt);
-
             return;
         }
+        // 追加自身的内容（例如f += f）时先复制，m_fmt增长时可能重新分配内存
+        if (data >= m_fmt.data() && data < m_fmt.data() + m_fmt.size())
+        {
+            const string copy(data, len);
+            append(copy.data(), copy.size());
+            return;
+        }
+        if (m_subStrDeque.empty())
+        {
+            m_subStrDeque.emplace_back();
+        }
 
-        StrPos lastPos = 0;
-        stack<StrPos> lPosBrackets;
-        deque<pair<StrPos, StrPos>> brackets;
-        // 逐字符遍历
-        for (auto iter = m_fmt.cbegin(); iter != m_fmt.cend(); ++iter)
+        std::size_t i = 0;
+        if ('{' == st.pending)
         {
-            ++lastPos;
-            m_buf.push_back(*iter);
-            if ('{' == *iter)
+            st.pending = '\0';
+            if ('{' == data[0])
             {
-                // 格式串末尾出现'{'，肯定无法配对
-                if (m_fmt.cend() == iter + 1)
+                // 连续两个'{'，作为转义输出，不参与配对
+                i = 1;
+            }
+            else
+            {
+                st.lPosBrackets.push_back(m_fmt.length() - 1);
+            }
+        }
+        else if ('}' == st.pending)
+        {
+            st.pending = '\0';
+            if ('}' == data[0])
+            {
+                // 连续两个'}'，作为转义输出，撤销上次的暂时配对
+                if (st.tentative)
                 {
-#ifdef JDEBUG
-                    cerr << "[fmt]Error: no matched '}" << endl;
-#endif // JDEBUG
-                    m_status = false;
+                    undo_close();
+                }
+                i = 1;
+            }
+            else if (!st.tentative)
+            {
+                // 没有'{'待匹配，多余的'}'，匹配失败
+                set_error("no matched '{");
+                return;
+            }
+        }
+        st.tentative = false;
+
+        // 逐字符遍历新增部分
+        for (; i != len; ++i)
+        {
+            m_fmt.push_back(data[i]);
+            if ('{' == data[i])
+            {
+                if (len == i + 1)
+                {
+                    st.pending = '{';
                     break;
                 }
-                if ('{' == *(iter + 1))
+                if ('{' == data[i + 1])
                 {
                     // 如果连续两个'{'，则此'{'作为转义输出，不参与配对
-                    ++iter;
+                    ++i;
                     continue;
                 }
 
                 // 待配对的'{'
-                lPosBrackets.push(lastPos - 1);
+                st.lPosBrackets.push_back(m_fmt.length() - 1);
             }
-
-            if ('}' == *iter)
+            else if ('}' == data[i])
             {
+                if (len == i + 1)
+                {
+                    st.pending = '}';
+                    break;
+                }
                 // 连续两个'}'，则此'}'作为转义输出，不参与配对
-                if (m_fmt.cend() != iter + 1 && '}' == *(iter + 1))
+                if ('}' == data[i + 1])
                 {
-                    ++iter;
+                    ++i;
                     continue;
                 }
                 // 没有'{'待匹配，多余的'}'，匹配失败
-                if (lPosBrackets.empty())
+                if (st.lPosBrackets.empty())
                 {
-#ifdef JDEBUG
-                    cerr << "[fmt]Error: no matched '{" << endl;
-#endif // JDEBUG
-                    m_status = false;
-                    break;
+                    set_error("no matched '{");
+                    return;
                 }
 
-                // 匹配成功，将'{'和'}'的pos保存
-                brackets.emplace_back(lPosBrackets.top(), lastPos - 1);
-                lPosBrackets.pop();
+                close(m_fmt.length() - 1);
             }
         }
 
-        // 还有待匹配的'{'，多余的'{'，匹配失败
-        if (!lPosBrackets.empty())
+        finish();
+    }
+
+    // 匹配成功，将'{'和'}'的pos保存，并从'{'处切割出一个子串
+    void close(StrPos rPos)
+    {
+        auto& st = m_state;
+        StrPos lPos = st.lPosBrackets.back();
+
+        st.lPosBrackets.pop_back();
+        st.brackets.emplace_back(lPos, rPos);
+        // '{'位于上一个子串的起始位置左侧，只能在结束时整体重新切割
+        if (lPos < st.tailPos)
+        {
+            st.nested = true;
+        }
+        if (st.nested)
+        {
+            return;
+        }
+
+        auto& tail = m_subStrDeque.back();
+        if (lPos >= st.tailEnd)
+        {
+            tail.append(m_fmt, st.tailEnd, lPos - st.tailEnd);
+        }
+        else
+        {
+            tail.resize(lPos - st.tailPos);
+        }
+
+        // 保存格式符中的内容，全部为空时不占用内存
+        if (rPos > lPos + 1)
         {
+            m_specs.resize(m_subStrDeque.size());
+            m_specs.back().assign(m_fmt, lPos + 1, rPos - lPos - 1);
+        }
+
+        m_subStrDeque.emplace_back();
+        st.tailPos = st.tailEnd = rPos + 1;
+    }
+
+    // 撤销末尾'}'的暂时配对
+    void undo_close()
+    {
+        auto& st = m_state;
+        StrPos lPos = st.brackets.back().first;
+
+        st.brackets.pop_back();
+        st.lPosBrackets.push_back(lPos);
+        st.tentative = false;
+        if (st.nested)
+        {
+            return;
+        }
+
+        m_subStrDeque.pop_back();
+        if (m_specs.size() > st.undoSpecs)
+        {
+            m_specs.resize(st.undoSpecs);
+        }
+        st.tailPos = st.undoTailPos;
+        st.tailEnd = lPos;
+    }
+
+    // 当前追加的内容解析完毕，按照格式串在此结束来确定解析结果
+    void finish()
+    {
+        auto& st = m_state;
+
+        // 格式串末尾的'}'，如果有待配对的'{'则暂时视为配对成功
+        if ('}' == st.pending && !st.lPosBrackets.empty())
+        {
+            st.undoTailPos = st.tailPos;
+            st.undoSpecs = m_specs.size();
+            close(m_fmt.length() - 1);
+            st.tentative = true;
+        }
+
+        // 末尾的'{'、没有配对的'}'以及还有待匹配的'{'，都会导致匹配失败
+        m_status = ('\0' == st.pending || st.tentative) && st.lPosBrackets.empty();
 #ifdef JDEBUG
+        if (!m_status)
+        {
             cerr << "[fmt]Error: no enough matched '}" << endl;
+        }
 #endif // JDEBUG
-            m_status = false;
+
+        if (st.nested)
+        {
+            split();
         }
+        else
+        {
+            m_subStrDeque.back().append(m_fmt, st.tailEnd, string::npos);
+            st.tailEnd = m_fmt.length();
+        }
+    }
 
-        // 匹配成功，按格式规则切割，保存子串
-        if (m_status)
+    // 出现嵌套的格式符时，按照所有配对位置重新切割整个格式串
+    void split()
+    {
+        StrPos pos = 0;
+
+        m_subStrDeque.clear();
+        m_specs.clear();
+        for (auto &splitPos: m_state.brackets)
         {
-            m_fmt = std::move(m_buf);
-            m_buf.clear();
+            string subStr(m_fmt, pos, splitPos.first - pos);
 
-            StrPos pos = 0;
-            for (auto &splitPos: brackets)
-            {
-                string subStr(m_fmt, pos, splitPos.first - pos);
+            m_subStrDeque.emplace_back(std::move(subStr));
+            pos = splitPos.second + 1;
 
-                m_subStrDeque.emplace_back(std::move(subStr));
-                pos = splitPos.second + 1;
+            if (splitPos.second > splitPos.first + 1)
+            {
+                m_specs.resize(m_subStrDeque.size());
+                m_specs.back().assign(m_fmt, splitPos.first + 1,
+                    splitPos.second - splitPos.first - 1);
             }
-            m_subStrDeque.emplace_back(m_fmt.substr(pos));
-        }
-        else
-        {
-            // 匹配失败清空格式串
-            m_fmt.clear();
         }
+        m_subStrDeque.emplace_back(m_fmt.substr(pos));
+    }
+
+    // 无法恢复的错误，之后追加的格式都会被忽略
+    void set_error(const char* msg)
+    {
+#ifdef JDEBUG
+        cerr << "[fmt]Error: " << msg << endl;
+#else
+        (void)msg;
+#endif // JDEBUG
+        m_state.error = true;
+        m_status = false;
     }
 
     // 记录Fmt对象解析是否成功
     bool m_status = true;
-    // 存储格式字符串，匹配失败时清空
+    // 存储去除转义后的格式字符串，解析失败时通过buf()获取
     string m_fmt;
-    // 临时格式字符串，匹配成功时清空
-    string m_buf;
-    // 子串队列，按序尾插
+    // 子串队列，按序尾插，最后一个为尾串
     deque<string> m_subStrDeque;
+    // 格式符中的内容，下标与格式符顺序一致，末尾的空内容不保存
+    vector<string> m_specs;
+    // 追加解析时需要保留的状态
+    ParseState m_state;
+};
+
+/**
+  * @brief FmtView解析格式串，但不持有格式串，每个子串以偏移量的形式引用调用者的字符串
+  * @note 格式串必须在FmtView的整个生命周期内保持有效（例如字符串字面量或者静态存储的字符串）
+  * @note 解析规则与Fmt完全一致，转义符"{{"和"}}"将子串切分为多个片段，不需要额外复制格式串
+  * @note 适合长期缓存的大量格式，不会像Fmt一样保存格式串的多份副本
+*/
+class FmtView {
+public:
+    /// 子串片段，引用格式串中[off, off + len)的内容
+    struct Piece {
+        std::uint32_t off;
+        std::uint32_t len;
+        // 是否为当前子串的最后一个片段，其后是一个格式符（或者格式串结束）
+        bool last;
+    };
+
+    FmtView() = default;
+
+    /// 接受一个C字符串作为格式，格式串不会被复制
+    explicit FmtView(const char* fmt)
+        : FmtView(fmt, fmt ? ::strlen(fmt) : 0) {}
+
+    /// 接受格式串起始地址和长度
+    FmtView(const char* fmt, std::size_t len)
+    {
+        parse(fmt, len);
+    }
+
+    /// 接受一个string对象作为格式，string对象必须比FmtView存活得更久
+    explicit FmtView(const string& fmt)
+        : FmtView(fmt.data(), fmt.length()) {}
+
+    // 不允许引用临时string对象
+    explicit FmtView(string&&) = delete;
+
+    /// 格式串解析成功了，返回true，使用FmtView对象前请务必确认
+    inline bool is_ok() const
+    {
+        return m_status;
+    }
+
+    /// 子串的数量，等于格式符数量加1，解析失败时为0
+    inline std::size_t size() const
+    {
+        return m_segs;
+    }
+
+    /// 引用的格式串
+    inline const char* data() const
+    {
+        return m_data;
+    }
+
+    /// 所有子串片段，按序排列
+    inline const vector<Piece>& pieces() const
+    {
+        return m_pieces;
+    }
+
+    /// 第index个格式符"{}"中的内容（格式说明），没有内容时返回空串
+    inline const string& spec(std::size_t index) const
+    {
+        static const string s_empty;
+
+        return index < m_specs.size() ? m_specs[index] : s_empty;
+    }
+
+    /// 生成与Fmt::to_str()相同的格式串（去除转义），解析失败时返回空串
+    string to_str() const
+    {
+        string str;
+
+        str.reserve(m_status ? m_len : 0);
+        append_to(str);
+
+        return str;
+    }
+
+    /// 将to_str()的内容直接追加到out（提供append(const char*, size_t)的缓冲区），不构造临时字符串
+    template<typename Out>
+    void append_to(Out& out) const
+    {
+        if (!m_status)
+        {
+            return;
+        }
+
+        std::size_t pos = 0;
+        for (auto skip: m_skips)
+        {
+            out.append(m_data + pos, skip - pos);
+            pos = skip + 1;
+        }
+        out.append(m_data + pos, m_len - pos);
+    }
+
+private:
+    // 解析格式串，规则与Fmt::dispose()一致，所有位置均为原始格式串中的位置
+    void parse(const char* data, std::size_t len)
+    {
+        m_data = data;
+        m_len = len;
+        m_status = (data != nullptr || 0 == len) && len <= UINT32_MAX;
+        if (!m_status)
+        {
+            return;
+        }
+
+        // '}'的数量是配对数量的上限，预先分配避免逐个增长
+        auto closeCount = static_cast<std::size_t>(std::count(data, data + len, '}'));
+        vector<StrPos> lPosBrackets;
+        vector<pair<StrPos, StrPos>> brackets;
+        lPosBrackets.reserve(closeCount);
+        brackets.reserve(closeCount);
+        for (StrPos i = 0; i < len; ++i)
+        {
+            if ('{' == data[i])
+            {
+                // 格式串末尾出现'{'，肯定无法配对
+                if (i + 1 == len)
+                {
+                    m_status = false;
+                    break;
+                }
+                // 连续两个'{'，第二个'{'被跳过
+                if ('{' == data[i + 1])
+                {
+                    m_skips.push_back(++i);
+                    continue;
+                }
+                lPosBrackets.push_back(i);
+            }
+            else if ('}' == data[i])
+            {
+                // 连续两个'}'，第二个'}'被跳过
+                if (i + 1 != len && '}' == data[i + 1])
+                {
+                    m_skips.push_back(++i);
+                    continue;
+                }
+                // 没有'{'待匹配，多余的'}'，匹配失败
+                if (lPosBrackets.empty())
+                {
+                    m_status = false;
+                    break;
+                }
+                brackets.emplace_back(lPosBrackets.back(), i);
+                lPosBrackets.pop_back();
+            }
+        }
+
+        if (!lPosBrackets.empty())
+        {
+            m_status = false;
+        }
+        if (!m_status)
+        {
+            m_skips.clear();
+            return;
+        }
+
+        m_pieces.reserve(brackets.size() + 1 + m_skips.size());
+
+        // 按格式规则切割，与Fmt相同：'{'位于上一个'}'左侧（嵌套）时，子串一直延伸到格式串末尾
+        StrPos pos = 0;
+        for (auto &splitPos: brackets)
+        {
+            add_segment(pos, splitPos.first < pos ? len : splitPos.first);
+            if (splitPos.second > splitPos.first + 1)
+            {
+                m_specs.resize(m_segs);
+                m_specs.back() = unescape(splitPos.first + 1, splitPos.second);
+            }
+            pos = splitPos.second + 1;
+        }
+        add_segment(pos, len);
+    }
+
+    // 将原始格式串[begin, end)按被跳过的转义字符切分为片段，作为一个子串保存
+    void add_segment(StrPos begin, StrPos end)
+    {
+        auto skip = std::lower_bound(m_skips.cbegin(), m_skips.cend(), begin);
+        for (; skip != m_skips.cend() && *skip < end; ++skip)
+        {
+            m_pieces.push_back({ static_cast<std::uint32_t>(begin),
+                static_cast<std::uint32_t>(*skip - begin), false });
+            begin = *skip + 1;
+        }
+        m_pieces.push_back({ static_cast<std::uint32_t>(begin),
+            static_cast<std::uint32_t>(end - begin), true });
+        ++m_segs;
+    }
+
+    // 去除原始格式串[begin, end)中的转义字符
+    string unescape(StrPos begin, StrPos end) const
+    {
+        string str;
+        auto skip = std::lower_bound(m_skips.cbegin(), m_skips.cend(), begin);
+
+        for (; skip != m_skips.cend() && *skip < end; ++skip)
+        {
+            str.append(m_data + begin, *skip - begin);
+            begin = *skip + 1;
+        }
+        str.append(m_data + begin, end - begin);
+
+        return str;
+    }
+
+    // 记录解析是否成功
+    bool m_status = true;
+    // 引用的格式串及其长度
+    const char* m_data = "";
+    StrPos m_len = 0;
+    // 子串数量
+    std::size_t m_segs = 0;
+    // 所有子串片段
+    vector<Piece> m_pieces;
+    // 被跳过的转义字符在格式串中的位置，没有转义时不占用内存
+    vector<StrPos> m_skips;
+    // 格式符中的内容，全部为空时不占用内存
+    vector<string> m_specs;
 };
 
 /// 工具函数，测试当前Fmt对象是否解析成功
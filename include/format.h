@@ -1,80 +1,1032 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <sstream>
 #include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <cerrno>
+#include <unistd.h>
 
 #include "fmt.h"
+#include "sanitize.h"
 
 namespace jumper {
 
+/**
+  * @brief 流式格式化的输出目标，见format_to_sink和FmtBuffer::set_sink
+*/
+class FmtSink {
+public:
+    virtual ~FmtSink() = default;
+
+    /// 输出[data, data + len)，返回false表示输出失败，之后的内容不再输出
+    virtual bool flush(const char* data, std::size_t len) = 0;
+};
+
+/// format_to_sink使用的缓冲区大小
+const std::size_t kFmtSinkBufferSize = 8192;
+
+/**
+  * @brief 格式化输出缓冲区，format系列函数将结果直接追加到缓冲区中
+  * @note 内置类型、容器和元组的元素都直接写入缓冲区，不经过std::ostream
+  * @note 开启清理模式后，字符串和字符参数经过sanitize_to写入，格式串本身不受影响
+  * @note 设置了FmtSink时为流式输出：内容将超过上限时先输出到FmtSink，缓冲区的大小固定
+*/
+class FmtBuffer {
+public:
+    FmtBuffer() = default;
+
+    /// 追加len个字符
+    inline void append(const char* data, std::size_t len)
+    {
+        if (m_str.size() + len > m_limit)
+        {
+            spill(data, len);
+            return;
+        }
+        m_str.append(data, len);
+    }
+
+    inline void append(const std::string& str)
+    {
+        append(str.data(), str.size());
+    }
+
+    /// 追加一个字符
+    inline void push_back(char c)
+    {
+        if (m_str.size() >= m_limit)
+        {
+            spill(&c, 1);
+            return;
+        }
+        m_str.push_back(c);
+    }
+
+    /// 预留空间，流式输出时最多预留到上限
+    inline void reserve(std::size_t size)
+    {
+        m_str.reserve(std::min(size, m_limit));
+    }
+
+    /// 开启流式输出：缓冲区中的内容将超过limit字节时先输出到sink，sink为nullptr时关闭
+    /// 单次追加超过limit字节的内容（例如很长的字符串参数）直接输出到sink，不复制到缓冲区
+    inline void set_sink(FmtSink* sink, std::size_t limit)
+    {
+        m_sink = sink;
+        m_limit = sink ? std::max<std::size_t>(limit, 1) : std::numeric_limits<std::size_t>::max();
+        m_flushed = 0;
+        m_failed = false;
+    }
+
+    /// 流式输出时将缓冲区中的内容输出到sink，返回此前的输出是否都成功
+    inline bool flush();
+
+    /// 流式输出时已经输出到sink的字节数
+    inline std::size_t flushed() const
+    {
+        return m_flushed;
+    }
+
+    /// 开启或关闭字符串参数的清理模式，默认关闭
+    inline void set_sanitize(bool sanitize)
+    {
+        m_sanitize = sanitize;
+    }
+
+    /// 是否处于清理模式
+    inline bool sanitize() const
+    {
+        return m_sanitize;
+    }
+
+    /// 清空缓冲区，保留已分配的内存
+    inline void clear()
+    {
+        m_str.clear();
+    }
+
+    /// 当前缓冲区中的字符数
+    inline std::size_t size() const
+    {
+        return m_str.size();
+    }
+
+    /// 获取缓冲区中的内容
+    inline const std::string& str() const
+    {
+        return m_str;
+    }
+
+    /// 取出缓冲区中的内容，之后缓冲区为空
+    inline std::string release()
+    {
+        std::string str(std::move(m_str));
+        m_str.clear();
+
+        return str;
+    }
+
+private:
+    // 流式输出时缓冲区放不下，先输出已有的内容
+    inline void spill(const char* data, std::size_t len);
+
+    // 输出到sink，失败后丢弃之后的内容
+    inline void emit(const char* data, std::size_t len)
+    {
+        m_failed = m_failed || !m_sink->flush(data, len);
+        m_flushed += len;
+    }
+
+    // 格式化结果
+    std::string m_str;
+    // 字符串参数是否需要清理
+    bool m_sanitize = false;
+    // 流式输出的目标，nullptr表示不限大小的普通缓冲区
+    FmtSink* m_sink = nullptr;
+    // 缓冲区的上限，没有sink时为最大值，追加时只需一次比较
+    std::size_t m_limit = std::numeric_limits<std::size_t>::max();
+    // 已经输出到sink的字节数
+    std::size_t m_flushed = 0;
+    // sink是否输出失败
+    bool m_failed = false;
+};
+
+/// 流式输出时将缓冲区中的内容输出到sink，返回此前的输出是否都成功
+inline bool FmtBuffer::flush()
+{
+    if (m_sink && !m_str.empty())
+    {
+        emit(m_str.data(), m_str.size());
+        m_str.clear();
+    }
+
+    return !m_failed;
+}
+
+// 流式输出时缓冲区放不下，先输出已有的内容，超过上限的内容直接输出
+inline void FmtBuffer::spill(const char* data, std::size_t len)
+{
+    flush();
+    if (len >= m_limit)
+    {
+        emit(data, len);
+    }
+    else
+    {
+        m_str.append(data, len);
+    }
+}
+
+/**
+  * @brief 自定义类型的格式化扩展点，特化formatter<T>后，T的对象不经过std::ostream，直接写入缓冲区
+  * @note 特化需要提供成员函数：void format(FmtBuffer& buf, const T& t, const std::string& spec) const
+  * @note spec为格式符中的内容，例如"{x}"对应"x"，作为容器元素输出时为空串
+  * @note 同时存在formatter<T>特化和<<运算符时，优先使用formatter<T>
+*/
+template<typename T, typename Enable = void>
+struct formatter {};
+
+/**
+  * @brief 区间格式化适配器，由join()或者limit()构造，直接作为format的参数使用
+  * @note 只保存区间的迭代器，被引用的区间必须在格式化完成前保持有效
+*/
+template<typename It>
+class JoinView {
+public:
+    JoinView(It first, It last, const char* sep, const char* open,
+        const char* close, std::size_t maxItems, bool keyValue)
+        : m_first(first), m_last(last), m_sep(sep), m_open(open),
+        m_close(close), m_maxItems(maxItems), m_keyValue(keyValue) {}
+
+    It m_first;
+    It m_last;
+    // 元素分隔符
+    const char* m_sep;
+    // 区间的左右括号，join()为空串
+    const char* m_open;
+    const char* m_close;
+    // 最多输出的元素个数，0表示不限制，超出部分以"..."代替
+    std::size_t m_maxItems;
+    // 区间来自关联容器时，元素以"key: value"输出
+    bool m_keyValue;
+};
+
 // 内部命名空间 jumper_inner
 namespace jumper_inner {
+template<typename...>
+struct make_void { using type = void; };
+
+template<typename... Ts>
+using void_t = typename make_void<Ts...>::type;
+
+// 重载决议的优先级标签，数字越大优先级越高
+template<int N>
+struct rank: rank<N - 1> {};
+
+template<>
+struct rank<0> {};
+
+template<typename T>
+using decay_t = typename std::decay<T>::type;
+
+// 字符串类型：std::string、C字符串以及字符数组
+template<typename T>
+struct is_string_like: std::integral_constant<bool,
+    std::is_same<decay_t<T>, std::string>::value ||
+    std::is_same<decay_t<T>, char*>::value ||
+    std::is_same<decay_t<T>, const char*>::value> {};
+
+// 按字符输出的类型，与std::ostream行为一致
+template<typename T>
+struct is_char_like: std::integral_constant<bool,
+    std::is_same<T, char>::value ||
+    std::is_same<T, signed char>::value ||
+    std::is_same<T, unsigned char>::value> {};
+
+// 可以使用std::begin/std::end遍历的类型
+template<typename T, typename = void>
+struct is_range: std::false_type {};
+
 template<typename T>
-std::ostringstream& __format(std::ostringstream& oss,
-    std::deque<std::string>& subs, const T& t)
+struct is_range<T, void_t<decltype(std::begin(std::declval<const T&>())),
+    decltype(std::end(std::declval<const T&>()))>>: std::true_type {};
+
+// 关联容器（std::map、std::unordered_map等），元素以"key: value"输出
+template<typename T, typename = void>
+struct is_map_like: std::false_type {};
+
+template<typename T>
+struct is_map_like<T, void_t<typename T::key_type, typename T::mapped_type>>
+    : is_range<T> {};
+
+// 重载了<<运算符的类型
+template<typename T, typename = void>
+struct is_streamable: std::false_type {};
+
+template<typename T>
+struct is_streamable<T, void_t<decltype(std::declval<std::ostream&>()
+    << std::declval<const T&>())>>: std::true_type {};
+
+// 类型自己重载了<<运算符，优先于容器、pair和tuple的默认输出
+// 数组可以隐式转换为指针输出，不算重载了<<运算符
+template<typename T>
+struct has_own_stream: std::integral_constant<bool,
+    is_streamable<T>::value && !std::is_array<T>::value> {};
+
+// 特化了formatter<T>的类型
+template<typename T, typename = void>
+struct has_formatter: std::false_type {};
+
+template<typename T>
+struct has_formatter<T, void_t<decltype(std::declval<const formatter<T>&>().format(
+    std::declval<FmtBuffer&>(), std::declval<const T&>(),
+    std::declval<const std::string&>()))>>: std::true_type {};
+
+// 空的格式说明
+inline const std::string& empty_spec()
 {
-    if (subs.empty())
+    static const std::string s_empty;
+
+    return s_empty;
+}
+
+template<typename T>
+inline void write_value(FmtBuffer& buf, const T& t);
+
+// 整数转十进制字符串，从后往前写入
+template<typename U>
+inline char* write_digits(char* end, U value)
+{
+    do
     {
-        return oss;
+        *--end = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    return end;
+}
+
+template<typename T>
+inline void write_int(FmtBuffer& buf, T value)
+{
+    using U = typename std::make_unsigned<T>::type;
+    char digits[std::numeric_limits<U>::digits10 + 3];
+    char* end = digits + sizeof(digits);
+    char* begin;
+
+    if (value < 0)
+    {
+        begin = write_digits(end, static_cast<U>(U(0) - static_cast<U>(value)));
+        *--begin = '-';
+    }
+    else
+    {
+        begin = write_digits(end, static_cast<U>(value));
     }
 
-    oss << subs.front();
-    subs.pop_front();
+    buf.append(begin, static_cast<std::size_t>(end - begin));
+}
+
+// 浮点数使用"%g"格式，与std::ostream默认格式一致
+inline void write_float(FmtBuffer& buf, double value)
+{
+    char digits[32];
+    int len = std::snprintf(digits, sizeof(digits), "%g", value);
 
-    // 只剩尾串，忽略最后一个多余参数
-    if (subs.empty())
+    buf.append(digits, static_cast<std::size_t>(len));
+}
+
+inline void write_float(FmtBuffer& buf, long double value)
+{
+    char digits[64];
+    int len = std::snprintf(digits, sizeof(digits), "%Lg", value);
+
+    buf.append(digits, static_cast<std::size_t>(len));
+}
+
+inline void write_str(FmtBuffer& buf, const char* str, std::size_t len)
+{
+    if (buf.sanitize())
     {
-        return oss;
+        sanitize_to(buf, str, len);
     }
+    else
+    {
+        buf.append(str, len);
+    }
+}
 
-    oss << t;
+inline void write_str(FmtBuffer& buf, const std::string& str)
+{
+    write_str(buf, str.data(), str.size());
+}
 
-    for (auto& str: subs)
+inline void write_str(FmtBuffer& buf, const char* str)
+{
+    if (str)
     {
-        oss << str;
+        write_str(buf, str, ::strlen(str));
     }
+}
 
-    return oss;
+// 输出区间[first, last)，maxItems为0时不限制元素个数
+template<typename It>
+inline void write_range(FmtBuffer& buf, It first, It last, const char* sep,
+    std::size_t maxItems, bool keyValue);
+
+template<typename K, typename V>
+inline void write_key_value(FmtBuffer& buf, const std::pair<K, V>& kv)
+{
+    write_value(buf, kv.first);
+    buf.append(": ", 2);
+    write_value(buf, kv.second);
+}
+
+template<typename T>
+inline void write_element(FmtBuffer& buf, const T& t, bool)
+{
+    write_value(buf, t);
+}
+
+template<typename K, typename V>
+inline void write_element(FmtBuffer& buf, const std::pair<K, V>& kv, bool keyValue)
+{
+    if (keyValue)
+    {
+        write_key_value(buf, kv);
+    }
+    else
+    {
+        write_value(buf, kv);
+    }
+}
+
+template<typename It>
+inline void write_range(FmtBuffer& buf, It first, It last, const char* sep,
+    std::size_t maxItems, bool keyValue)
+{
+    std::size_t sepLen = ::strlen(sep);
+    std::size_t count = 0;
+
+    for (; first != last; ++first, ++count)
+    {
+        if (0 != count)
+        {
+            buf.append(sep, sepLen);
+        }
+        if (0 != maxItems && count == maxItems)
+        {
+            buf.append("...", 3);
+            break;
+        }
+        write_element(buf, *first, keyValue);
+    }
+}
+
+template<typename Tuple, std::size_t... Is>
+inline void write_tuple(FmtBuffer& buf, const Tuple& tup, std::index_sequence<Is...>)
+{
+    // 逐个输出元组元素，元素之间以", "分隔
+    using expander = int[];
+    (void)expander { 0, (buf.append(", ", Is == 0 ? 0 : 2),
+        write_value(buf, std::get<Is>(tup)), 0)... };
+}
+
+// 特化了formatter<T>的类型，优先级最高
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<8>)
+    -> typename std::enable_if<has_formatter<T>::value>::type
+{
+    formatter<T>().format(buf, t, empty_spec());
+}
+
+// 字符串
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<7>)
+    -> typename std::enable_if<is_string_like<T>::value>::type
+{
+    write_str(buf, t);
+}
+
+// 字符
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<6>)
+    -> typename std::enable_if<is_char_like<T>::value>::type
+{
+    auto c = static_cast<unsigned char>(t);
+
+    // 单个字节不可能是UTF-8多字节字符，清理模式下不是可打印ASCII字符时直接转义，与sanitize_to的结果相同
+    if (buf.sanitize() && !is_plain(c))
+    {
+        write_escape(buf, c);
+    }
+    else
+    {
+        buf.push_back(static_cast<char>(c));
+    }
+}
+
+// bool，与std::ostream默认行为一致输出1或0
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<5>)
+    -> typename std::enable_if<std::is_same<T, bool>::value>::type
+{
+    buf.push_back(t ? '1' : '0');
+}
+
+// 整数
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<4>)
+    -> typename std::enable_if<std::is_integral<T>::value>::type
+{
+    write_int(buf, t);
+}
+
+// 浮点数
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<4>)
+    -> typename std::enable_if<std::is_floating_point<T>::value>::type
+{
+    write_float(buf, t);
+}
+
+// 区间适配器
+template<typename It>
+inline void write_impl(FmtBuffer& buf, const JoinView<It>& view, rank<3>)
+{
+    write_str(buf, view.m_open);
+    write_range(buf, view.m_first, view.m_last, view.m_sep, view.m_maxItems,
+        view.m_keyValue);
+    write_str(buf, view.m_close);
+}
+
+// 关联容器，输出{k1: v1, k2: v2}
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<3>)
+    -> typename std::enable_if<is_map_like<T>::value && !has_own_stream<T>::value>::type
+{
+    buf.push_back('{');
+    write_range(buf, std::begin(t), std::end(t), ", ", 0, true);
+    buf.push_back('}');
+}
+
+// 序列容器和数组，输出[e1, e2, e3]
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<2>)
+    -> typename std::enable_if<is_range<T>::value && !has_own_stream<T>::value>::type
+{
+    buf.push_back('[');
+    write_range(buf, std::begin(t), std::end(t), ", ", 0, false);
+    buf.push_back(']');
+}
+
+// std::pair，输出(first, second)
+template<typename K, typename V>
+inline auto write_impl(FmtBuffer& buf, const std::pair<K, V>& p, rank<2>)
+    -> typename std::enable_if<!has_own_stream<std::pair<K, V>>::value>::type
+{
+    buf.push_back('(');
+    write_value(buf, p.first);
+    buf.append(", ", 2);
+    write_value(buf, p.second);
+    buf.push_back(')');
+}
+
+// std::tuple，输出(e1, e2, e3)
+template<typename... Ts>
+inline auto write_impl(FmtBuffer& buf, const std::tuple<Ts...>& tup, rank<2>)
+    -> typename std::enable_if<!has_own_stream<std::tuple<Ts...>>::value>::type
+{
+    buf.push_back('(');
+    write_tuple(buf, tup, std::index_sequence_for<Ts...>());
+    buf.push_back(')');
+}
+
+// 将std::ostream的输出分块追加到FmtBuffer，流式输出时很大的对象也不会被完整缓存
+class FmtStreamBuf: public std::streambuf {
+public:
+    explicit FmtStreamBuf(FmtBuffer& buf)
+        : m_buf(buf)
+    {
+        setp(m_chunk, m_chunk + sizeof(m_chunk));
+    }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        sync();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        // 大块的内容不经过m_chunk
+        if (n > epptr() - pptr())
+        {
+            sync();
+            m_buf.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+        std::memcpy(pptr(), s, static_cast<std::size_t>(n));
+        pbump(static_cast<int>(n));
+
+        return n;
+    }
+
+    int sync() override
+    {
+        m_buf.append(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+        setp(m_chunk, m_chunk + sizeof(m_chunk));
+
+        return 0;
+    }
+
+private:
+    FmtBuffer& m_buf;
+    char m_chunk[256];
+};
+
+// 其它重载了<<运算符的类型，经过std::ostream直接写入缓冲区
+template<typename T>
+inline auto write_impl(FmtBuffer& buf, const T& t, rank<1>)
+    -> typename std::enable_if<is_streamable<T>::value>::type
+{
+    FmtStreamBuf sb(buf);
+    std::ostream os(&sb);
+
+    os << t;
+    sb.pubsync();
+}
+
+// 将一个参数按类型写入缓冲区
+template<typename T>
+inline void write_value(FmtBuffer& buf, const T& t)
+{
+    write_impl(buf, t, rank<8>());
+}
+
+// 格式化参数，特化了formatter<T>的类型可以获取格式说明
+template<typename T>
+inline auto write_arg(FmtBuffer& buf, const T& t, const std::string& spec, rank<1>)
+    -> typename std::enable_if<has_formatter<T>::value>::type
+{
+    formatter<T>().format(buf, t, spec);
+}
+
+template<typename T>
+inline void write_arg(FmtBuffer& buf, const T& t, const std::string&, rank<0>)
+{
+    write_value(buf, t);
+}
+
+// 没有参数了，输出尾串
+inline void __format(FmtBuffer& buf, const Fmt& fmt, std::size_t idx)
+{
+    if (idx < fmt.subs().size())
+    {
+        buf.append(fmt.subs()[idx]);
+    }
 }
 
 template<typename T, typename... Args>
-std::ostringstream& __format(std::ostringstream& oss,
-    std::deque<std::string>& subs, const T& t, const Args&... args)
+inline void __format(FmtBuffer& buf, const Fmt& fmt,
+    std::size_t idx, const T& t, const Args&... args)
 {
-    if (subs.empty())
+    const auto& subs = fmt.subs();
+
+    if (idx >= subs.size())
     {
-        return oss;
+        return;
     }
 
-    oss << subs.front();
-    subs.pop_front();
+    buf.append(subs[idx]);
 
     // 只剩尾串，忽略多余参数
-    if (subs.empty())
+    if (idx + 1 == subs.size())
+    {
+        return;
+    }
+
+    write_arg(buf, t, fmt.spec(idx), rank<1>());
+    __format(buf, fmt, idx + 1, args...);
+}
+
+// 将格式化结果追加到buf，Fmt对象无效或者参数不足时返回false
+template<typename... Args>
+inline bool _format_to(FmtBuffer& buf, const Fmt& fmt, const Args&... args)
+{
+    if (!fmt.is_ok() || fmt.subs().size()-1 > sizeof...(args))
+    {
+        return false;
+    }
+
+    buf.reserve(buf.size() + fmt.to_str().length() + 8 * sizeof...(args));
+    __format(buf, fmt, 0, args...);
+
+    return true;
+}
+
+// 输出FmtView中当前子串的所有片段，返回下一个子串的第一个片段
+inline std::size_t __append_seg(FmtBuffer& buf, const FmtView& fmt, std::size_t piece)
+{
+    const auto& pieces = fmt.pieces();
+
+    for (; piece < pieces.size(); ++piece)
     {
-        return oss;
+        buf.append(fmt.data() + pieces[piece].off, pieces[piece].len);
+        if (pieces[piece].last)
+        {
+            return piece + 1;
+        }
     }
 
-    oss << t;
+    return piece;
+}
 
-    return __format(oss, subs, args...);
+// 没有参数了，输出尾串
+inline void __format(FmtBuffer& buf, const FmtView& fmt, std::size_t piece, std::size_t)
+{
+    __append_seg(buf, fmt, piece);
 }
 
 template<typename T, typename... Args>
-inline std::string _format(const Fmt& fmt, const T& t, const Args&... args)
+inline void __format(FmtBuffer& buf, const FmtView& fmt, std::size_t piece,
+    std::size_t idx, const T& t, const Args&... args)
+{
+    if (idx >= fmt.size())
+    {
+        return;
+    }
+
+    piece = __append_seg(buf, fmt, piece);
+
+    // 只剩尾串，忽略多余参数
+    if (idx + 1 == fmt.size())
+    {
+        return;
+    }
+
+    write_arg(buf, t, fmt.spec(idx), rank<1>());
+    __format(buf, fmt, piece, idx + 1, args...);
+}
+
+template<typename... Args>
+inline bool _format_to(FmtBuffer& buf, const FmtView& fmt, const Args&... args)
+{
+    if (!fmt.is_ok() || fmt.size()-1 > sizeof...(args))
+    {
+        return false;
+    }
+
+    __format(buf, fmt, 0, 0, args...);
+
+    return true;
+}
+
+template<typename F, typename T, typename... Args>
+inline std::string _format(const F& fmt, const T& t, const Args&... args)
+{
+    FmtBuffer buf;
+
+    if (!_format_to(buf, fmt, t, args...))
+    {
+        return std::string();
+    }
+
+    return buf.release();
+}
+
+// 清理模式下格式化，字符串和字符参数经过sanitize_to写入
+template<typename F, typename T, typename... Args>
+inline std::string _format_sanitized(const F& fmt, const T& t, const Args&... args)
 {
-    if (!fmt.is_ok() || fmt.subs().size()-1 > sizeof...(args)+1)
+    FmtBuffer buf;
+
+    buf.set_sanitize(true);
+    if (!_format_to(buf, fmt, t, args...))
     {
         return std::string();
     }
-    std::ostringstream oss;
-    std::deque<std::string> subs(fmt.subs());
 
-    return __format(oss, subs, t, args...).str();
+    return buf.release();
+}
+
+// print/println的行缓冲区上限，更长的行分段输出，缓冲区不会随之增长
+const std::size_t kLineBufferSize = 64 << 10;
+
+// 当前线程复用的行缓冲区，print/println先将整行写入这里再一次性输出
+// 格式化时又调用print/println（例如operator<<中输出）时使用临时的缓冲区，不会清除外层的内容
+class LineBuffer {
+public:
+    LineBuffer()
+        : m_owner(!busy())
+    {
+        if (m_owner)
+        {
+            busy() = true;
+            shared().clear();
+        }
+    }
+
+    ~LineBuffer()
+    {
+        if (m_owner)
+        {
+            shared().set_sink(nullptr, 0);
+            busy() = false;
+        }
+    }
+
+    LineBuffer(const LineBuffer&) = delete;
+    LineBuffer& operator=(const LineBuffer&) = delete;
+
+    inline FmtBuffer& get()
+    {
+        return m_owner ? shared() : m_nested;
+    }
+
+private:
+    static FmtBuffer& shared()
+    {
+        static thread_local FmtBuffer t_buf;
+
+        return t_buf;
+    }
+
+    static bool& busy()
+    {
+        static thread_local bool t_busy = false;
+
+        return t_busy;
+    }
+
+    bool m_owner;
+    FmtBuffer m_nested;
+};
+
+// 格式化一行内容，没有参数时直接输出格式串（与print(fmt)行为一致）
+inline bool _format_line(FmtBuffer& buf, const Fmt& fmt)
+{
+    buf.append(fmt.to_str());
+
+    return fmt.is_ok();
+}
+
+inline bool _format_line(FmtBuffer& buf, const FmtView& fmt)
+{
+    fmt.append_to(buf);
+
+    return fmt.is_ok();
+}
+
+template<typename F, typename T, typename... Args>
+inline bool _format_line(FmtBuffer& buf, const F& fmt, const T& t, const Args&... args)
+{
+    return _format_to(buf, fmt, t, args...);
+}
+
+// 通过write(2)输出[data, data + len)，只有被信号中断或者短写时才会多次调用write
+inline bool write_fd(int fd, const char* data, std::size_t len)
+{
+    while (len > 0)
+    {
+        auto n = ::write(fd, data, len);
+        if (n < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+
+    return true;
+}
+
+// 通过write(2)输出整个缓冲区
+inline bool write_fd(int fd, const FmtBuffer& buf)
+{
+    return write_fd(fd, buf.str().data(), buf.size());
+}
+
+// 输出到FILE*，第一次输出时获取FILE锁并保持到析构，超长的行分段输出时也不会与其它行交错
+class FileFmtSink: public FmtSink {
+public:
+    explicit FileFmtSink(std::FILE* fp)
+        : m_fp(fp) {}
+
+    ~FileFmtSink() override
+    {
+        if (m_locked)
+        {
+            ::funlockfile(m_fp);
+        }
+    }
+
+    bool flush(const char* data, std::size_t len) override
+    {
+        if (!m_locked)
+        {
+            ::flockfile(m_fp);
+            m_locked = true;
+        }
+#if defined(__GLIBC__)
+        return ::fwrite_unlocked(data, 1, len, m_fp) == len;
+#else
+        return std::fwrite(data, 1, len, m_fp) == len;
+#endif
+    }
+
+private:
+    std::FILE* m_fp;
+    bool m_locked = false;
+};
+
+// 通过write(2)输出到文件描述符
+class FdFmtSink: public FmtSink {
+public:
+    explicit FdFmtSink(int fd)
+        : m_fd(fd) {}
+
+    bool flush(const char* data, std::size_t len) override
+    {
+        return write_fd(m_fd, data, len);
+    }
+
+private:
+    int m_fd;
+};
+
+// 输出到std::ostream
+class StreamFmtSink: public FmtSink {
+public:
+    explicit StreamFmtSink(std::ostream& os)
+        : m_os(os) {}
+
+    bool flush(const char* data, std::size_t len) override
+    {
+        return !m_os.write(data, static_cast<std::streamsize>(len)).fail();
+    }
+
+private:
+    std::ostream& m_os;
+};
+
+// 使用行缓冲区格式化一行并输出到sink，不超过kLineBufferSize的行只输出一次
+template<typename F, typename... Args>
+inline bool _print_sink(FmtSink& sink, bool newline, const F& fmt, const Args&... args)
+{
+    LineBuffer line;
+    auto& buf = line.get();
+    buf.set_sink(&sink, kLineBufferSize);
+    bool bRet = _format_line(buf, fmt, args...);
+
+    if (newline)
+    {
+        buf.push_back('\n');
+    }
+
+    return buf.flush() && bRet;
+}
+
+// 持有FILE锁输出，不超过kLineBufferSize的行通过一次fwrite输出，同一FILE上的行不会交错
+template<typename F, typename... Args>
+inline bool _print_file(std::FILE* fp, bool newline, const F& fmt, const Args&... args)
+{
+    FileFmtSink sink(fp);
+
+    return _print_sink(sink, newline, fmt, args...);
+}
+
+template<typename F, typename... Args>
+inline bool _print_fd(int fd, bool newline, const F& fmt, const Args&... args)
+{
+    FdFmtSink sink(fd);
+
+    return _print_sink(sink, newline, fmt, args...);
+}
+
+template<typename F, typename... Args>
+inline std::ostream& _print_stream(std::ostream& os, bool newline,
+    const F& fmt, const Args&... args)
+{
+    StreamFmtSink sink(os);
+    LineBuffer line;
+    auto& buf = line.get();
+    buf.set_sink(&sink, kLineBufferSize);
+
+    if (!_format_line(buf, fmt, args...))
+    {
+        buf.clear();
+    }
+    if (newline)
+    {
+        buf.push_back('\n');
+    }
+    buf.flush();
+
+    return os;
+}
+
+// 使用固定大小的缓冲区流式格式化到sink
+template<typename F, typename... Args>
+inline bool _format_to_sink(FmtSink& sink, std::size_t bufferSize, const F& fmt,
+    const Args&... args)
+{
+    FmtBuffer buf;
+    buf.set_sink(&sink, bufferSize);
+    bool bRet = _format_to(buf, fmt, args...);
+
+    return buf.flush() && bRet;
 }
 } // namespace jumper_inner
 
+/// 将range中的元素以sep分隔输出，不带括号，maxItems不为0时最多输出maxItems个元素
+template<typename Range>
+inline auto join(const Range& range, const char* sep = ", ", std::size_t maxItems = 0)
+    -> JoinView<decltype(std::begin(range))>
+{
+    return JoinView<decltype(std::begin(range))>(std::begin(range), std::end(range),
+        sep, "", "", maxItems, jumper_inner::is_map_like<Range>::value);
+}
+
+/// 与直接输出容器相同，但最多输出maxItems个元素，超出部分以"..."代替
+template<typename Range>
+inline auto limit(const Range& range, std::size_t maxItems)
+    -> JoinView<decltype(std::begin(range))>
+{
+    bool isMap = jumper_inner::is_map_like<Range>::value;
+
+    return JoinView<decltype(std::begin(range))>(std::begin(range), std::end(range),
+        ", ", isMap ? "{" : "[", isMap ? "}" : "]", maxItems, isMap);
+}
+
+/// 将格式化结果追加到buf中，可以复用同一个FmtBuffer避免反复分配内存
+/// Fmt对象无效或者参数不足时返回false，buf不会被修改
+template<typename... Args>
+inline bool format_to(FmtBuffer& buf, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_format_to(buf, fmt, args...);
+}
+
 /// 直接接受一个Fmt对象的可变引用，如果Fmt对象无效，返回空字符串
 template<typename T, typename... Args>
 inline std::string format(const Fmt& fmt, const T& t, const Args&... args)
@@ -86,7 +1038,7 @@ inline std::string format(const Fmt& fmt, const T& t, const Args&... args)
 template<typename T, typename... Args>
 inline std::ostream& print(const Fmt& fmt, const T& t, const Args&... args)
 {
-    return (std::cout << format(fmt, t, args...));
+    return jumper_inner::_print_stream(std::cout, false, fmt, t, args...);
 }
 
 inline std::ostream& print(const Fmt& fmt)
@@ -94,16 +1046,16 @@ inline std::ostream& print(const Fmt& fmt)
     return (std::cout << fmt.to_str());
 }
 
-/// 带换行输出
+/// 带换行输出，整行（包括换行符）一次性写入std::cout
 template<typename T, typename... Args>
 inline std::ostream& println(const Fmt& fmt, const T& t, const Args&... args)
 {
-    return (print(fmt, t, args...) << "\n");
+    return jumper_inner::_print_stream(std::cout, true, fmt, t, args...);
 }
 
 inline std::ostream& println(const Fmt& fmt)
 {
-    return (print(fmt) << "\n");
+    return jumper_inner::_print_stream(std::cout, true, fmt);
 }
 
 /// 接受C字符串并构造Fmt对象，如果Fmt对象无效，返回空字符串
@@ -135,12 +1087,16 @@ inline std::ostream& print(const char* fmtStr)
 template<typename T, typename... Args>
 inline std::ostream& println(const char* fmtStr, const T& t, const Args&... args)
 {
-    return (print(fmtStr, t, args...) << "\n");
+    Fmt fmt(fmtStr);
+
+    return println(fmt, t, args...);
 }
 
 inline std::ostream& println(const char* fmtStr)
 {
-    return (print(fmtStr) << "\n");
+    Fmt fmt(fmtStr);
+
+    return println(fmt);
 }
 
 /// 接受string并构造Fmt对象，如果Fmt对象无效，返回空字符串
@@ -176,6 +1132,202 @@ inline std::ostream& println(const std::string& fmtStr)
     return println(fmtStr.c_str());
 }
 
+/// 直接写入FILE*，不经过std::cout。整行内容先写入当前线程的缓冲区，
+/// 再持有FILE锁通过一次fwrite_unlocked输出，多线程输出到同一FILE时不会交错
+/// Fmt对象无效或者写入失败时返回false
+template<typename... Args>
+inline bool print(std::FILE* fp, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_print_file(fp, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print(std::FILE* fp, const char* fmtStr, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_print_file(fp, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print(std::FILE* fp, const std::string& fmtStr, const Args&... args)
+{
+    return print(fp, fmtStr.c_str(), args...);
+}
+
+/// 直接写入FILE*，自带换行符，换行符与内容在同一次fwrite中输出
+template<typename... Args>
+inline bool println(std::FILE* fp, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_print_file(fp, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println(std::FILE* fp, const char* fmtStr, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_print_file(fp, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println(std::FILE* fp, const std::string& fmtStr, const Args&... args)
+{
+    return println(fp, fmtStr.c_str(), args...);
+}
+
+/// 直接通过write(2)写入文件描述符，整行内容只调用一次write（短写时继续写入剩余部分）
+/// 对于管道，不超过PIPE_BUF的行可以保证不与其它写入者交错
+/// Fmt对象无效或者写入失败时返回false
+template<typename... Args>
+inline bool print_fd(int fd, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_print_fd(fd, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print_fd(int fd, const char* fmtStr, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_print_fd(fd, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print_fd(int fd, const std::string& fmtStr, const Args&... args)
+{
+    return print_fd(fd, fmtStr.c_str(), args...);
+}
+
+/// 直接通过write(2)写入文件描述符，自带换行符
+template<typename... Args>
+inline bool println_fd(int fd, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_print_fd(fd, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println_fd(int fd, const char* fmtStr, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_print_fd(fd, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println_fd(int fd, const std::string& fmtStr, const Args&... args)
+{
+    return println_fd(fd, fmtStr.c_str(), args...);
+}
+
+/// 流式格式化到sink：结果写入bufferSize字节的缓冲区，缓冲区满时调用sink.flush()输出，
+/// 很长的字符串、容器、hexdump等参数分段输出，内存占用与结果的长度无关
+/// Fmt对象无效、参数不足或者sink.flush()返回false时返回false
+template<typename... Args>
+inline bool format_to_sink(FmtSink& sink, const Fmt& fmt, const Args&... args)
+{
+    return jumper_inner::_format_to_sink(sink, kFmtSinkBufferSize, fmt, args...);
+}
+
+template<typename... Args>
+inline bool format_to_sink(FmtSink& sink, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_format_to_sink(sink, kFmtSinkBufferSize, fmt, args...);
+}
+
+template<typename... Args>
+inline bool format_to_sink(FmtSink& sink, const char* fmtStr, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_format_to_sink(sink, kFmtSinkBufferSize, fmt, args...);
+}
+
+template<typename... Args>
+inline bool format_to_sink(FmtSink& sink, const std::string& fmtStr, const Args&... args)
+{
+    return format_to_sink(sink, fmtStr.c_str(), args...);
+}
+
+/// FmtView版本：格式串不会被复制，也不会构造临时Fmt对象
+template<typename... Args>
+inline bool format_to(FmtBuffer& buf, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_format_to(buf, fmt, args...);
+}
+
+template<typename T, typename... Args>
+inline std::string format(const FmtView& fmt, const T& t, const Args&... args)
+{
+    return jumper_inner::_format(fmt, t, args...);
+}
+
+/// 清理模式的format：字符串和字符参数中的控制字符（包括ESC）及无效的UTF-8字节被转义，
+/// 用于输出不可信的内容，格式串本身不受影响，见sanitize_to
+template<typename T, typename... Args>
+inline std::string format_sanitized(const Fmt& fmt, const T& t, const Args&... args)
+{
+    return jumper_inner::_format_sanitized(fmt, t, args...);
+}
+
+template<typename T, typename... Args>
+inline std::string format_sanitized(const FmtView& fmt, const T& t, const Args&... args)
+{
+    return jumper_inner::_format_sanitized(fmt, t, args...);
+}
+
+template<typename T, typename... Args>
+inline std::string format_sanitized(const char* fmtStr, const T& t, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_format_sanitized(fmt, t, args...);
+}
+
+template<typename T, typename... Args>
+inline std::string format_sanitized(const std::string& fmtStr, const T& t, const Args&... args)
+{
+    Fmt fmt(fmtStr);
+
+    return jumper_inner::_format_sanitized(fmt, t, args...);
+}
+
+template<typename... Args>
+inline std::ostream& print(const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_stream(std::cout, false, fmt, args...);
+}
+
+template<typename... Args>
+inline std::ostream& println(const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_stream(std::cout, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print(std::FILE* fp, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_file(fp, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println(std::FILE* fp, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_file(fp, true, fmt, args...);
+}
+
+template<typename... Args>
+inline bool print_fd(int fd, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_fd(fd, false, fmt, args...);
+}
+
+template<typename... Args>
+inline bool println_fd(int fd, const FmtView& fmt, const Args&... args)
+{
+    return jumper_inner::_print_fd(fd, true, fmt, args...);
+}
+
 } // namespace jumper
 
 #endif // FORMAT_H
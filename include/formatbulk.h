@@ -0,0 +1,250 @@
+#ifndef FORMATBULK_H
+#define FORMATBULK_H
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "format.h"
+
+namespace jumper {
+
+/**
+  * @brief 批量格式化的结果，所有行连续存放在data中
+  * @note 第i行为data中[offsets[i], offsets[i + 1])的内容，offsets的长度为行数加1
+*/
+struct BulkResult {
+    std::string data;
+    std::vector<std::size_t> offsets;
+
+    /// 行数
+    inline std::size_t size() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    /// 第index行的起始地址
+    inline const char* row_data(std::size_t index) const
+    {
+        return data.data() + offsets[index];
+    }
+
+    /// 第index行的长度
+    inline std::size_t row_size(std::size_t index) const
+    {
+        return offsets[index + 1] - offsets[index];
+    }
+
+    /// 第index行的内容
+    inline std::string row(std::size_t index) const
+    {
+        return data.substr(offsets[index], row_size(index));
+    }
+};
+
+// 内部命名空间 jumper_inner
+namespace jumper_inner {
+// 可以使用std::get展开的类型：std::tuple、std::pair、std::array
+template<typename T, typename = void>
+struct is_tuple_like: std::false_type {};
+
+template<typename T>
+struct is_tuple_like<T, void_t<decltype(std::tuple_size<T>::value)>>: std::true_type {};
+
+template<typename F, typename Tuple, std::size_t... Is>
+inline bool _format_row(FmtBuffer& buf, const F& fmt, const Tuple& row,
+    std::index_sequence<Is...>)
+{
+    return _format_to(buf, fmt, std::get<Is>(row)...);
+}
+
+// 元组的每个元素作为一个参数
+template<typename F, typename Row>
+inline auto format_row(FmtBuffer& buf, const F& fmt, const Row& row, rank<1>)
+    -> typename std::enable_if<is_tuple_like<Row>::value, bool>::type
+{
+    return _format_row(buf, fmt, row,
+        std::make_index_sequence<std::tuple_size<Row>::value>());
+}
+
+// 其它类型作为唯一的参数
+template<typename F, typename Row>
+inline bool format_row(FmtBuffer& buf, const F& fmt, const Row& row, rank<0>)
+{
+    return _format_to(buf, fmt, row);
+}
+
+// 格式化[first, last)中的所有行，追加到buf中，每行的结束位置追加到ends中
+template<typename F, typename It>
+inline bool format_rows(const F& fmt, It first, It last, std::size_t count,
+    FmtBuffer& buf, std::vector<std::size_t>& ends)
+{
+    auto begin = buf.size();
+    auto firstRow = ends.size();
+    // 下一次预估总长度时已格式化的行数
+    std::size_t checkpoint = 16;
+
+    ends.reserve(ends.size() + count);
+    for (; first != last; ++first)
+    {
+        if (!format_row(buf, fmt, *first, rank<1>()))
+        {
+            return false;
+        }
+        ends.push_back(buf.size());
+
+        // 第16、256、4096...行时按已格式化的平均长度预估总长度（多留1/8），减少扩容的次数；
+        // 每次最多预留已写入内容的4倍，开头的行很长（例如表头）时不会预留过多的内存
+        auto rows = ends.size() - firstRow;
+        if (rows == checkpoint)
+        {
+            auto written = buf.size() - begin;
+            auto estimate = written * count / rows;
+            estimate = std::min(estimate + estimate / 8, written * 4);
+            buf.reserve(begin + estimate);
+            checkpoint *= 16;
+        }
+    }
+
+    return true;
+}
+} // namespace jumper_inner
+
+/// 使用同一个格式批量格式化rows中的每一行，所有行连续存放在out.data中，out原有内容会被清空
+/// 每一行可以是std::tuple/std::pair/std::array（元素依次作为参数），也可以是单个参数
+/// threads大于1时将rows切分为threads段并行格式化，再按原顺序拼接，结果与串行完全相同
+/// 格式对象（Fmt或FmtView）在格式化期间只读，可以被多个线程共享
+/// 并行时每次调用创建threads - 1个线程，最后一段由当前线程处理，适合行数很多的批量格式化
+/// 格式无效或者参数不足时返回false，out为空；格式化某一行时抛出的异常在当前线程重新抛出，out为空
+template<typename F, typename Range>
+inline bool format_bulk(const F& fmt, const Range& rows, BulkResult& out,
+    unsigned threads = 1)
+{
+    out.data.clear();
+    out.offsets.assign(1, 0);
+
+    auto first = std::begin(rows);
+    auto last = std::end(rows);
+    auto count = static_cast<std::size_t>(std::distance(first, last));
+    // 每个线程至少处理的行数，行数太少时并行得不偿失
+    const std::size_t kMinRowsPerThread = 1024;
+
+    threads = static_cast<unsigned>(std::max<std::size_t>(1,
+        std::min<std::size_t>(threads, count / kMinRowsPerThread)));
+
+    if (1 == threads)
+    {
+        FmtBuffer buf;
+        bool bRet = false;
+
+        try
+        {
+            bRet = jumper_inner::format_rows(fmt, first, last, count, buf, out.offsets);
+        }
+        catch (...)
+        {
+            out.offsets.assign(1, 0);
+            throw;
+        }
+
+        if (!bRet)
+        {
+            out.offsets.assign(1, 0);
+            return false;
+        }
+        out.data = buf.release();
+
+        return true;
+    }
+
+    // 每个线程格式化连续的一段，结果保存在各自的缓冲区中
+    std::vector<FmtBuffer> bufs(threads);
+    std::vector<std::vector<std::size_t>> ends(threads);
+    std::vector<char> results(threads, 0);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    auto chunkFirst = first;
+
+    workers.reserve(threads - 1);
+    for (unsigned i = 0; i != threads; ++i)
+    {
+        auto chunkCount = count / threads + (i < count % threads ? 1 : 0);
+        auto chunkLast = std::next(chunkFirst, static_cast<std::ptrdiff_t>(chunkCount));
+        // 异常不能离开线程函数，保存后在当前线程重新抛出
+        auto task = [&fmt, &bufs, &ends, &results, &errors, i, chunkFirst, chunkLast,
+            chunkCount]() {
+            try
+            {
+                results[i] = jumper_inner::format_rows(fmt, chunkFirst, chunkLast,
+                    chunkCount, bufs[i], ends[i]);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+        };
+
+        // 最后一段由当前线程处理，创建线程失败时也由当前线程处理
+        if (i + 1 == threads)
+        {
+            task();
+        }
+        else
+        {
+            try
+            {
+                workers.emplace_back(task);
+            }
+            catch (const std::system_error&)
+            {
+                task();
+            }
+        }
+        chunkFirst = chunkLast;
+    }
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+
+    for (const auto& error: errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+    if (std::find(results.cbegin(), results.cend(), 0) != results.cend())
+    {
+        return false;
+    }
+
+    // 按原顺序拼接
+    std::size_t total = 0;
+    for (const auto& buf: bufs)
+    {
+        total += buf.size();
+    }
+    out.data.reserve(total);
+    out.offsets.reserve(count + 1);
+    for (unsigned i = 0; i != threads; ++i)
+    {
+        auto base = out.data.size();
+
+        out.data.append(bufs[i].str());
+        for (auto end: ends[i])
+        {
+            out.offsets.push_back(base + end);
+        }
+    }
+
+    return true;
+}
+
+} // namespace jumper
+
+#endif // FORMATBULK_H
@@ -0,0 +1,263 @@
+#ifndef FORMATHEX_H
+#define FORMATHEX_H
+
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "format.h"
+
+namespace jumper {
+
+/// hex()和hexdump()默认最多输出的字节数，超出部分以"...(N more bytes)"代替
+const std::size_t kHexMaxBytes = 4096;
+
+/**
+  * @brief 二进制数据的格式化适配器，由hex()或者hexdump()构造，直接作为format的参数使用
+  * @note 只保存数据的地址，被引用的数据必须在格式化完成前保持有效
+  * @note 格式说明为"X"时输出大写十六进制，例如"{X}"
+*/
+class HexView {
+public:
+    HexView(const void* data, std::size_t len, std::size_t width, std::size_t maxBytes)
+        : m_data(static_cast<const unsigned char*>(data)), m_len(len), m_width(width),
+        m_maxBytes(maxBytes) {}
+
+    const unsigned char* m_data;
+    std::size_t m_len;
+    // hexdump每行的字节数，0表示hex()的单行连续输出
+    std::size_t m_width;
+    // 最多输出的字节数，0表示不限制
+    std::size_t m_maxBytes;
+};
+
+// 内部命名空间 jumper_inner
+namespace jumper_inner {
+// 十六进制查找表：每个字节对应的两个十六进制字符、hexdump中的" xx"（补齐为4字节，
+// 整体复制后只前进3个字节）以及ASCII列中的字符
+struct HexTable {
+    char digits[512];
+    char spaced[1024];
+    char ascii[256];
+
+    constexpr explicit HexTable(bool upper)
+        : digits {}, spaced {}, ascii {}
+    {
+        const char* alphabet = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+
+        for (int i = 0; i != 256; ++i)
+        {
+            digits[2 * i] = alphabet[i >> 4];
+            digits[2 * i + 1] = alphabet[i & 0x0F];
+            spaced[4 * i] = ' ';
+            spaced[4 * i + 1] = alphabet[i >> 4];
+            spaced[4 * i + 2] = alphabet[i & 0x0F];
+            spaced[4 * i + 3] = ' ';
+            ascii[i] = (i >= 0x20 && i < 0x7F) ? static_cast<char>(i) : '.';
+        }
+    }
+};
+
+inline const HexTable& hex_table(bool upper)
+{
+    static constexpr HexTable s_lower(false);
+    static constexpr HexTable s_upper(true);
+
+    return upper ? s_upper : s_lower;
+}
+
+// 将len个字节编码为2 * len个十六进制字符，SSE2每次编码16个字节
+inline void hex_encode(const unsigned char* data, std::size_t len, char* out, bool upper)
+{
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    // 10~15需要从'0' + n再跳到'a'/'A'
+    const __m128i letter = _mm_set1_epi8(upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+    auto to_ascii = [&](__m128i n) {
+        return _mm_add_epi8(_mm_add_epi8(n, zero), _mm_and_si128(_mm_cmpgt_epi8(n, nine), letter));
+    };
+
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i hi = to_ascii(_mm_and_si128(_mm_srli_epi16(v, 4), low));
+        __m128i lo = to_ascii(_mm_and_si128(v, low));
+
+        // 高半字节在前，交错得到每个字节的两个字符
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+    const char* table = hex_table(upper).digits;
+    for (; i < len; ++i)
+    {
+        std::memcpy(out + 2 * i, table + 2 * data[i], 2);
+    }
+}
+
+// 截断标记，omitted为没有输出的字节数
+inline void write_hex_omitted(FmtBuffer& buf, std::size_t omitted)
+{
+    buf.append("...(", 4);
+    write_int(buf, omitted);
+    buf.append(" more bytes)", 12);
+}
+
+// hex()：连续的十六进制字符，分块编码到栈上再追加
+inline void write_hex(FmtBuffer& buf, const HexView& view, bool upper)
+{
+    std::size_t len = view.m_maxBytes ? std::min(view.m_len, view.m_maxBytes) : view.m_len;
+    char chunk[512];
+
+    buf.reserve(buf.size() + 2 * len);
+    for (std::size_t off = 0; off < len; off += sizeof(chunk) / 2)
+    {
+        std::size_t n = std::min(sizeof(chunk) / 2, len - off);
+
+        hex_encode(view.m_data + off, n, chunk, upper);
+        buf.append(chunk, 2 * n);
+    }
+    if (len < view.m_len)
+    {
+        write_hex_omitted(buf, view.m_len - len);
+    }
+}
+
+// hexdump()：与"hexdump -C"相同的布局，每行为偏移量、十六进制列和ASCII列，行之间以'\n'分隔
+//   00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 0a           |Hello, world.|
+inline void write_hexdump(FmtBuffer& buf, const HexView& view, bool upper)
+{
+    // 每行最多256字节，保证栈上的缓冲区至少放得下一行
+    const std::size_t kMaxWidth = 256;
+    std::size_t width = std::min(view.m_width, kMaxWidth);
+    std::size_t len = view.m_maxBytes ? std::min(view.m_len, view.m_maxBytes) : view.m_len;
+    const HexTable& table = hex_table(upper);
+    // 每行的长度：换行符、偏移量、两个分组空格、每字节" xx"、"  |"、ASCII列、'|'，
+    // 多留一个字节给" xx"的4字节复制
+    const std::size_t lineSize = 1 + 8 + 2 + width * 3 + 3 + width + 1 + 1;
+    // 多行写入栈上的缓冲区后一次追加，刚写入的内容不会立即被读取
+    char chunk[8192];
+    char* p = chunk;
+    // 至少16字节时每行的中间多一个空格分组
+    std::size_t half = (width >= 16) ? width / 2 : width;
+
+    buf.reserve(buf.size() + (len / width + 1) * lineSize + 32);
+    for (std::size_t off = 0; off < len; off += width)
+    {
+        std::size_t n = std::min(width, len - off);
+        const unsigned char* row = view.m_data + off;
+
+        if (static_cast<std::size_t>(chunk + sizeof(chunk) - p) < lineSize)
+        {
+            buf.append(chunk, static_cast<std::size_t>(p - chunk));
+            p = chunk;
+        }
+        if (0 != off)
+        {
+            *p++ = '\n';
+        }
+        // 偏移量，8位十六进制
+        auto offset = static_cast<std::uint32_t>(off);
+        for (int shift = 24; shift >= 0; shift -= 8)
+        {
+            std::memcpy(p, table.digits + 2 * ((offset >> shift) & 0xFF), 2);
+            p += 2;
+        }
+        *p++ = ' ';
+
+        // 十六进制列，每个字节的位置直接由下标计算，复制之间没有依赖，
+        // " xx"之后多复制的空格恰好是下一个字节的位置或者分组空格，
+        // 最后一行不足width个字节时以空格补齐，保证ASCII列对齐
+        std::size_t i = 0;
+        for (; i != n; ++i)
+        {
+            std::memcpy(p + 3 * i + (i >= half), table.spaced + 4 * row[i], 4);
+        }
+        for (; i != width; ++i)
+        {
+            std::memcpy(p + 3 * i + (i >= half), "    ", 4);
+        }
+        p += 3 * width + (width > half);
+
+        p[0] = ' ';
+        p[1] = ' ';
+        p[2] = '|';
+        p += 3;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            p[i] = table.ascii[row[i]];
+        }
+        p += n;
+        *p++ = '|';
+    }
+    buf.append(chunk, static_cast<std::size_t>(p - chunk));
+
+    if (len < view.m_len)
+    {
+        if (0 != len)
+        {
+            buf.push_back('\n');
+        }
+        write_hex_omitted(buf, view.m_len - len);
+    }
+}
+} // namespace jumper_inner
+
+template<>
+struct formatter<HexView> {
+    void format(FmtBuffer& buf, const HexView& view, const std::string& spec) const
+    {
+        bool upper = ("X" == spec);
+
+        if (0 == view.m_width)
+        {
+            jumper_inner::write_hex(buf, view, upper);
+        }
+        else
+        {
+            jumper_inner::write_hexdump(buf, view, upper);
+        }
+    }
+};
+
+/// 将[data, data + len)输出为连续的十六进制字符，例如"deadbeef"
+/// maxBytes不为0时最多输出maxBytes个字节，超出部分以"...(N more bytes)"代替
+inline HexView hex(const void* data, std::size_t len, std::size_t maxBytes = kHexMaxBytes)
+{
+    return HexView(data, len, 0, maxBytes);
+}
+
+/// 连续存储的容器，例如std::string、std::vector<std::uint8_t>、std::array
+template<typename Container>
+inline auto hex(const Container& c, std::size_t maxBytes = kHexMaxBytes)
+    -> decltype(c.data(), c.size(), HexView(nullptr, 0, 0, 0))
+{
+    return HexView(c.data(), c.size() * sizeof(*c.data()), 0, maxBytes);
+}
+
+/// 将[data, data + len)按"hexdump -C"的布局输出，每行width个字节，包括偏移量和ASCII列
+/// maxBytes不为0时最多输出maxBytes个字节，超出部分以"...(N more bytes)"代替
+inline HexView hexdump(const void* data, std::size_t len, std::size_t width = 16,
+    std::size_t maxBytes = kHexMaxBytes)
+{
+    return HexView(data, len, width ? width : 16, maxBytes);
+}
+
+template<typename Container>
+inline auto hexdump(const Container& c, std::size_t width = 16,
+    std::size_t maxBytes = kHexMaxBytes)
+    -> decltype(c.data(), c.size(), HexView(nullptr, 0, 0, 0))
+{
+    return HexView(c.data(), c.size() * sizeof(*c.data()), width ? width : 16, maxBytes);
+}
+
+} // namespace jumper
+
+#endif // FORMATHEX_H
@@ -0,0 +1,80 @@
+#ifndef LOGINDEX_H
+#define LOGINDEX_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace jumper {
+
+/// 索引文件头部的魔数，新建索引文件时写入
+const char kLogIndexMagic[8] = { 'J', 'L', 'O', 'G', 'I', 'D', 'X', '1' };
+
+/**
+  * @brief log索引项，每K条log记录生成一项，描述log文件中[offset, offset + length)的内容
+  * @note 索引文件为kLogIndexMagic加上连续存放的索引项，使用本机字节序
+  * @note 时间为自1970-01-01 00:00:00 UTC以来的毫秒数
+*/
+struct LogIndexEntry {
+    /// 第一条记录在log文件中的偏移量
+    std::uint64_t offset;
+    /// 所有记录的总字节数
+    std::uint64_t length;
+    /// 第一条记录和最后一条记录的时间
+    std::int64_t beginMs;
+    std::int64_t endMs;
+    /// 第一条记录的序号，每个进程从0开始
+    std::uint64_t seq;
+    /// 记录条数
+    std::uint32_t count;
+    /// 出现过的log级别，第(level - 1)位表示该级别
+    std::uint32_t levelMask;
+};
+
+/// log文件对应的索引文件路径
+inline std::string log_index_path(const std::string& logPath)
+{
+    return logPath + ".idx";
+}
+
+/**
+  * @brief 索引写入器，由LogTracer在写入log文件时调用，调用者负责加锁
+*/
+class LogIndexWriter {
+public:
+    /// 打开log文件对应的索引文件，offset为log文件当前的长度，interval为每项索引包含的记录数
+    bool open(const std::string& logPath, std::uint64_t offset, std::uint32_t interval);
+
+    /// 写入未满的索引项并关闭索引文件
+    void close();
+
+    inline bool is_open() const
+    {
+        return m_ofs.is_open();
+    }
+
+    /// log文件中写入了bytes字节的非log记录（例如会话分隔符）
+    void skip(std::uint64_t bytes);
+
+    /// log文件中写入了一条level级别、bytes字节的log记录
+    void record(int level, std::uint64_t bytes);
+
+private:
+    // 写入当前索引项
+    void flush_entry();
+
+    // 索引文件输出流
+    std::ofstream m_ofs;
+    // 每项索引包含的记录数
+    std::uint32_t m_interval = 0;
+    // log文件当前的长度
+    std::uint64_t m_offset = 0;
+    // 下一条记录的序号
+    std::uint64_t m_seq = 0;
+    // 正在统计的索引项
+    LogIndexEntry m_entry {};
+};
+
+} // namespace jumper
+
+#endif // LOGINDEX_H
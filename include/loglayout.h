@@ -0,0 +1,90 @@
+#ifndef LOGLAYOUT_H
+#define LOGLAYOUT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jumper {
+
+/**
+  * @brief log记录的来源位置，由JLOG_xxx调用点提供，其它方式输出的log没有来源位置
+*/
+struct LogLocation {
+    const char* file;
+    int line;
+    const char* function;
+};
+
+/**
+  * @brief 编译后的log记录布局，模式串只在设置时解析一次，输出时按顺序执行一组输出操作
+  * @note 模式串中的占位符：
+  *       %T  时间，"2024-01-02 15:04:05.123"，精确到毫秒
+  *       %l  log级别，"INFO"
+  *       %n  logger的全名，根logger为空
+  *       %t  线程号（gettid）
+  *       %N  线程名，见LogTracer::SetThreadName
+  *       %s  源文件名（不含目录），%# 行号，%f 函数名，只有JLOG_xxx调用点有来源位置，其它log输出"-"
+  *       %m  log内容，必须出现且只能出现一次
+  *       %%  '%'
+  * @note 线程号、线程名以及时间中精确到秒的部分缓存在线程局部变量中，每条记录不需要系统调用
+*/
+class LogLayout {
+public:
+    /// 编译模式串，失败时返回false，error为出错的原因，原有的布局不变
+    bool Compile(const std::string& pattern, std::string& error);
+
+    /// 编译时使用的模式串
+    inline const std::string& Pattern() const
+    {
+        return m_pattern;
+    }
+
+    /// 按布局输出一条log记录除log内容以外的部分：%m之后的部分覆盖写入tail，返回%m之前的部分
+    /// 头部不是常量时覆盖写入head并返回head，例如"[%l]:%m"的头部在编译时已经生成，不需要复制
+    /// level为log级别，name为logger的全名，where为nullptr表示没有来源位置
+    const std::string& Render(std::string& head, std::string& tail, int level,
+        const std::string& name, const LogLocation* where) const;
+
+private:
+    // 级别0~4各有一组输出操作，0为非log记录
+    static const int kLevels = 5;
+
+    // 输出操作，log级别在编译时已经展开为文本
+    enum class Op: std::uint8_t {
+        TEXT,
+        TIME,
+        LOGGER,
+        THREAD_ID,
+        THREAD_NAME,
+        FILE,
+        LINE,
+        FUNCTION,
+    };
+
+    struct Step {
+        Op op;
+        // TEXT操作的文本在m_text中的位置
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    // 执行[first, last)之间的输出操作，结果追加到buf
+    void run(std::string& buf, const Step* first, const Step* last,
+        const std::string& name, const LogLocation* where) const;
+
+    std::string m_pattern;
+    // 所有文本片段，转义后拼接在一起
+    std::string m_text;
+    // 各级别的输出操作
+    std::vector<Step> m_steps[kLevels];
+    // 各级别%m的位置，之前的操作输出到head，之后的输出到tail
+    std::size_t m_message[kLevels] = {};
+    // 各级别的头部是否为常量，以及编译时生成的常量头部
+    bool m_constHead[kLevels] = {};
+    std::string m_heads[kLevels];
+};
+
+} // namespace jumper
+
+#endif // LOGLAYOUT_H
@@ -0,0 +1,286 @@
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logindex.h"
+#include "lzcodec.h"
+#include "shmring.h"
+
+namespace jumper {
+
+/// log文件的写入方式
+enum class FileMode: int {
+    /// 带缓冲写入（默认），同一个log文件只能由一个进程写入
+    FILE_BUFFERED = 1,
+    /// 以O_APPEND方式打开，每条记录一次write()，多个进程可以同时追加同一个log文件
+    FILE_SHARED = 2,
+    /// 写入POSIX共享内存中的环形缓冲区，由jlogd进程写入文件，log路径为共享内存名称
+    FILE_SHM = 3,
+    /// 记录按数据块压缩后写入，由后台线程压缩，使用jlog_cat解压查看
+    FILE_COMPRESSED = 4,
+};
+
+/// FILE_SHARED方式下单次write()的默认最大字节数，与PIPE_BUF相同
+const std::size_t kAtomicWriteSize = 4096;
+
+/**
+  * @brief log输出目标，由LogTracer持有锁后调用，实现类不需要再加锁
+*/
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+
+    /// 写入一条log记录，level为log级别，0表示非log记录（例如会话分隔符），返回写入的字节数
+    virtual std::size_t write(int level, const std::string& header,
+        const std::string& body, bool newline) = 0;
+
+    /// 分段写入一条超长的记录：write_begin写入头部，write_part追加一段内容，
+    /// write_end结束记录并返回写入的字节数
+    /// write_begin返回false表示不支持分段写入，此时由LogTracer拼接完整的记录后调用write()
+    virtual bool write_begin(int, const std::string&)
+    {
+        return false;
+    }
+
+    virtual void write_part(const char*, std::size_t) {}
+
+    virtual std::size_t write_end(bool)
+    {
+        return 0;
+    }
+
+    /// 不支持分段写入时一条超长记录最多写入的字节数，超出的部分由LogTracer截断并加上截断标记
+    virtual std::size_t max_record() const
+    {
+        return std::size_t(1) << 20;
+    }
+
+    /// 将缓冲的内容交给内核
+    virtual void flush() {}
+
+    /// 用于fdatasync的文件描述符，-1表示没有
+    virtual int fd() const
+    {
+        return -1;
+    }
+};
+
+/**
+  * @brief 带缓冲的log文件，可以同时生成索引文件
+*/
+class FileSink: public LogSink {
+public:
+    /// 以追加方式打开log文件，indexInterval不为0时同时打开索引文件
+    FileSink(const std::string& path, std::uint32_t indexInterval);
+
+    ~FileSink() override;
+
+    inline bool is_open() const
+    {
+        return m_ofs.is_open();
+    }
+
+    std::size_t write(int level, const std::string& header,
+        const std::string& body, bool newline) override;
+
+    bool write_begin(int level, const std::string& header) override;
+
+    void write_part(const char* data, std::size_t len) override
+    {
+        m_ofs.write(data, static_cast<std::streamsize>(len));
+        m_partBytes += len;
+    }
+
+    std::size_t write_end(bool newline) override;
+
+    void flush() override
+    {
+        m_ofs.flush();
+    }
+
+    int fd() const override
+    {
+        return m_syncFd;
+    }
+
+private:
+    // 记录写入的字节数后更新索引
+    void index(int level, std::size_t bytes);
+
+    // log文件输出流
+    std::ofstream m_ofs;
+    // 同一个文件的描述符，只用于fdatasync
+    int m_syncFd = -1;
+    // 索引写入器
+    LogIndexWriter m_index;
+    // 正在分段写入的记录的级别和字节数
+    int m_partLevel = 0;
+    std::size_t m_partBytes = 0;
+};
+
+/**
+  * @brief 以O_APPEND方式打开的log文件，多个进程可以同时追加，不需要跨进程的锁
+  * @note 每条记录通过一次write()写入，内核保证同一次追加的内容不会与其它进程交错
+  * @note 超过atomicSize字节的记录被拆分为多次写入，除最后一段外每段以"[->pid]\n"结尾，
+  *       除第一段外每段以"[pid->]:"开头，读取时可以按进程号重新拼接
+  * @note 分段写入的超长记录每满atomicSize字节写入一段，不缓存完整的记录
+*/
+class AppendFileSink: public LogSink {
+public:
+    AppendFileSink(const std::string& path, std::size_t atomicSize);
+
+    ~AppendFileSink() override;
+
+    inline bool is_open() const
+    {
+        return m_fd >= 0;
+    }
+
+    std::size_t write(int level, const std::string& header,
+        const std::string& body, bool newline) override;
+
+    bool write_begin(int level, const std::string& header) override;
+
+    void write_part(const char* data, std::size_t len) override;
+
+    std::size_t write_end(bool newline) override;
+
+    int fd() const override
+    {
+        return m_fd;
+    }
+
+private:
+    // 拆分写入m_record中的内容，last为false时后面还有内容，只写入满atomicSize字节的段，
+    // 剩余的内容留在m_record中
+    void write_pieces(bool last);
+
+    // log文件描述符
+    int m_fd = -1;
+    // 单次write()的最大字节数
+    std::size_t m_atomicSize;
+    // 组装记录的缓冲区，由LogTracer的锁保护
+    std::string m_record;
+    std::string m_piece;
+    // 当前记录是否已经写入了拆分的段
+    bool m_split = false;
+    // 正在分段写入的记录的字节数（不包括拆分标记）
+    std::size_t m_partBytes = 0;
+};
+
+/**
+  * @brief 写入共享内存环形缓冲区的log输出目标，由独立的jlogd进程读取并写入文件
+  * @note 输出log的进程只做memcpy和原子操作，不调用write()，磁盘阻塞不会影响输出log的线程
+  * @note 缓冲区满时丢弃记录，丢弃的条数由jlogd写入log文件，超过容量1/4的记录被截断
+  * @note 没有文件描述符，FlushDurable不能保证共享内存中的记录已经写入磁盘
+*/
+class ShmSink: public LogSink {
+public:
+    ShmSink(const std::string& name, std::size_t capacity)
+        : m_ring(name, capacity) {}
+
+    inline bool is_open() const
+    {
+        return m_ring.is_open();
+    }
+
+    std::size_t write(int level, const std::string& header,
+        const std::string& body, bool newline) override;
+
+    /// 环形缓冲区中的记录必须连续，超长记录由LogTracer拼接，最多为单条记录的最大字节数
+    std::size_t max_record() const override
+    {
+        return m_ring.max_record();
+    }
+
+private:
+    ShmRingWriter m_ring;
+};
+
+/**
+  * @brief 压缩的log文件：记录先追加到当前数据块，满blockSize字节后交给后台线程压缩并写入文件
+  * @note 每个数据块带有头部和校验值（见LzBlockHeader），可以单独解码，使用jlog_cat解压
+  * @note 记录不跨数据块，超过blockSize的记录被拆分到多个数据块
+  * @note 未满的数据块约每秒提交一次（在下一次写入时），flush()提交并等待写入文件，
+  *       进程崩溃时当前数据块中的记录会丢失，不生成索引
+*/
+class CompressedFileSink: public LogSink {
+public:
+    CompressedFileSink(const std::string& path, std::size_t blockSize);
+
+    ~CompressedFileSink() override;
+
+    inline bool is_open() const
+    {
+        return m_fd >= 0;
+    }
+
+    std::size_t write(int level, const std::string& header,
+        const std::string& body, bool newline) override;
+
+    bool write_begin(int level, const std::string& header) override;
+
+    void write_part(const char* data, std::size_t len) override
+    {
+        append(data, len);
+        m_partBytes += len;
+    }
+
+    std::size_t write_end(bool newline) override;
+
+    void flush() override;
+
+    int fd() const override
+    {
+        return m_fd;
+    }
+
+private:
+    // 将当前数据块交给后台线程，待压缩的数据块过多时等待
+    void submit();
+
+    // 后台线程：压缩并写入数据块
+    void run();
+
+    // 追加到当前数据块，满时提交
+    void append(const char* data, std::size_t len);
+
+    // log文件描述符
+    int m_fd = -1;
+    // 数据块大小
+    std::size_t m_blockSize;
+    // 当前数据块，由LogTracer的锁保护
+    std::string m_block;
+
+    std::mutex m_mutex;
+    // 有待压缩的数据块或者停止
+    std::condition_variable m_ready;
+    // 有数据块写入完成
+    std::condition_variable m_done;
+    // 待压缩的数据块
+    std::deque<std::string> m_pending;
+    // 回收的数据块缓冲区
+    std::vector<std::string> m_free;
+    // 已提交及已写入的数据块个数
+    std::uint64_t m_submitted = 0;
+    std::uint64_t m_written = 0;
+    bool m_stop = false;
+    // 后台线程定时设置，下一次写入时提交未满的数据块
+    std::atomic<bool> m_due { false };
+    // 正在分段写入的记录的字节数
+    std::size_t m_partBytes = 0;
+    std::thread m_thread;
+};
+
+} // namespace jumper
+
+#endif // LOGSINK_H
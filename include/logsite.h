@@ -0,0 +1,120 @@
+#ifndef LOGSITE_H
+#define LOGSITE_H
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "logtracer.h"
+
+namespace jumper {
+
+/**
+  * @brief 单个log调用点的信息，LogSite::List()返回的快照
+*/
+struct LogSiteInfo {
+    std::string file;
+    int line;
+    std::string function;
+    LogLevel level;
+    std::string format;
+    /// 此调用点当前是否输出
+    bool enabled;
+};
+
+/**
+  * @brief log调用点的静态描述（文件、行号、函数、级别、格式），由JLOG_xxx宏在第一次执行时创建并注册
+  * @note 每个调用点缓存自己是否输出，判断只需要一次relaxed原子读取，logger级别或者规则改变时重新计算
+  * @note 规则以"file"或者"file:line"匹配调用点，file匹配路径的末尾若干级，例如"rpc.cpp:120"、
+  *       "net/rpc.cpp"，规则为on时无论logger级别都输出，为off时都不输出，
+  *       同时匹配多条规则时带行号的优先，其次是更长的规则
+  * @note 规则对之后才注册的调用点同样生效，可以在调用点第一次执行之前设置
+*/
+class LogSite {
+public:
+    LogSite(Logger& logger, LogLevel level, const char* file, int line,
+        const char* function, const char* fmt);
+
+    ~LogSite();
+
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    /// 此调用点是否输出
+    inline bool IsEnabled() const
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    /// 输出一条log，第一个参数为宏传入的格式串，实际使用注册时解析好的格式
+    template<typename... Args>
+    void Log(const char*, const Args&... args) const;
+
+    /// 添加（或者替换）一条规则，返回当前匹配此规则的调用点数量
+    static std::size_t SetRule(const std::string& pattern, bool on);
+
+    /// 删除一条规则，匹配的调用点恢复按logger级别输出
+    static void ClearRule(const std::string& pattern);
+
+    /// 替换全部规则，由LogTracer应用配置时调用
+    static void SetRules(const std::map<std::string, bool>& rules);
+
+    /// 所有已注册的调用点
+    static std::vector<LogSiteInfo> List();
+
+private:
+    friend class Logger;
+
+    // 按logger级别和规则重新计算是否输出，调用者持有注册表锁
+    void refresh();
+
+    // 重新匹配规则并计算是否输出，调用者持有注册表锁
+    void rematch();
+
+    // 输出到的logger
+    Logger& m_logger;
+    LogLevel m_level;
+    const char* m_file;
+    int m_line;
+    const char* m_function;
+    // 注册时解析的格式，引用宏传入的字符串字面量
+    FmtView m_fmt;
+    // 匹配的规则，1表示on，-1表示off，0表示没有规则，由注册表锁保护
+    int m_rule = 0;
+    // 是否输出
+    std::atomic<bool> m_enabled { false };
+};
+
+/// 输出一条log，第一个参数为宏传入的格式串，实际使用注册时解析好的格式
+template<typename... Args>
+inline void LogSite::Log(const char*, const Args&... args) const
+{
+    std::ostream& os = (LV_ERROR == m_level) ? std::cerr : std::cout;
+    LogLocation where { m_file, m_line, m_function };
+
+    LogTracer::write_record(m_logger, os, m_level, true, true, &where, m_fmt, args...);
+}
+
+} // namespace jumper
+
+/// 通过logger输出一条lv级别的log（自带换行符），格式串必须是字符串字面量
+/// 调用点第一次执行时注册，之后每次执行只读取一次调用点的开关
+/// 注册只使用格式串，log参数只在调用点开启时求值一次
+#define JLOG_AT(logger, lv, fmt, ...)                                                       \
+    do {                                                                                    \
+        static jumper::LogSite jlog_site_((logger), (lv), __FILE__, __LINE__, __func__,     \
+            (fmt));                                                                         \
+        if (jlog_site_.IsEnabled())                                                         \
+        {                                                                                   \
+            jlog_site_.Log((fmt), ##__VA_ARGS__);                                           \
+        }                                                                                   \
+    } while (0)
+
+/// 通过根logger输出各级别的log
+#define JLOG_DEBUG(...) JLOG_AT(jumper::LogTracer::Root(), jumper::LV_DEBUG, __VA_ARGS__)
+#define JLOG_INFO(...) JLOG_AT(jumper::LogTracer::Root(), jumper::LV_INFO, __VA_ARGS__)
+#define JLOG_WARNING(...) JLOG_AT(jumper::LogTracer::Root(), jumper::LV_WARNING, __VA_ARGS__)
+#define JLOG_ERROR(...) JLOG_AT(jumper::LogTracer::Root(), jumper::LV_ERROR, __VA_ARGS__)
+
+#endif // LOGSITE_H
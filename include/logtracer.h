@@ -1,11 +1,19 @@
 #ifndef LOGTRACER_H
 #define LOGTRACER_H
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <map>
+#include <vector>
 
 #include "format.h"
+#include "flightrecorder.h"
+#include "loglayout.h"
+#include "logsink.h"
 
 namespace jumper {
 
@@ -23,6 +31,112 @@ const LogLevel LV_INFO = LogLevel::LOG_INFO;
 const LogLevel LV_WARNING = LogLevel::LOG_WARNING;
 const LogLevel LV_ERROR = LogLevel::LOG_ERROR;
 
+// log级别的数量
+const int kLogLevelCount = 4;
+
+/**
+  * @brief LogTracer运行时统计数据的快照，所有计数从程序启动开始累计
+  * @note 按级别统计的数组下标为 static_cast<int>(level) - 1
+  * @note 锁等待时间和格式化时间为抽样统计（每个线程每kStatsSampleRate条log抽样一次），
+  *       平均耗时 = xxxNs / xxxSamples
+*/
+struct LogStats {
+    /// 各级别实际输出的log条数
+    std::uint64_t emitted[kLogLevelCount];
+    /// 各级别因低于当前log级别而被过滤的log条数
+    std::uint64_t filtered[kLogLevelCount];
+    /// 写入终端的字节数（包括颜色控制符）
+    std::uint64_t consoleBytes;
+    /// 写入log文件的字节数
+    std::uint64_t fileBytes;
+    /// 抽样的锁等待总时间(ns)及抽样次数
+    std::uint64_t lockWaitNs;
+    std::uint64_t lockWaitSamples;
+    /// 抽样的格式化总时间(ns)及抽样次数
+    std::uint64_t formatNs;
+    std::uint64_t formatSamples;
+    /// 调用FlushTracer/FlushlnTracer的次数
+    std::uint64_t flushes;
+    /// 打开log文件失败的次数
+    std::uint64_t fileOpenFailures;
+    /// FlushDurable的调用次数及实际执行fdatasync的次数
+    std::uint64_t syncRequests;
+    std::uint64_t syncs;
+    /// 分段输出超长记录时，格式化中（例如operator<<中）又输出而被丢弃的log条数，只交给了飞行记录器
+    std::uint64_t nestedDropped;
+};
+
+/**
+  * @brief 一个log调用点的抽样耗时统计，LogTracer::Profile()返回的快照
+  * @note JLOG_xxx调用点按来源位置区分，其它log按格式串的内容区分（内容相同的格式串合并统计）
+  * @note 最多统计kProfileMaxSites个调用点，之后出现的新调用点合并到format为"(other)"的一项中
+  * @note 每个线程每kProfileSampleRate条log抽样一次，估计的调用次数为samples * kProfileSampleRate
+*/
+struct LogSiteProfile {
+    /// JLOG_xxx调用点的"file:line"，其它log为空
+    std::string site;
+    /// 格式串
+    std::string format;
+    /// 抽样的调用次数
+    std::uint64_t samples;
+    /// 抽样调用的log内容总字节数
+    std::uint64_t bytes;
+    /// 抽样调用格式化log内容的总时间(ns)
+    std::uint64_t formatNs;
+    /// 抽样调用写入终端和log文件的总时间(ns)，包括锁等待
+    std::uint64_t writeNs;
+};
+
+/**
+  * @brief LogTracer的配置，可以从配置文件加载，发布后作为不可变的快照使用
+  * @note 配置文件每行一项"key = value"，行首或者空白之后的'#'开始为注释，没有出现的项使用默认值：
+  *       level = INFO                 根logger的级别（DEBUG/INFO/WARNING/ERROR）
+  *       logger.net.rpc = DEBUG       命名logger的级别，没有出现的命名logger继承上级
+  *       file.path = ./logtracer.txt  log文件路径，为空时不写文件
+  *       file.mode = buffered         log文件写入方式（buffered/shared/shm/compressed）
+  *       file.atomic_size = 4096      shared方式下单次write()的最大字节数
+  *       file.ring_size = 4194304     shm方式下共享内存环形缓冲区的容量
+  *       file.block_size = 65536      compressed方式下每个压缩数据块的大小（最大65536）
+  *       file.index_interval = 0      索引间隔，0表示不生成索引
+  *       file.sync_level = off        不低于此级别的log写入后等待fdatasync（off/DEBUG/.../ERROR）
+  *       console = on                 是否输出到终端（on/off）
+  *       console.color = on           终端输出是否带颜色（on/off）
+  *       sanitize = off               是否转义字符串参数中的控制字符和无效的UTF-8（on/off）
+  *       profile = off                是否抽样统计每个调用点的格式化和写入耗时（on/off），见LogTracer::Profile
+  *       site.rpc.cpp:120 = on        JLOG_xxx调用点的开关规则（on/off），见LogSite
+  *       layout = %T [%l] %t %s:%# %m  log记录的布局，为空时为默认的"[LEVEL]:"头部，见LogLayout
+*/
+struct LogConfig {
+    LogLevel level = LV_INFO;
+    std::map<std::string, LogLevel> loggers;
+    /// 调用点规则，"file"或者"file:line"对应的开关
+    std::map<std::string, bool> sites;
+    std::string filePath;
+    FileMode fileMode = FileMode::FILE_BUFFERED;
+    std::size_t atomicSize = kAtomicWriteSize;
+    /// FILE_SHM方式下环形缓冲区的容量，file.path为共享内存名称
+    std::size_t ringSize = kShmRingSize;
+    /// FILE_COMPRESSED方式下数据块的大小
+    std::size_t blockSize = kLzBlockSize;
+    std::uint32_t indexInterval = 0;
+    bool console = true;
+    bool consoleColor = true;
+    /// 字符串参数是否经过清理，防止伪造log行或者插入终端控制序列
+    bool sanitize = false;
+    /// 是否抽样统计每个调用点的耗时
+    bool profile = false;
+    /// 不低于此级别的log写入文件后等待同步到磁盘，0表示关闭
+    int syncLevel = 0;
+    /// log记录的布局模式串，为空时使用默认的"[LEVEL]:"头部
+    std::string layout;
+
+    /// 解析配置文件的内容，失败时返回false，error为出错的行及原因
+    bool Parse(const std::string& text, std::string& error);
+
+    /// log文件的设置是否相同，不同时应用配置需要重新打开log文件
+    bool SameFile(const LogConfig& other) const;
+};
+
 // 内部命名空间 jumper_inner
 namespace jumper_inner {
 // log颜色表
@@ -32,31 +146,337 @@ const std::map<LogLevel, std::pair<std::string, std::string>> logHeaderMap {
     { LV_WARNING, { "\e[33m", "[WARNING]:" } },      // 黄色
     { LV_ERROR, { "\e[1;31m", "[ERROR]:" } },        // 红色（加粗）
 };
+
+// LogStats对应的计数器，全部使用relaxed原子操作，统计开销近似为零
+struct LogCounters {
+    std::atomic<std::uint64_t> emitted[kLogLevelCount];
+    std::atomic<std::uint64_t> filtered[kLogLevelCount];
+    std::atomic<std::uint64_t> consoleBytes;
+    std::atomic<std::uint64_t> fileBytes;
+    std::atomic<std::uint64_t> lockWaitNs;
+    std::atomic<std::uint64_t> lockWaitSamples;
+    std::atomic<std::uint64_t> formatNs;
+    std::atomic<std::uint64_t> formatSamples;
+    std::atomic<std::uint64_t> flushes;
+    std::atomic<std::uint64_t> fileOpenFailures;
+    std::atomic<std::uint64_t> syncRequests;
+    std::atomic<std::uint64_t> syncs;
+    std::atomic<std::uint64_t> nestedDropped;
+};
+
+// FlushDurable的后台同步线程
+class DurableSyncer;
+
+// 命名logger及log调用点的注册表锁，只在注册和修改级别、规则时使用
+std::mutex& registry_mutex();
+
+// relaxed累加
+inline void count(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1)
+{
+    counter.fetch_add(n, std::memory_order_relaxed);
+}
 } // namespace jumper_inner
 
+class LogTracer;
+class LogSite;
+
+/**
+  * @brief LogTracer::FlushDurable返回的句柄，等待请求之前写入的log同步到磁盘
+*/
+class FlushHandle {
+public:
+    explicit FlushHandle(std::uint64_t seq)
+        : m_seq(seq) {}
+
+    /// 同步是否已经完成（无论成功与否）
+    bool ready() const;
+
+    /// 等待同步完成，同步成功返回true
+    bool wait() const;
+
+    /// 最多等待timeout，超时或者同步失败返回false
+    bool wait_for(std::chrono::milliseconds timeout) const;
+
+private:
+    // 需要同步到的记录序号
+    std::uint64_t m_seq;
+};
+
+/**
+  * @brief 命名的logger，名称以'.'分隔表示层级，例如"net.rpc"的上级为"net"，"net"的上级为根logger
+  * @note 没有单独设置级别的logger继承上级的级别，每个logger缓存自己的有效级别，
+  *       判断是否输出只需要一次relaxed原子读取，输出路径上不查找map也不加锁
+  * @note 通过get_logger获取，logger创建后不会被销毁，可以长期持有引用
+*/
+class Logger {
+public:
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /// logger的全名，根logger为空字符串
+    inline const std::string& Name() const
+    {
+        return m_name;
+    }
+
+    /// 设置此logger的级别，没有单独设置级别的下级logger随之改变
+    void SetLevel(LogLevel level);
+
+    /// 取消单独设置的级别，改为继承上级的级别，对根logger无效
+    void ResetLevel();
+
+    /// 此logger当前生效的级别
+    inline LogLevel EffectiveLevel() const
+    {
+        return static_cast<LogLevel>(m_effective.load(std::memory_order_relaxed));
+    }
+
+    /// 此级别的log是否能显示
+    inline bool IsEnabled(LogLevel level) const
+    {
+        return static_cast<int>(level) >= m_effective.load(std::memory_order_relaxed);
+    }
+
+    /// Debug级别log输出，不带换行符
+    template<typename... Args>
+    inline void LogDebug(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_DEBUG, false, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LogDebug(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_DEBUG, false, fmt, args...);
+    }
+
+    /// Debug级别log输出，自带换行符
+    template<typename... Args>
+    inline void LoglnDebug(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_DEBUG, true, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LoglnDebug(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_DEBUG, true, fmt, args...);
+    }
+
+    /// Info级别log输出，不带换行符
+    template<typename... Args>
+    inline void LogInfo(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_INFO, false, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LogInfo(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_INFO, false, fmt, args...);
+    }
+
+    /// Info级别log输出，自带换行符
+    template<typename... Args>
+    inline void LoglnInfo(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_INFO, true, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LoglnInfo(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_INFO, true, fmt, args...);
+    }
+
+    /// Warning级别log输出，不带换行符
+    template<typename... Args>
+    inline void LogWarning(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_WARNING, false, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LogWarning(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_WARNING, false, fmt, args...);
+    }
+
+    /// Warning级别log输出，自带换行符
+    template<typename... Args>
+    inline void LoglnWarning(const std::string& log, const Args&... args) const
+    {
+        output(std::cout, LV_WARNING, true, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LoglnWarning(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cout, LV_WARNING, true, fmt, args...);
+    }
+
+    /// Error级别log输出，不带换行符
+    template<typename... Args>
+    inline void LogError(const std::string& log, const Args&... args) const
+    {
+        output(std::cerr, LV_ERROR, false, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LogError(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cerr, LV_ERROR, false, fmt, args...);
+    }
+
+    /// Error级别log输出，自带换行符
+    template<typename... Args>
+    inline void LoglnError(const std::string& log, const Args&... args) const
+    {
+        output(std::cerr, LV_ERROR, true, log, args...);
+    }
+
+    template<typename... Args>
+    inline void LoglnError(const Fmt& fmt, const Args&... args) const
+    {
+        output(std::cerr, LV_ERROR, true, fmt, args...);
+    }
+
+private:
+    friend class LogTracer;
+    friend class LogSite;
+    friend Logger& get_logger(const std::string& name);
+
+    Logger(const std::string& name, Logger* parent, int level);
+
+    // 此级别对应的log头部，下级logger在级别头部之后附加"[name] "
+    inline const std::string& header(LogLevel level) const
+    {
+        return m_headers[static_cast<int>(level) - 1];
+    }
+
+    // 重新计算有效级别并传递给继承级别的下级logger，同时刷新注册到此logger的调用点，
+    // 调用者持有注册表锁
+    void propagate();
+
+    // 格式化并输出一条log
+    template<typename F, typename... Args>
+    void output(std::ostream& os, LogLevel lv, bool newline,
+        const F& fmt, const Args&... args) const;
+
+    // 格式化log内容到buf，没有参数时直接输出（与LogTracer原有行为一致），格式串无效时内容为空
+    static void body(FmtBuffer& buf, const std::string& log)
+    {
+        buf.append(log);
+    }
+
+    static void body(FmtBuffer& buf, const Fmt& fmt)
+    {
+        buf.append(fmt.to_str());
+    }
+
+    static void body(FmtBuffer& buf, const FmtView& fmt)
+    {
+        fmt.append_to(buf);
+    }
+
+    template<typename T, typename... Args>
+    static void body(FmtBuffer& buf, const std::string& fmtStr, const T& t, const Args&... args)
+    {
+        Fmt fmt(fmtStr);
+        format_to(buf, fmt, t, args...);
+    }
+
+    template<typename F, typename T, typename... Args>
+    static void body(FmtBuffer& buf, const F& fmt, const T& t, const Args&... args)
+    {
+        format_to(buf, fmt, t, args...);
+    }
+
+    // 全名
+    std::string m_name;
+    // 上级logger，根logger为nullptr
+    Logger* m_parent;
+    // 下级logger，由注册表锁保护
+    std::vector<Logger*> m_children;
+    // 输出到此logger的调用点，由注册表锁保护
+    std::vector<LogSite*> m_sites;
+    // 单独设置的级别，0表示继承上级，由注册表锁保护
+    int m_level;
+    // 有效级别
+    std::atomic<int> m_effective;
+    // 各级别的log头部
+    std::string m_headers[kLogLevelCount];
+};
+
+/// 获取名为name的logger，不存在时创建（包括所有上级），空字符串表示根logger
+/// 只有获取时会加锁，应当获取一次后保存引用，而不是每次输出log前获取
+Logger& get_logger(const std::string& name);
+
 class LogTracer {
 public:
     /// 初始化LogTracer环境
     /// 设置log输出路径，并添加时间戳，设置log输出级别，默认Info级别
     /// 如果没有将log记录到文件的需要，可不调用此函数
+    /// 新的log文件在锁外打开，之后只在交换时短暂持有锁，不会阻塞其它线程输出log
+    /// layout不为空时同时设置log记录的布局（见LogLayout），模式串在这里编译一次，错误时保持原有布局
     static void InitialTracer(LogLevel level = LV_INFO,
-        const std::string& logPath = "./logtracer.txt");
+        const std::string& logPath = "./logtracer.txt", const std::string& layout = "");
+
+    /// 应用一份配置：设置根logger和命名logger的级别，log文件的设置改变时重新打开log文件，
+    /// 最后发布为新的配置快照，输出log的线程在加锁之前登记并通过一次原子读取获得快照，不会被阻塞；
+    /// 发布者等待仍在读取旧快照的线程输出完当前的log后释放旧快照
+    static void ApplyConfig(const LogConfig& config);
+
+    /// 从配置文件加载并应用配置，文件无法读取或者格式错误时返回false，当前配置不变
+    static bool LoadConfig(const std::string& path);
+
+    /// 启动后台线程监视配置文件：立即加载一次，之后每interval检查一次，
+    /// 文件的修改时间改变或者进程收到SIGHUP时重新加载，重复调用会替换之前的监视
+    static bool WatchConfig(const std::string& path,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+
+    /// 停止监视配置文件，恢复原来的SIGHUP处理方式
+    static void UnwatchConfig();
+
+    /// 当前配置快照的副本
+    static LogConfig Config();
 
     /// 设置当前log输出等级，影响之后的log输出，之前的不受影响
+    /// 即设置根logger的级别，没有单独设置级别的命名logger随之改变
     inline static void SetLogLevel(LogLevel level)
     {
-        s_level = level;
+        s_root.SetLevel(level);
+    }
+
+    /// 根logger，LogTracer的静态log函数都通过它输出
+    inline static Logger& Root()
+    {
+        return s_root;
     }
 
+    /// 设置log文件的索引间隔，每interval条log在log文件路径加".idx"的索引文件中生成一项索引
+    /// 0表示不生成索引（默认），在InitialTracer之前调用，之后打开的log文件生效
+    /// 索引文件可以由jlog_query按时间范围和log级别快速查询
+    static void SetIndexInterval(std::uint32_t interval);
+
+    /// 设置log文件的写入方式，在InitialTracer之前调用，之后打开的log文件生效
+    /// FILE_SHARED方式下多个进程可以同时追加同一个log文件，每条记录最多atomicSize字节一次写入，
+    /// 超长的记录被拆分并加上续接标记，不生成索引
+    /// FILE_SHM方式下log路径为共享内存名称，由jlogd进程写入文件，容量见LogConfig::ringSize
+    /// FILE_COMPRESSED方式下记录按数据块在后台线程压缩后写入，使用jlog_cat查看，不生成索引
+    static void SetFileMode(FileMode mode, std::size_t atomicSize = kAtomicWriteSize);
+
     /// 刷新log显示
     inline static void FlushTracer()
     {
+        jumper_inner::count(s_counters.flushes);
         std::cout << std::flush;
     }
 
     /// 刷新log并换行
     inline static void FlushlnTracer()
     {
+        jumper_inner::count(s_counters.flushes);
         std::cout << std::endl;
     }
 
@@ -64,125 +484,155 @@ public:
     inline static void FinalTracer()
     {
         FlushTracer();
-        if (s_ofs.is_open())
-        {
-            s_ofs.close();
-        }
+
+        // 在锁外关闭log文件
+        std::unique_ptr<LogSink> file;
+        swap_file(file);
     }
 
+    /// 请求将此前写入log文件的所有记录通过fdatasync同步到磁盘，返回可等待的句柄
+    /// 同步由后台线程完成，同步期间到达的请求由下一次同步一并完成（组提交），
+    /// 多个线程同时请求时共享同一次fdatasync
+    static FlushHandle FlushDurable();
+
     /// 获取当前时间戳，精度秒
     static std::string TimeStamp();
 
+    /// 设置当前线程在log布局（%N）中显示的线程名，同时设置系统中的线程名（最多15个字符）
+    static void SetThreadName(const std::string& name);
+
+    /// 每个线程每多少条log抽样统计一次耗时，必须是2的幂
+    static const unsigned kStatsSampleRate = 64;
+
+    /// 格式化log内容的缓冲区大小，更长的log在锁内分段写入log文件和终端，不在内存中完整保存
+    static const std::size_t kRecordBufferSize = 64 << 10;
+
+    /// 获取运行时统计数据的快照，可被监控程序周期性调用
+    static LogStats Stats();
+
+    /// 开启profile配置后，每个线程每多少条log抽样统计一次调用点的耗时，必须是2的幂
+    static const unsigned kProfileSampleRate = 64;
+
+    /// 调用点耗时统计最多记录的调用点数，动态生成的格式串不会使统计表无限增长
+    static const std::size_t kProfileMaxSites = 1024;
+
+    /// 所有调用点的抽样耗时统计，按总耗时（格式化 + 写入）从高到低排列
+    static std::vector<LogSiteProfile> Profile();
+
+    /// 输出总耗时最高的top个调用点：估计的调用次数、平均格式化和写入耗时、平均字节数
+    static void DumpProfile(std::ostream& os = std::cerr, std::size_t top = 20);
+
+    /// 清空调用点的耗时统计
+    static void ResetProfile();
+
     /// Debug级别log输出，不带换行符
     template<typename... Args>
     inline static void LogDebug(const std::string& log, const Args&... args)
     {
-        print(std::cout, LV_DEBUG, log, args...);
+        s_root.LogDebug(log, args...);
     }
 
     template<typename... Args>
     inline static void LogDebug(const Fmt& fmt, const Args&... args)
     {
-        print(std::cout, LV_DEBUG, fmt, args...);
+        s_root.LogDebug(fmt, args...);
     }
 
     /// Debug级别log输出，自带换行符
     template<typename... Args>
     inline static void LoglnDebug(const std::string& log, const Args&... args)
     {
-        println(std::cout, LV_DEBUG, log, args...);
+        s_root.LoglnDebug(log, args...);
     }
 
     template<typename... Args>
     inline static void LoglnDebug(const Fmt& fmt, const Args&... args)
     {
-        println(std::cout, LV_DEBUG, fmt, args...);
+        s_root.LoglnDebug(fmt, args...);
     }
 
     /// Info级别log输出，不带换行符
     template<typename... Args>
     inline static void LogInfo(const std::string& log, const Args&... args)
     {
-        print(std::cout, LV_INFO, log, args...);
+        s_root.LogInfo(log, args...);
     }
 
     template<typename... Args>
     inline static void LogInfo(const Fmt& fmt, const Args&... args)
     {
-        print(std::cout, LV_INFO, fmt, args...);
+        s_root.LogInfo(fmt, args...);
     }
 
     /// Info级别log输出，自带换行符
     template<typename... Args>
     inline static void LoglnInfo(const std::string& log, const Args&... args)
     {
-        println(std::cout, LV_INFO, log, args...);
+        s_root.LoglnInfo(log, args...);
     }
 
     template<typename... Args>
     inline static void LoglnInfo(const Fmt& fmt, const Args&... args)
     {
-        println(std::cout, LV_INFO, fmt, args...);
+        s_root.LoglnInfo(fmt, args...);
     }
 
     /// Warning级别log输出，不带换行符
     template<typename... Args>
     inline static void LogWarning(const std::string& log, const Args&... args)
     {
-        print(std::cout, LV_WARNING, log, args...);
+        s_root.LogWarning(log, args...);
     }
 
     template<typename... Args>
     inline static void LogWarning(const Fmt& fmt, const Args&... args)
     {
-        print(std::cout, LV_WARNING, fmt, args...);
+        s_root.LogWarning(fmt, args...);
     }
 
     /// Warning级别log输出，自带换行符
     template<typename... Args>
     inline static void LoglnWarning(const std::string& log, const Args&... args)
     {
-        println(std::cout, LV_WARNING, log, args...);
+        s_root.LoglnWarning(log, args...);
     }
 
     template<typename... Args>
     inline static void LoglnWarning(const Fmt& fmt, const Args&... args)
     {
-        println(std::cout, LV_WARNING, fmt, args...);
+        s_root.LoglnWarning(fmt, args...);
     }
 
     /// Error级别log输出，不带换行符
     template<typename... Args>
     inline static void LogError(const std::string& log, const Args&... args)
     {
-        print(std::cerr, LV_ERROR, log, args...);
+        s_root.LogError(log, args...);
     }
 
     template<typename... Args>
     inline static void LogError(const Fmt& fmt, const Args&... args)
     {
-        print(std::cerr, LV_ERROR, fmt, args...);
+        s_root.LogError(fmt, args...);
     }
 
     /// Error级别log输出，自带换行符
     template<typename... Args>
     inline static void LoglnError(const std::string& log, const Args&... args)
     {
-        println(std::cerr, LV_ERROR, log, args...);
+        s_root.LoglnError(log, args...);
     }
 
     template<typename... Args>
     inline static void LoglnError(const Fmt& fmt, const Args&... args)
     {
-        println(std::cerr, LV_ERROR, fmt, args...);
+        s_root.LoglnError(fmt, args...);
     }
 
 private:
-    // 此log级别是否能显示，只有大于设置的log级别才能显示
-    inline static bool is_show(LogLevel level)
-    {
-        return static_cast<int>(level) >= static_cast<int>(s_level);
-    }
+    friend class Logger;
+    friend class LogSite;
+    friend class jumper_inner::DurableSyncer;
 
     // 此log级别对应的log颜色
     inline static const std::string& log_color(LogLevel level)
@@ -192,197 +642,466 @@ private:
         return iter->second.first;
     }
 
-    // 此log级别对应的log头部
-    inline static const std::string& log_header(LogLevel level)
+    // 此log级别是否需要格式化，能显示或者飞行记录器开启时都需要
+    // 不需要格式化的log直接计入过滤统计
+    inline static bool is_traced(const Logger& logger, LogLevel level)
     {
-        auto iter = jumper_inner::logHeaderMap.find(level);
+        if (logger.IsEnabled(level) || FlightRecorder::IsEnabled())
+        {
+            return true;
+        }
+        jumper_inner::count(s_counters.filtered[static_cast<int>(level) - 1]);
 
-        return iter->second.second;
+        return false;
     }
 
-    // 输出log，不带换行符
-    template<typename T, typename... Args>
-    inline static std::ostream& print(std::ostream& os, LogLevel lv,
-        const std::string& log, const T& t, const Args&... args)
+    // 这次调用是否需要抽样计时，calls为当前线程此项统计的调用计数
+    // 格式化和加锁各自计数，每条log各计一次，两者都是每kStatsSampleRate条抽样一次
+    inline static bool is_sampled(unsigned& calls)
     {
-        if (!is_show(lv))
-        {
-            return os;
-        }
+        return 0 == (++calls & (kStatsSampleRate - 1));
+    }
+
+    // 开启profile时当前线程的这次调用是否抽样统计调用点耗时
+    inline static bool is_profiled()
+    {
+        static thread_local unsigned t_calls = 0;
+
+        return s_profile.load(std::memory_order_relaxed)
+            && 0 == (++t_calls & (kProfileSampleRate - 1));
+    }
+
+    // 调用点耗时统计中的格式串
+    inline static const char* profile_format(const std::string& fmt)
+    {
+        return fmt.c_str();
+    }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        auto body(jumper::format(log, t, args...));
-        std::lock_guard<std::mutex> lock(s_mutex);
+    inline static const char* profile_format(const Fmt& fmt)
+    {
+        return fmt.to_str().c_str();
+    }
+
+    // FmtView只用于JLOG_xxx调用点，引用宏传入的字符串字面量
+    inline static const char* profile_format(const FmtView& fmt)
+    {
+        return fmt.data();
+    }
+
+    // 记录一次抽样的调用点耗时，where为nullptr时按格式串的内容区分调用点
+    static void profile(const LogLocation* where, const char* fmt, std::size_t bytes,
+        std::chrono::steady_clock::duration formatTime,
+        std::chrono::steady_clock::duration writeTime);
+
+    // 格式化log内容，抽样统计格式化耗时，按配置清理字符串参数
+    template<typename F, typename... Args>
+    inline static void format_body(FmtBuffer& buf, const F& fmt, const Args&... args)
+    {
+        static thread_local unsigned t_calls = 0;
 
-        if (s_ofs.is_open())
+        buf.set_sanitize(s_sanitize.load(std::memory_order_relaxed));
+        if (!is_sampled(t_calls))
         {
-            s_ofs << header << body;
+            Logger::body(buf, fmt, args...);
+            return;
         }
 
-        return (os << color << header << body << "\e[0m");
+        auto begin = std::chrono::steady_clock::now();
+        Logger::body(buf, fmt, args...);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        jumper_inner::count(s_counters.formatNs, static_cast<std::uint64_t>(ns));
+        jumper_inner::count(s_counters.formatSamples);
     }
 
-    template<typename T, typename... Args>
-    inline static std::ostream& print(std::ostream& os, LogLevel lv,
-        const Fmt& fmt, const T& t, const Args&... args)
+    // 当前线程正在分段输出超长的记录，持有s_mutex
+    inline static bool& streaming()
     {
-        if (!is_show(lv))
+        static thread_local bool t_streaming = false;
+
+        return t_streaming;
+    }
+
+    // 当前线程复用的log内容缓冲区，格式化时又输出log（例如operator<<中输出log）时使用临时的缓冲区
+    class RecordBuffer {
+    public:
+        RecordBuffer()
+            : m_owner(!busy())
         {
-            return os;
+            if (m_owner)
+            {
+                busy() = true;
+                shared().clear();
+            }
         }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        auto body(jumper::format(fmt, t, args...));
-        std::lock_guard<std::mutex> lock(s_mutex);
-
-        if (s_ofs.is_open())
+        ~RecordBuffer()
         {
-            s_ofs << header << body;
+            if (m_owner)
+            {
+                shared().set_sink(nullptr, 0);
+                busy() = false;
+            }
         }
 
-        return (os << color << header << body << "\e[0m");
-    }
+        RecordBuffer(const RecordBuffer&) = delete;
+        RecordBuffer& operator=(const RecordBuffer&) = delete;
 
-    // 输出log，不带换行符
-    inline static std::ostream& print(std::ostream& os,
-        LogLevel lv, const std::string& log)
-    {
-        if (!is_show(lv))
+        inline FmtBuffer& get()
         {
-            return os;
+            return m_owner ? shared() : m_nested;
         }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        std::lock_guard<std::mutex> lock(s_mutex);
+    private:
+        static FmtBuffer& shared()
+        {
+            static thread_local FmtBuffer t_buf;
+
+            return t_buf;
+        }
 
-        if (s_ofs.is_open())
+        static bool& busy()
         {
-            s_ofs << header << log;
+            static thread_local bool t_busy = false;
+
+            return t_busy;
         }
 
-        return (os << color << header << log << "\e[0m");
-    }
+        bool m_owner;
+        FmtBuffer m_nested;
+    };
 
-    inline static std::ostream& print(std::ostream& os,
-        LogLevel lv, const Fmt& fmt)
-    {
-        if (!is_show(lv))
+    // 读取配置快照的线程数，按线程分散到kReaderStripes组，避免所有线程争用同一个缓存行；
+    // 每组按纪元的奇偶各有一个计数，发布者翻转纪元后等待旧奇偶的计数归零
+    static const unsigned kReaderStripes = 32;
+
+    struct alignas(64) ReaderCount {
+        std::atomic<std::uint32_t> count[2];
+    };
+
+    // 配置快照的读取者：acquire()在加锁之前用一次原子读取获得快照，持有期间快照不会被释放，
+    // release()或者析构时退出；同一线程可以嵌套读取
+    class ConfigReader {
+    public:
+        ConfigReader() = default;
+
+        ~ConfigReader()
         {
-            return os;
+            release();
         }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        std::lock_guard<std::mutex> lock(s_mutex);
+        ConfigReader(const ConfigReader&) = delete;
+        ConfigReader& operator=(const ConfigReader&) = delete;
 
-        if (s_ofs.is_open())
+        inline const LogConfig& acquire()
         {
-            s_ofs << header << fmt.to_str();
+            static thread_local unsigned t_stripe =
+                s_nextStripe.fetch_add(1, std::memory_order_relaxed) % kReaderStripes;
+
+            // 先登记再读取：发布者在替换快照之后才检查计数，读到旧快照的线程一定已被计入
+            auto& counts = s_readers[t_stripe].count;
+            m_count = &counts[s_readerEpoch.load(std::memory_order_seq_cst) & 1];
+            m_count->fetch_add(1, std::memory_order_seq_cst);
+
+            return *s_config.load(std::memory_order_seq_cst);
         }
 
-        return (os << color << header << fmt.to_str() << "\e[0m");
-    }
+        inline void release()
+        {
+            if (m_count)
+            {
+                m_count->fetch_sub(1, std::memory_order_release);
+                m_count = nullptr;
+            }
+        }
 
-    // 输出log，自带换行符
-    template<typename T, typename... Args>
-    inline static std::ostream& println(std::ostream& os, LogLevel lv,
-        const std::string& log, const T& t, const Args&... args)
-    {
-        if (!is_show(lv))
+    private:
+        std::atomic<std::uint32_t>* m_count = nullptr;
+    };
+
+    // 超长记录的流式输出：log内容超过kRecordBufferSize时，第一次输出时加锁并写入头部，
+    // 之后的内容分段写入log文件和终端，finish()写入尾部并解锁
+    // log文件不支持分段写入时（shm方式）只拼接log文件允许的单条记录的最大字节数，超出部分截断
+    // 注意之后的格式化（包括用户的operator<<和formatter<T>）在s_mutex内进行，其中又输出的log被丢弃；
+    // 格式化抛出异常时析构函数结束被截断的记录并解锁
+    class RecordStream: public FmtSink {
+    public:
+        RecordStream(const Logger& logger, std::ostream& os, LogLevel lv, bool newline,
+            bool enabled, const LogLocation* where)
+            : m_logger(logger), m_os(os), m_lv(lv), m_newline(newline), m_enabled(enabled),
+              m_where(where) {}
+
+        ~RecordStream() override;
+
+        RecordStream(const RecordStream&) = delete;
+        RecordStream& operator=(const RecordStream&) = delete;
+
+        bool flush(const char* data, std::size_t len) override;
+
+        // 是否已经开始分段输出
+        inline bool started() const
         {
-            return os;
+            return m_started;
         }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        auto body(jumper::format(log, t, args...));
-        std::lock_guard<std::mutex> lock(s_mutex);
+        // 写入尾部并解锁，按策略等待持久化
+        void finish();
+
+    private:
+        // 第一次输出：交给飞行记录器，加锁后写入头部
+        void begin(const char* data, std::size_t len);
+
+        // 写入尾部和换行，结束分段输出并解锁，返回是否需要等待持久化
+        bool close();
+
+        const Logger& m_logger;
+        std::ostream& m_os;
+        LogLevel m_lv;
+        bool m_newline;
+        bool m_enabled;
+        const LogLocation* m_where;
+        bool m_started = false;
+        std::unique_lock<std::mutex> m_lock;
+        ConfigReader m_reader;
+        const LogConfig* m_config = nullptr;
+        const std::string* m_head = nullptr;
+        // log文件是否支持分段写入，不支持时在m_whole中拼接完整的内容，最多m_wholeLimit字节，
+        // 超出的字节数记入m_omitted，结束时加上截断标记
+        bool m_fileParts = false;
+        std::string m_whole;
+        std::size_t m_wholeLimit = 0;
+        std::size_t m_omitted = 0;
+    };
+
+    // 格式化并输出一条log：内容先写入当前线程的缓冲区，格式化完成后按write_log输出；
+    // 超过kRecordBufferSize时改为在锁内分段输出，缓冲区不会随之增长
+    template<typename F, typename... Args>
+    inline static void write_record(const Logger& logger, std::ostream& os, LogLevel lv,
+        bool newline, bool enabled, const LogLocation* where, const F& fmt, const Args&... args)
+    {
+        RecordBuffer record;
+        RecordStream stream(logger, os, lv, newline, enabled, where);
+        auto& buf = record.get();
+        bool profiled = is_profiled();
+        std::chrono::steady_clock::time_point begin, formatted;
 
-        if (s_ofs.is_open())
+        if (profiled)
         {
-            s_ofs << header << body << "\n";
+            begin = std::chrono::steady_clock::now();
+        }
+        buf.set_sink(&stream, kRecordBufferSize);
+        format_body(buf, fmt, args...);
+        auto bytes = buf.flushed() + buf.size();
+        if (profiled)
+        {
+            formatted = std::chrono::steady_clock::now();
         }
 
-        return (os << color << header << body << "\e[0m\n");
-    }
+        if (!stream.started())
+        {
+            write_log(logger, os, lv, buf.str(), newline, enabled, where);
+        }
+        else
+        {
+            buf.flush();
+            stream.finish();
+        }
 
-    template<typename T, typename... Args>
-    inline static std::ostream& println(std::ostream& os, LogLevel lv,
-        const Fmt& fmt, const T& t, const Args&... args)
-    {
-        if (!is_show(lv))
+        if (profiled)
         {
-            return os;
+            profile(where, profile_format(fmt), bytes, formatted - begin,
+                std::chrono::steady_clock::now() - formatted);
         }
+    }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        auto body(jumper::format(fmt, t, args...));
-        std::lock_guard<std::mutex> lock(s_mutex);
+    // 加锁，抽样统计锁等待耗时
+    inline static std::unique_lock<std::mutex> lock_tracer()
+    {
+        static thread_local unsigned t_calls = 0;
 
-        if (s_ofs.is_open())
+        if (!is_sampled(t_calls))
         {
-            s_ofs << header << body << "\n";
+            return std::unique_lock<std::mutex>(s_mutex);
         }
 
-        return (os << color << header << body << "\e[0m\n");
+        auto begin = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(s_mutex);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        jumper_inner::count(s_counters.lockWaitNs, static_cast<std::uint64_t>(ns));
+        jumper_inner::count(s_counters.lockWaitSamples);
+
+        return lock;
     }
 
-    // 输出log，自带换行符
-    inline static std::ostream& println(std::ostream& os,
-        LogLevel lv, const std::string& log)
+    // 输出一条格式化完成的log，所有print/println最终都汇聚到这里
+    // enabled为false时只交给飞行记录器，由调用者按logger级别或者调用点开关决定
+    // where为JLOG_xxx调用点的来源位置，其它log为nullptr
+    inline static std::ostream& write_log(const Logger& logger, std::ostream& os,
+        LogLevel lv, const std::string& body, bool newline, bool enabled,
+        const LogLocation* where = nullptr)
     {
-        if (!is_show(lv))
+        const auto& header(logger.header(lv));
+
+        // 飞行记录器记录所有级别的log，包括低于当前级别不显示的log
+        // 分段输出超长记录时格式化又输出的log只交给飞行记录器，不能再次加锁
+        FlightRecorder::Record(header, body);
+        if (!enabled)
         {
+            jumper_inner::count(s_counters.filtered[static_cast<int>(lv) - 1]);
             return os;
         }
+        if (streaming())
+        {
+            jumper_inner::count(s_counters.nestedDropped);
+            return os;
+        }
+
+        // 快照在加锁之前读取，修改配置不会阻塞输出log的线程，也不需要获取s_mutex
+        ConfigReader reader;
+        const auto& config = reader.acquire();
+        auto lock(lock_tracer());
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        std::lock_guard<std::mutex> lock(s_mutex);
+        bool durable = false;
+        const std::string* head = &header;
+        const std::string* text = &body;
 
-        if (s_ofs.is_open())
+        // 设置了布局时在锁内按布局生成头部，时间与记录在文件中的顺序一致
+        if (s_layout)
         {
-            s_ofs << header << log << "\n";
+            head = &s_layout->Render(s_head, s_tail, static_cast<int>(lv), logger.Name(), where);
+            if (!s_tail.empty())
+            {
+                s_record.assign(body).append(s_tail);
+                text = &s_record;
+            }
         }
 
-        return (os << color << header << log << "\e[0m\n");
-    }
+        jumper_inner::count(s_counters.emitted[static_cast<int>(lv) - 1]);
+        if (s_file)
+        {
+            jumper_inner::count(s_counters.fileBytes,
+                s_file->write(static_cast<int>(lv), *head, *text, newline));
+            ++s_fileSeq;
+            durable = config.syncLevel && static_cast<int>(lv) >= config.syncLevel;
+        }
+        if (config.console)
+        {
+            write_console(config, os, lv, *head, *text, newline);
+        }
+        lock.unlock();
 
-    inline static std::ostream& println(std::ostream& os,
-        LogLevel lv, const Fmt& fmt)
-    {
-        if (!is_show(lv))
+        // 按策略需要持久化的log，等待（与其它线程共享的）同步完成
+        if (durable)
         {
-            return os;
+            FlushDurable().wait();
         }
 
-        auto color(log_color(lv));
-        auto header(log_header(lv));
-        std::lock_guard<std::mutex> lock(s_mutex);
+        return os;
+    }
 
-        if (s_ofs.is_open())
+    // 输出到终端，调用者持有s_mutex
+    inline static void write_console(const LogConfig& config, std::ostream& os, LogLevel lv,
+        const std::string& header, const std::string& body, bool newline)
+    {
+        if (!config.consoleColor)
         {
-            s_ofs << header << fmt.to_str() << "\n";
+            jumper_inner::count(s_counters.consoleBytes,
+                header.length() + body.length() + newline);
+            os << header << body;
+            if (newline)
+            {
+                os << "\n";
+            }
+            return;
         }
 
-        return (os << color << header << fmt.to_str() << "\e[0m\n");
+        const auto& color(log_color(lv));
+        const char* reset = newline ? "\e[0m\n" : "\e[0m";
+        jumper_inner::count(s_counters.consoleBytes,
+            color.length() + header.length() + body.length() + (newline ? 5 : 4));
+        os << color << header << body << reset;
     }
 
+    // 替换log文件，请求过持久化时旧文件在关闭前同步到磁盘
+    static void swap_file(std::unique_ptr<LogSink>& file);
+
+    // 将当前log文件同步到磁盘，seq为同步覆盖到的记录序号，由同步线程调用
+    static bool sync_file(std::uint64_t& seq);
+
 private:
-    // 当前环境中的log级别，默认Info
-    static LogLevel s_level;
+    // 根logger，默认Info级别
+    static Logger s_root;
+
+    // log文件
+    static std::unique_ptr<LogSink> s_file;
 
-    // log文件输出流
-    static std::ofstream s_ofs;
+    // 已写入log文件的记录数，由s_mutex保护
+    static std::uint64_t s_fileSeq;
 
     // mutex锁
     static std::mutex s_mutex;
+
+    // 应用配置并发布快照，reopen为true时重新打开log文件，调用者持有s_configMutex
+    static void apply(const LogConfig& config, bool reopen);
+
+    // 按配置打开新的log文件并替换当前的log文件，只在交换时持有s_mutex
+    static void reopen_file(const LogConfig& config);
+
+    // 编译并替换log记录的布局，只在交换时持有s_mutex，调用者持有s_configMutex
+    static void swap_layout(const std::string& pattern);
+
+    // 编译后的log记录布局，nullptr表示默认的"[LEVEL]:"头部，由s_mutex保护
+    static std::unique_ptr<const LogLayout> s_layout;
+
+    // 按布局生成的头部、尾部以及附加尾部后的log内容，由s_mutex保护，重复使用已分配的内存
+    static std::string s_head;
+    static std::string s_tail;
+    static std::string s_record;
+
+    // 发布新的配置快照，等待读取旧快照的线程退出后释放旧快照，调用者持有s_configMutex
+    static void publish(const LogConfig* config);
+
+    // 等待纪元为parity时登记的读取者全部退出
+    static void wait_readers(unsigned parity);
+
+    // 当前的配置快照，输出log的线程通过ConfigReader在加锁之前读取
+    static std::atomic<const LogConfig*> s_config;
+
+    // 各组读取者的计数、当前纪元以及分配给下一个线程的组号
+    static ReaderCount s_readers[kReaderStripes];
+    static std::atomic<unsigned> s_readerEpoch;
+    static std::atomic<unsigned> s_nextStripe;
+
+    // 默认配置，作为第一个快照，不会被释放
+    static const LogConfig s_defaultConfig;
+
+    // 修改配置的锁，与输出log的s_mutex分开
+    static std::mutex s_configMutex;
+
+    // 运行时统计计数器
+    static jumper_inner::LogCounters s_counters;
+
+    // 是否清理字符串参数，格式化在锁外进行，不读取配置快照
+    static std::atomic<bool> s_sanitize;
+
+    // 是否抽样统计调用点耗时
+    static std::atomic<bool> s_profile;
 };
 
+// 格式化并输出一条log
+template<typename F, typename... Args>
+inline void Logger::output(std::ostream& os, LogLevel lv, bool newline,
+    const F& fmt, const Args&... args) const
+{
+    if (!LogTracer::is_traced(*this, lv))
+    {
+        return;
+    }
+
+    LogTracer::write_record(*this, os, lv, newline, IsEnabled(lv), nullptr, fmt, args...);
+}
+
 } // namespace jumper
 
 #endif // LOGTRACER_H
@@ -0,0 +1,73 @@
+#ifndef LZCODEC_H
+#define LZCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jumper {
+
+/// 压缩log文件中每个数据块的默认大小
+const std::size_t kLzBlockSize = 64 << 10;
+
+/// 单个数据块的最大大小，匹配的偏移量使用16位
+const std::size_t kLzMaxBlockSize = 64 << 10;
+
+/// 数据块头部的魔数
+const char kLzBlockMagic[4] = { 'J', 'L', 'Z', '1' };
+
+/**
+  * @brief 压缩log文件中每个数据块的头部，之后是packedSize字节的内容，使用本机字节序
+  * @note packedSize等于rawSize表示内容没有压缩（压缩后没有变小）
+  * @note 每个数据块单独压缩，不引用其它数据块的内容，可以单独解码
+*/
+struct LzBlockHeader {
+    char magic[4];
+    /// 解压后的字节数
+    std::uint32_t rawSize;
+    /// 头部之后的字节数
+    std::uint32_t packedSize;
+    /// 解压后内容的校验值，见lz_checksum
+    std::uint32_t checksum;
+};
+
+/// lz_decode_block的结果
+enum class LzStatus: int {
+    /// 解码成功
+    LZ_OK = 0,
+    /// 数据不完整，例如文件还在写入
+    LZ_INCOMPLETE = 1,
+    /// 数据块损坏
+    LZ_CORRUPT = 2,
+};
+
+/// 压缩len字节后最多需要的字节数
+inline std::size_t lz_bound(std::size_t len)
+{
+    return len + len / 255 + 16;
+}
+
+/**
+  * @brief LZ77系列的快速压缩：4字节哈希查找最近一次出现的位置，输出"字面量 + 匹配"序列
+  * @note 每个序列以一个字节开头，高4位为字面量长度，低4位为匹配长度-4，等于15时之后追加长度字节
+  *       （每个255表示继续），然后是字面量、2字节的匹配偏移量；最后一个序列只有字面量
+  * @note src最多kLzMaxBlockSize字节，dst至少有lz_bound(len)字节，返回压缩后的字节数
+*/
+std::size_t lz_compress(const char* src, std::size_t len, char* dst);
+
+/// 解压到dst，解压后的长度必须恰好为dstLen，输入损坏时返回false，不会越界读写
+bool lz_decompress(const char* src, std::size_t len, char* dst, std::size_t dstLen);
+
+/// FNV-1a方式的校验值，每次处理4个字节
+std::uint32_t lz_checksum(const char* data, std::size_t len);
+
+/// 将[data, data + len)压缩为一个带头部的数据块，追加到out
+void lz_encode_block(const char* data, std::size_t len, std::string& out);
+
+/// 解码data开头的一个数据块，内容追加到out，consumed为数据块的总字节数
+LzStatus lz_decode_block(const char* data, std::size_t len, std::string& out,
+    std::size_t& consumed);
+
+} // namespace jumper
+
+#endif // LZCODEC_H
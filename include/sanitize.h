@@ -0,0 +1,244 @@
+#ifndef SANITIZE_H
+#define SANITIZE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace jumper {
+
+// 内部命名空间 jumper_inner
+namespace jumper_inner {
+// 可以原样复制的单字节字符：0x20~0x7E的可打印ASCII字符
+inline bool is_plain(unsigned char c)
+{
+    return c >= 0x20 && c < 0x7F;
+}
+
+// 从头开始连续的可打印ASCII字符数，逐字节检查
+inline std::size_t plain_prefix_scalar(const char* data, std::size_t len)
+{
+    std::size_t i = 0;
+
+    while (i < len && is_plain(static_cast<unsigned char>(data[i])))
+    {
+        ++i;
+    }
+
+    return i;
+}
+
+// 从头开始连续的可打印ASCII字符数，SSE2/AVX2每次检查64字节，再在不干净的块中定位
+// 每个字节减去0x20后按无符号数比较：0x20~0x7E变为0~0x5E，其它字节都大于0x5E，
+// 多个向量先取逐字节最大值再比较一次，每64字节只需一次movemask
+inline std::size_t plain_prefix(const char* data, std::size_t len)
+{
+    std::size_t i = 0;
+
+    // 转义和多字节字符之间通常只有很短的ASCII片段，先逐字节检查，避免反复进入向量循环
+    for (std::size_t head = std::min<std::size_t>(len, 16); i < head; ++i)
+    {
+        if (!is_plain(static_cast<unsigned char>(data[i])))
+        {
+            return i;
+        }
+    }
+
+#if defined(__AVX2__)
+    const __m256i base32 = _mm256_set1_epi8(0x20);
+    const __m256i limit32 = _mm256_set1_epi8(0x5E);
+    auto shift32 = [data, &base32](std::size_t off) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + off));
+        return _mm256_sub_epi8(v, base32);
+    };
+    // 返回不是可打印字符的字节的位掩码
+    auto dirty32 = [&limit32](__m256i v) {
+        return ~static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_max_epu8(v, limit32), limit32)));
+    };
+    for (; i + 64 <= len; i += 64)
+    {
+        if (0 != dirty32(_mm256_max_epu8(shift32(i), shift32(i + 32))))
+        {
+            break;
+        }
+    }
+    for (; i + 32 <= len; i += 32)
+    {
+        unsigned mask = dirty32(shift32(i));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i base16 = _mm_set1_epi8(0x20);
+    const __m128i limit16 = _mm_set1_epi8(0x5E);
+    auto shift16 = [data, &base16](std::size_t off) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + off));
+        return _mm_sub_epi8(v, base16);
+    };
+    // 返回不是可打印字符的字节的位掩码
+    auto dirty16 = [&limit16](__m128i v) {
+        return ~static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_max_epu8(v, limit16), limit16))) & 0xFFFFu;
+    };
+    for (; i + 64 <= len; i += 64)
+    {
+        __m128i v = _mm_max_epu8(_mm_max_epu8(shift16(i), shift16(i + 16)),
+            _mm_max_epu8(shift16(i + 32), shift16(i + 48)));
+        if (0 != dirty16(v))
+        {
+            break;
+        }
+    }
+    for (; i + 16 <= len; i += 16)
+    {
+        unsigned mask = dirty16(shift16(i));
+        if (0 != mask)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    return i + plain_prefix_scalar(data + i, len - i);
+}
+
+// 以s开头的UTF-8多字节字符的长度，无效、不完整、超长编码、代理区或者C1控制字符返回0
+inline std::size_t utf8_length(const unsigned char* s, std::size_t len)
+{
+    auto cont = [s](std::size_t i) { return 0x80 == (s[i] & 0xC0); };
+    unsigned char c = s[0];
+
+    if (c < 0xC2)
+    {
+        return 0;
+    }
+    if (c < 0xE0)
+    {
+        // U+0080~U+009F为C1控制字符，部分终端把U+009B当作CSI
+        return (len >= 2 && cont(1) && !(0xC2 == c && s[1] < 0xA0)) ? 2 : 0;
+    }
+    if (c < 0xF0)
+    {
+        if (len < 3 || !cont(1) || !cont(2))
+        {
+            return 0;
+        }
+        return ((0xE0 == c && s[1] < 0xA0) || (0xED == c && s[1] >= 0xA0)) ? 0 : 3;
+    }
+    if (c < 0xF5)
+    {
+        if (len < 4 || !cont(1) || !cont(2) || !cont(3))
+        {
+            return 0;
+        }
+        return ((0xF0 == c && s[1] < 0x90) || (0xF4 == c && s[1] >= 0x90)) ? 0 : 4;
+    }
+
+    return 0;
+}
+
+// 输出一个需要转义的字节：\n、\r、\t，其它为\xHH
+template<typename Buffer>
+inline void write_escape(Buffer& out, unsigned char c)
+{
+    static const char s_hex[] = "0123456789abcdef";
+
+    switch (c)
+    {
+    case '\n':
+        out.append("\\n", 2);
+        break;
+    case '\r':
+        out.append("\\r", 2);
+        break;
+    case '\t':
+        out.append("\\t", 2);
+        break;
+    default:
+        {
+            char escaped[4] = { '\\', 'x', s_hex[c >> 4], s_hex[c & 0x0F] };
+            out.append(escaped, 4);
+        }
+        break;
+    }
+}
+
+// 清理[data, data + len)追加到out中，Simd为false时只逐字节检查，不进行向量读取
+template<bool Simd, typename Buffer>
+inline void sanitize_range(Buffer& out, const char* data, std::size_t len)
+{
+    auto bytes = reinterpret_cast<const unsigned char*>(data);
+    std::size_t run = 0;
+    std::size_t i = 0;
+
+    while (true)
+    {
+        i += Simd ? plain_prefix(data + i, len - i) : plain_prefix_scalar(data + i, len - i);
+        if (i == len)
+        {
+            break;
+        }
+
+        // 合法的UTF-8多字节字符属于同一段，不打断复制
+        if (bytes[i] >= 0x80)
+        {
+            auto n = utf8_length(bytes + i, len - i);
+            if (0 != n)
+            {
+                i += n;
+                continue;
+            }
+        }
+
+        out.append(data + run, i - run);
+        write_escape(out, bytes[i]);
+        run = ++i;
+    }
+    out.append(data + run, len - run);
+}
+} // namespace jumper_inner
+
+/**
+  * @brief 将不可信的字符串清理后追加到out中：控制字符（包括ESC）和无效的UTF-8字节被转义，
+  *        其它内容原样复制，清理后的结果不能伪造换行，也不能插入终端控制序列
+  * @note 连续的可打印ASCII字符以SSE2/AVX2批量检查，一段只追加一次，干净的输入接近memcpy的速度
+  * @note 反斜杠不转义，转义结果只用于阅读，不保证可以还原
+  * @note Buffer需要提供 append(const char*, std::size_t)，例如std::string、FmtBuffer
+*/
+template<typename Buffer>
+inline void sanitize_to(Buffer& out, const char* data, std::size_t len)
+{
+    // 短字符串本来就逐字节检查，单独处理后长度已知的短字符串（例如字面量）不会实例化向量读取
+    if (len <= 16)
+    {
+        jumper_inner::sanitize_range<false>(out, data, len);
+    }
+    else
+    {
+        jumper_inner::sanitize_range<true>(out, data, len);
+    }
+}
+
+/// 返回清理后的字符串
+inline std::string sanitize(const std::string& str)
+{
+    std::string out;
+
+    out.reserve(str.size());
+    sanitize_to(out, str.data(), str.size());
+
+    return out;
+}
+
+} // namespace jumper
+
+#endif // SANITIZE_H
@@ -0,0 +1,154 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include <sys/types.h>
+
+namespace jumper {
+
+/// 共享内存环形缓冲区的默认容量
+const std::size_t kShmRingSize = 4 << 20;
+
+// 内部命名空间 jumper_inner
+namespace jumper_inner {
+// 共享内存开头的控制块，写入端和读取端各自修改的位置放在不同的缓存行
+// 位置都是单调递增的字节数，对容量取模得到在数据区中的偏移量
+struct ShmRingHeader {
+    char magic[8];
+    std::uint64_t capacity;
+    std::int32_t pid;
+    // 0表示写入端正在使用，1表示写入端已经关闭
+    std::atomic<std::uint32_t> closed;
+    // 写入端已经发布的位置
+    alignas(64) std::atomic<std::uint64_t> head;
+    // 读取端已经读完的位置
+    alignas(64) std::atomic<std::uint64_t> tail;
+    // 因空间不足丢弃的记录数
+    alignas(64) std::atomic<std::uint64_t> dropped;
+};
+
+// 每条记录之前的长度和log级别，记录按8字节对齐
+struct ShmRecordHeader {
+    std::uint32_t size;
+    std::uint32_t level;
+};
+
+// 数据区末尾放不下一条记录时写入的填充标记，读取端跳到数据区开头
+const std::uint32_t kShmWrap = 0xFFFFFFFFu;
+
+// 数据区在共享内存中的偏移量
+const std::size_t kShmDataOffset = 256;
+
+static_assert(sizeof(ShmRingHeader) <= kShmDataOffset, "ShmRingHeader too large");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory ring needs lock-free 64-bit atomics");
+
+// 共享内存名称，没有以'/'开头时补上
+inline std::string shm_name(const std::string& name)
+{
+    return ('/' == name[0]) ? name : "/" + name;
+}
+} // namespace jumper_inner
+
+/**
+  * @brief POSIX共享内存中的单生产者单消费者环形缓冲区的写入端，写入只有memcpy和原子操作，没有系统调用
+  * @note 创建时替换同名的旧缓冲区，关闭时只做标记，不删除共享内存，由读取端（jlogd）读完后删除
+  * @note 空间不足时丢弃记录并计数，写入端永远不会等待读取端
+  * @note 同一时间只能有一个线程写入，LogTracer持有锁后调用
+*/
+class ShmRingWriter {
+public:
+    /// 创建名为name的共享内存，capacity向上取整为2的幂
+    ShmRingWriter(const std::string& name, std::size_t capacity);
+
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    inline bool is_open() const
+    {
+        return nullptr != m_header;
+    }
+
+    /// 单条记录的最大字节数
+    inline std::size_t max_record() const
+    {
+        return m_capacity / 4;
+    }
+
+    /// 预留一条len字节、level级别的记录，返回写入位置，空间不足或者超过max_record()时返回nullptr
+    char* reserve(std::size_t len, int level);
+
+    /// 发布reserve预留的记录，读取端之后才能看到
+    void commit();
+
+private:
+    jumper_inner::ShmRingHeader* m_header = nullptr;
+    char* m_data = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_mapSize = 0;
+    // 已经预留、尚未发布的位置
+    std::uint64_t m_pending = 0;
+};
+
+/**
+  * @brief 共享内存环形缓冲区的读取端，由jlogd使用
+*/
+class ShmRingReader {
+public:
+    ShmRingReader() = default;
+
+    ~ShmRingReader();
+
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    /// 附加到名为name的环形缓冲区，不存在或者尚未初始化完成时返回false
+    bool open(const std::string& name);
+
+    /// 解除映射，不删除共享内存
+    void close();
+
+    inline bool is_open() const
+    {
+        return nullptr != m_header;
+    }
+
+    /// 读取记录，内容依次追加到out，最多读取约maxBytes字节，返回读取的记录数
+    std::size_t read(std::string& out, std::size_t maxBytes);
+
+    /// 是否还有没有读取的记录
+    bool empty() const;
+
+    /// 写入端丢弃的记录数
+    std::uint64_t dropped() const;
+
+    /// 写入端的进程号
+    pid_t producer() const;
+
+    /// 写入端是否还在使用：没有关闭并且进程仍然存在
+    bool producer_alive() const;
+
+    /// 名称是否已经指向另一个环形缓冲区（写入端重新创建了同名的缓冲区）或者已被删除
+    bool replaced() const;
+
+    /// 名称仍然指向此环形缓冲区时删除共享内存，之后新的写入端可以重新创建
+    void unlink();
+
+private:
+    std::string m_name;
+    jumper_inner::ShmRingHeader* m_header = nullptr;
+    const char* m_data = nullptr;
+    std::size_t m_capacity = 0;
+    std::size_t m_mapSize = 0;
+    // 共享内存的设备号和inode，用于判断名称是否指向同一个缓冲区
+    dev_t m_dev = 0;
+    ino_t m_ino = 0;
+};
+
+} // namespace jumper
+
+#endif // SHMRING_H
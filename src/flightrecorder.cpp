@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "flightrecorder.h"
+
+namespace {
+
+// 每个线程独占的环形缓冲区，只由所属线程写入，信号处理函数只读
+struct Ring {
+    // 链表中的下一个缓冲区，发布之后不再修改
+    Ring* next = nullptr;
+    // 缓冲区编号，转储时用于区分线程
+    std::uint64_t id = 0;
+    // 是否有线程正在使用，线程退出后可以被新线程复用
+    std::atomic<bool> owned { true };
+    // 可保存的记录条数
+    std::size_t capacity = 0;
+    // 累计写入的记录条数
+    std::atomic<std::uint64_t> count { 0 };
+    // 每条记录的长度
+    unsigned short* lens = nullptr;
+    // capacity * kSlotSize 的记录存储区
+    char* slots = nullptr;
+};
+
+// 所有环形缓冲区组成的链表，只增不减，保证信号处理函数中无锁遍历
+std::atomic<Ring*> s_rings { nullptr };
+std::atomic<std::uint64_t> s_ringId { 0 };
+// 每个线程保留的记录条数
+std::atomic<std::size_t> s_capacity { 0 };
+// 转储文件路径，信号处理函数中不能使用std::string
+char s_dumpPath[1024] = { '\0' };
+
+// 需要捕获的致命信号，以及原有的处理函数
+const int s_signals[] = { SIGSEGV, SIGABRT, SIGBUS };
+struct sigaction s_oldActions[sizeof(s_signals) / sizeof(s_signals[0])];
+bool s_installed = false;
+
+// 线程退出时释放缓冲区的所有权，记录内容保留到被新记录覆盖为止
+struct RingHolder {
+    Ring* ring = nullptr;
+
+    ~RingHolder()
+    {
+        if (ring)
+        {
+            ring->owned.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local RingHolder t_holder;
+
+// 获取当前线程的环形缓冲区，优先复用已退出线程的缓冲区
+// 复用时不清空旧记录，已退出线程的最近记录对事后分析同样有价值
+Ring* acquire_ring()
+{
+    std::size_t capacity = s_capacity.load(std::memory_order_relaxed);
+
+    for (Ring* ring = s_rings.load(std::memory_order_acquire); ring; ring = ring->next)
+    {
+        bool expected = false;
+        if (ring->capacity == capacity &&
+            ring->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            return ring;
+        }
+    }
+
+    Ring* ring = new Ring;
+    ring->id = s_ringId.fetch_add(1, std::memory_order_relaxed);
+    ring->capacity = capacity;
+    ring->lens = new unsigned short[capacity]();
+    ring->slots = new char[capacity * jumper::FlightRecorder::kSlotSize];
+
+    Ring* head = s_rings.load(std::memory_order_relaxed);
+    do
+    {
+        ring->next = head;
+    } while (!s_rings.compare_exchange_weak(head, ring,
+        std::memory_order_release, std::memory_order_relaxed));
+
+    return ring;
+}
+
+// 异步信号安全的写入，处理短写
+void write_all(int fd, const char* data, std::size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(fd, data, len);
+        if (n <= 0)
+        {
+            return;
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+}
+
+void write_str(int fd, const char* str)
+{
+    write_all(fd, str, ::strlen(str));
+}
+
+// 异步信号安全的整数输出
+void write_num(int fd, std::uint64_t num)
+{
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+
+    do
+    {
+        *--p = static_cast<char>('0' + num % 10);
+        num /= 10;
+    } while (num != 0);
+
+    write_all(fd, p, static_cast<std::size_t>(end - p));
+}
+
+} // namespace
+
+const std::size_t jumper::FlightRecorder::kSlotSize;
+std::atomic<bool> jumper::FlightRecorder::s_enabled { false };
+
+/// 开启飞行记录器，设置转储文件路径以及每个线程保留的记录条数，并安装致命信号处理函数
+bool jumper::FlightRecorder::Enable(const std::string& dumpPath, std::size_t capacity)
+{
+    if (dumpPath.empty() || dumpPath.length() >= sizeof(s_dumpPath) || 0 == capacity)
+    {
+        return false;
+    }
+
+    std::size_t expected = 0;
+    s_capacity.compare_exchange_strong(expected, capacity);
+    ::memcpy(s_dumpPath, dumpPath.c_str(), dumpPath.length() + 1);
+
+    if (!s_installed)
+    {
+        struct sigaction action;
+        ::memset(&action, 0, sizeof(action));
+        action.sa_handler = &FlightRecorder::on_signal;
+        sigemptyset(&action.sa_mask);
+
+        for (std::size_t i = 0; i != sizeof(s_signals) / sizeof(s_signals[0]); ++i)
+        {
+            ::sigaction(s_signals[i], &action, &s_oldActions[i]);
+        }
+        s_installed = true;
+    }
+    s_enabled.store(true, std::memory_order_release);
+
+    return true;
+}
+
+/// 关闭飞行记录器并恢复原有的信号处理函数，已记录的内容仍然保留
+void jumper::FlightRecorder::Disable()
+{
+    s_enabled.store(false, std::memory_order_release);
+
+    if (s_installed)
+    {
+        for (std::size_t i = 0; i != sizeof(s_signals) / sizeof(s_signals[0]); ++i)
+        {
+            ::sigaction(s_signals[i], &s_oldActions[i], nullptr);
+        }
+        s_installed = false;
+    }
+}
+
+/// 向当前线程的环形缓冲区追加一条记录，header和body会被拼接为一条记录
+void jumper::FlightRecorder::Record(const std::string& header, const std::string& body)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+    if (!t_holder.ring)
+    {
+        t_holder.ring = acquire_ring();
+    }
+
+    Ring* ring = t_holder.ring;
+    std::uint64_t seq = ring->count.load(std::memory_order_relaxed);
+    std::size_t index = static_cast<std::size_t>(seq % ring->capacity);
+    char* slot = ring->slots + index * kSlotSize;
+
+    std::size_t headerLen = std::min(header.length(), kSlotSize);
+    std::size_t bodyLen = std::min(body.length(), kSlotSize - headerLen);
+    ::memcpy(slot, header.data(), headerLen);
+    ::memcpy(slot + headerLen, body.data(), bodyLen);
+    ring->lens[index] = static_cast<unsigned short>(headerLen + bodyLen);
+
+    ring->count.store(seq + 1, std::memory_order_release);
+}
+
+/// 将所有线程的记录按从旧到新的顺序写入fd，异步信号安全
+void jumper::FlightRecorder::Dump(int fd)
+{
+    for (Ring* ring = s_rings.load(std::memory_order_acquire); ring; ring = ring->next)
+    {
+        std::uint64_t count = ring->count.load(std::memory_order_acquire);
+        std::uint64_t first = count > ring->capacity ? count - ring->capacity : 0;
+
+        write_str(fd, "---- thread #");
+        write_num(fd, ring->id);
+        write_str(fd, ", records ");
+        write_num(fd, count - first);
+        write_str(fd, "/");
+        write_num(fd, count);
+        write_str(fd, " ----\n");
+
+        for (std::uint64_t seq = first; seq != count; ++seq)
+        {
+            std::size_t index = static_cast<std::size_t>(seq % ring->capacity);
+            const char* slot = ring->slots + index * kSlotSize;
+            std::size_t len = ring->lens[index];
+
+            write_all(fd, slot, len);
+            if (0 == len || '\n' != slot[len - 1])
+            {
+                write_all(fd, "\n", 1);
+            }
+        }
+    }
+}
+
+// 致命信号处理函数，转储记录后恢复原有处理函数并重新触发信号
+void jumper::FlightRecorder::on_signal(int sig)
+{
+    int fd = ::open(s_dumpPath, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd >= 0)
+    {
+        write_str(fd, "==== flight recorder: signal ");
+        write_num(fd, static_cast<std::uint64_t>(sig));
+        write_str(fd, " ====\n");
+        Dump(fd);
+        ::close(fd);
+    }
+
+    for (std::size_t i = 0; i != sizeof(s_signals) / sizeof(s_signals[0]); ++i)
+    {
+        if (s_signals[i] == sig)
+        {
+            ::sigaction(sig, &s_oldActions[i], nullptr);
+        }
+    }
+    ::raise(sig);
+}
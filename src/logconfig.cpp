@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "logtracer.h"
+
+namespace {
+
+// 去掉首尾空白
+std::string trim(const std::string& str)
+{
+    auto first = str.find_first_not_of(" \t\r");
+    if (std::string::npos == first)
+    {
+        return std::string();
+    }
+
+    return str.substr(first, str.find_last_not_of(" \t\r") - first + 1);
+}
+
+// 解析log级别，不区分大小写
+bool parse_level(const std::string& value, jumper::LogLevel& level)
+{
+    std::string name;
+    std::transform(value.begin(), value.end(), std::back_inserter(name), ::toupper);
+
+    for (const auto& kv: jumper::jumper_inner::logHeaderMap)
+    {
+        if ("[" + name + "]:" == kv.second.second)
+        {
+            level = kv.first;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// 注释的起始位置：行首或者空白之后的'#'，布局中的"%#"不是注释
+std::size_t comment_pos(const std::string& line)
+{
+    for (auto pos = line.find('#'); std::string::npos != pos; pos = line.find('#', pos + 1))
+    {
+        if (0 == pos || ' ' == line[pos - 1] || '\t' == line[pos - 1])
+        {
+            return pos;
+        }
+    }
+
+    return std::string::npos;
+}
+
+// 解析开关，on/off
+bool parse_switch(const std::string& value, bool& on)
+{
+    if ("on" == value || "off" == value)
+    {
+        on = ("on" == value);
+        return true;
+    }
+
+    return false;
+}
+
+// 解析非负整数
+template<typename T>
+bool parse_number(const std::string& value, T& number)
+{
+    char* end = nullptr;
+    auto n = std::strtoull(value.c_str(), &end, 10);
+
+    if (value.empty() || '\0' != *end || '-' == value[0])
+    {
+        return false;
+    }
+    number = static_cast<T>(n);
+
+    return true;
+}
+
+// 进程是否收到了SIGHUP，信号处理函数中只设置此标志
+std::atomic<bool> s_sighup { false };
+
+void on_sighup(int)
+{
+    s_sighup.store(true, std::memory_order_relaxed);
+}
+
+// 配置文件的修改时间和长度，用于判断文件是否被修改
+struct FileStamp {
+    struct timespec mtime {};
+    off_t size = -1;
+
+    bool operator!=(const FileStamp& other) const
+    {
+        return mtime.tv_sec != other.mtime.tv_sec || mtime.tv_nsec != other.mtime.tv_nsec
+            || size != other.size;
+    }
+};
+
+FileStamp file_stamp(const std::string& path)
+{
+    FileStamp stamp;
+    struct stat st;
+
+    if (0 == ::stat(path.c_str(), &st))
+    {
+        stamp.mtime = st.st_mtim;
+        stamp.size = st.st_size;
+    }
+
+    return stamp;
+}
+
+// 配置文件监视线程
+class ConfigWatcher {
+public:
+    ~ConfigWatcher()
+    {
+        stop();
+    }
+
+    bool start(const std::string& path, std::chrono::milliseconds interval)
+    {
+        stop();
+
+        m_path = path;
+        m_interval = interval;
+        m_stamp = file_stamp(path);
+        m_stop = false;
+
+        struct sigaction action {};
+        action.sa_handler = on_sighup;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        ::sigaction(SIGHUP, &action, &m_oldAction);
+
+        bool bRet = jumper::LogTracer::LoadConfig(path);
+        m_thread = std::thread(&ConfigWatcher::run, this);
+
+        return bRet;
+    }
+
+    void stop()
+    {
+        if (!m_thread.joinable())
+        {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        m_thread.join();
+        ::sigaction(SIGHUP, &m_oldAction, nullptr);
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (!m_cv.wait_for(lock, m_interval, [this]() { return m_stop; }))
+        {
+            auto stamp = file_stamp(m_path);
+            bool hup = s_sighup.exchange(false, std::memory_order_relaxed);
+
+            if (hup || stamp != m_stamp)
+            {
+                m_stamp = stamp;
+                // 加载配置时不持有监视线程的锁，stop()不会被阻塞
+                lock.unlock();
+                jumper::LogTracer::LoadConfig(m_path);
+                lock.lock();
+            }
+        }
+    }
+
+    std::string m_path;
+    std::chrono::milliseconds m_interval { 1000 };
+    FileStamp m_stamp;
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    struct sigaction m_oldAction {};
+};
+
+// 函数内的静态对象晚于LogTracer的静态成员构造，进程退出时先于它们析构
+ConfigWatcher& watcher()
+{
+    static ConfigWatcher s_watcher;
+
+    return s_watcher;
+}
+
+// 调用WatchConfig/UnwatchConfig的锁
+std::mutex s_watchMutex;
+
+} // namespace
+
+/// 解析配置文件的内容，失败时返回false，error为出错的行及原因
+bool jumper::LogConfig::Parse(const std::string& text, std::string& error)
+{
+    std::istringstream iss(text);
+    std::string line;
+    int lineNo = 0;
+
+    while (std::getline(iss, line))
+    {
+        ++lineNo;
+        line = trim(line.substr(0, comment_pos(line)));
+        if (line.empty())
+        {
+            continue;
+        }
+
+        auto eq = line.find('=');
+        if (std::string::npos == eq)
+        {
+            error = jumper::format("line {}: missing '='", lineNo);
+            return false;
+        }
+
+        auto key(trim(line.substr(0, eq)));
+        auto value(trim(line.substr(eq + 1)));
+        bool ok = true;
+
+        if ("level" == key)
+        {
+            ok = parse_level(value, level);
+        }
+        else if (0 == key.compare(0, 7, "logger.") && key.size() > 7)
+        {
+            ok = parse_level(value, loggers[key.substr(7)]);
+        }
+        else if (0 == key.compare(0, 5, "site.") && key.size() > 5)
+        {
+            ok = parse_switch(value, sites[key.substr(5)]);
+        }
+        else if ("file.path" == key)
+        {
+            filePath = value;
+        }
+        else if ("file.mode" == key)
+        {
+            ok = ("buffered" == value || "shared" == value || "shm" == value
+                || "compressed" == value);
+            fileMode = ("shared" == value) ? FileMode::FILE_SHARED
+                : ("shm" == value) ? FileMode::FILE_SHM
+                : ("compressed" == value) ? FileMode::FILE_COMPRESSED : FileMode::FILE_BUFFERED;
+        }
+        else if ("file.atomic_size" == key)
+        {
+            ok = parse_number(value, atomicSize);
+        }
+        else if ("file.ring_size" == key)
+        {
+            ok = parse_number(value, ringSize);
+        }
+        else if ("file.block_size" == key)
+        {
+            ok = parse_number(value, blockSize) && blockSize <= kLzMaxBlockSize;
+        }
+        else if ("file.index_interval" == key)
+        {
+            ok = parse_number(value, indexInterval);
+        }
+        else if ("file.sync_level" == key)
+        {
+            LogLevel lv = LV_ERROR;
+            ok = ("off" == value) || parse_level(value, lv);
+            syncLevel = ("off" == value) ? 0 : static_cast<int>(lv);
+        }
+        else if ("console" == key)
+        {
+            ok = parse_switch(value, console);
+        }
+        else if ("console.color" == key)
+        {
+            ok = parse_switch(value, consoleColor);
+        }
+        else if ("sanitize" == key)
+        {
+            ok = parse_switch(value, sanitize);
+        }
+        else if ("profile" == key)
+        {
+            ok = parse_switch(value, profile);
+        }
+        else if ("layout" == key)
+        {
+            // 空值表示默认布局，其它模式串在这里检查，应用配置时不会失败
+            std::string reason;
+            if (!value.empty() && !LogLayout().Compile(value, reason))
+            {
+                error = jumper::format("line {}: bad layout '{}', {}", lineNo, value, reason);
+                return false;
+            }
+            layout = value;
+        }
+        else
+        {
+            error = jumper::format("line {}: unknown key '{}'", lineNo, key);
+            return false;
+        }
+
+        if (!ok)
+        {
+            error = jumper::format("line {}: bad value '{}' for {}", lineNo, value, key);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// log文件的设置是否相同，不同时应用配置需要重新打开log文件
+bool jumper::LogConfig::SameFile(const LogConfig& other) const
+{
+    return filePath == other.filePath && fileMode == other.fileMode
+        && atomicSize == other.atomicSize && ringSize == other.ringSize
+        && blockSize == other.blockSize && indexInterval == other.indexInterval;
+}
+
+/// 从配置文件加载并应用配置，文件无法读取或者格式错误时返回false，当前配置不变
+bool jumper::LogTracer::LoadConfig(const std::string& path)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+    {
+        std::cerr << "[logtracer]: can't open config file:" << path << "\n";
+        return false;
+    }
+
+    std::string text((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    LogConfig config;
+    std::string error;
+
+    if (!config.Parse(text, error))
+    {
+        std::cerr << "[logtracer]: bad config file:" << path << ", " << error << "\n";
+        return false;
+    }
+    ApplyConfig(config);
+
+    return true;
+}
+
+/// 启动后台线程监视配置文件：立即加载一次，之后每interval检查一次，
+/// 文件的修改时间改变或者进程收到SIGHUP时重新加载，重复调用会替换之前的监视
+bool jumper::LogTracer::WatchConfig(const std::string& path, std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(s_watchMutex);
+
+    return watcher().start(path, interval);
+}
+
+/// 停止监视配置文件，恢复原来的SIGHUP处理方式
+void jumper::LogTracer::UnwatchConfig()
+{
+    std::lock_guard<std::mutex> lock(s_watchMutex);
+
+    watcher().stop();
+}
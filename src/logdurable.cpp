@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+#include <unistd.h>
+
+#include "logtracer.h"
+
+// 持久化同步的状态：请求的序号、已经完成同步的序号及后台同步线程
+class jumper::jumper_inner::DurableSyncer {
+public:
+    ~DurableSyncer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    // 请求同步到seq，必要时启动后台线程
+    void request(std::uint64_t seq)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_used.store(true, std::memory_order_relaxed);
+        if (!m_thread.joinable())
+        {
+            m_thread = std::thread(&DurableSyncer::run, this);
+        }
+        if (seq > m_requested)
+        {
+            m_requested = seq;
+            m_cv.notify_all();
+        }
+    }
+
+    bool ready(std::uint64_t seq)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_done >= seq;
+    }
+
+    bool wait(std::uint64_t seq)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_doneCv.wait(lock, [this, seq]() { return m_done >= seq; });
+
+        return m_synced >= seq;
+    }
+
+    bool wait_for(std::uint64_t seq, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        return m_doneCv.wait_for(lock, timeout, [this, seq]() { return m_done >= seq; })
+            && m_synced >= seq;
+    }
+
+    // 是否有线程请求过持久化
+    bool used() const
+    {
+        return m_used.load(std::memory_order_relaxed);
+    }
+
+    // 同步线程执行fdatasync期间持有此锁，替换log文件时持有此锁保证旧文件先同步
+    std::mutex& sync_mutex()
+    {
+        return m_syncMutex;
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (true)
+        {
+            m_cv.wait(lock, [this]() { return m_stop || m_requested > m_done; });
+            if (m_requested <= m_done)
+            {
+                break;
+            }
+
+            // 同步期间到达的请求不阻塞在m_mutex上，由下一次同步一并完成
+            lock.unlock();
+            std::uint64_t seq = 0;
+            bool ok = false;
+            {
+                std::lock_guard<std::mutex> syncLock(m_syncMutex);
+                ok = LogTracer::sync_file(seq);
+            }
+            lock.lock();
+
+            m_done = std::max(m_done, seq);
+            if (ok)
+            {
+                m_synced = std::max(m_synced, seq);
+            }
+            m_doneCv.notify_all();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::mutex m_syncMutex;
+    std::condition_variable m_cv;
+    std::condition_variable m_doneCv;
+    // 请求同步到的序号、已经尝试同步到的序号、已经成功同步到的序号
+    std::uint64_t m_requested = 0;
+    std::uint64_t m_done = 0;
+    std::uint64_t m_synced = 0;
+    std::atomic<bool> m_used { false };
+    bool m_stop = false;
+    std::thread m_thread;
+};
+
+namespace {
+
+// 函数内的静态对象晚于LogTracer的静态成员构造，进程退出时先于它们析构
+jumper::jumper_inner::DurableSyncer& syncer()
+{
+    static jumper::jumper_inner::DurableSyncer s_syncer;
+
+    return s_syncer;
+}
+
+} // namespace
+
+/// 同步是否已经完成（无论成功与否）
+bool jumper::FlushHandle::ready() const
+{
+    return syncer().ready(m_seq);
+}
+
+/// 等待同步完成，同步成功返回true
+bool jumper::FlushHandle::wait() const
+{
+    return syncer().wait(m_seq);
+}
+
+/// 最多等待timeout，超时或者同步失败返回false
+bool jumper::FlushHandle::wait_for(std::chrono::milliseconds timeout) const
+{
+    return syncer().wait_for(m_seq, timeout);
+}
+
+/// 请求将此前写入log文件的所有记录通过fdatasync同步到磁盘，返回可等待的句柄
+/// 同步由后台线程完成，同步期间到达的请求由下一次同步一并完成（组提交），
+/// 多个线程同时请求时共享同一次fdatasync
+jumper::FlushHandle jumper::LogTracer::FlushDurable()
+{
+    std::uint64_t seq = 0;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        seq = s_fileSeq;
+    }
+
+    jumper_inner::count(s_counters.syncRequests);
+    syncer().request(seq);
+
+    return FlushHandle(seq);
+}
+
+// 将当前log文件同步到磁盘，seq为同步覆盖到的记录序号，由同步线程调用
+bool jumper::LogTracer::sync_file(std::uint64_t& seq)
+{
+    bool hasFile = false;
+    int fd = -1;
+
+    // 只在交给内核时持有s_mutex，fdatasync使用复制的描述符在锁外进行
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        seq = s_fileSeq;
+        hasFile = static_cast<bool>(s_file);
+        if (hasFile)
+        {
+            s_file->flush();
+            if (s_file->fd() >= 0)
+            {
+                fd = ::dup(s_file->fd());
+            }
+        }
+    }
+
+    // 没有log文件时没有需要同步的内容
+    if (fd < 0)
+    {
+        return !hasFile;
+    }
+
+    jumper_inner::count(s_counters.syncs);
+    bool ok = (0 == ::fdatasync(fd));
+    ::close(fd);
+
+    return ok;
+}
+
+// 替换log文件，请求过持久化时旧文件在关闭前同步到磁盘
+void jumper::LogTracer::swap_file(std::unique_ptr<LogSink>& file)
+{
+    auto& durable = syncer();
+    std::lock_guard<std::mutex> syncLock(durable.sync_mutex());
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        file.swap(s_file);
+    }
+
+    // 同步线程之后只会同步新文件，旧文件中的记录必须在此之前同步
+    if (file && durable.used())
+    {
+        file->flush();
+        if (file->fd() >= 0)
+        {
+            jumper_inner::count(s_counters.syncs);
+            ::fdatasync(file->fd());
+        }
+    }
+}
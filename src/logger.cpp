@@ -0,0 +1,120 @@
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "logsite.h"
+
+using jumper::jumper_inner::registry_mutex;
+
+// 命名logger及log调用点的注册表锁，只在注册和修改级别、规则时使用
+std::mutex& jumper::jumper_inner::registry_mutex()
+{
+    static std::mutex s_mutex;
+
+    return s_mutex;
+}
+
+namespace {
+
+// 命名logger的注册表
+std::map<std::string, std::unique_ptr<jumper::Logger>>& registry()
+{
+    static std::map<std::string, std::unique_ptr<jumper::Logger>> s_loggers;
+
+    return s_loggers;
+}
+
+} // namespace
+
+// 根logger的构造函数使用logHeaderMap，必须与它定义在同一个编译单元中才能保证初始化顺序
+jumper::Logger jumper::LogTracer::s_root("", nullptr, static_cast<int>(jumper::LV_INFO));
+
+jumper::Logger::Logger(const std::string& name, Logger* parent, int level)
+    : m_name(name), m_parent(parent), m_level(level),
+      m_effective(level ? level : parent->m_effective.load(std::memory_order_relaxed))
+{
+    for (const auto& kv: jumper_inner::logHeaderMap)
+    {
+        auto& header = m_headers[static_cast<int>(kv.first) - 1];
+
+        header = kv.second.second;
+        if (!name.empty())
+        {
+            header += "[" + name + "] ";
+        }
+    }
+}
+
+/// 设置此logger的级别，没有单独设置级别的下级logger随之改变
+void jumper::Logger::SetLevel(LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    m_level = static_cast<int>(level);
+    propagate();
+}
+
+/// 取消单独设置的级别，改为继承上级的级别，对根logger无效
+void jumper::Logger::ResetLevel()
+{
+    if (!m_parent)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    m_level = 0;
+    propagate();
+}
+
+// 重新计算有效级别并传递给继承级别的下级logger，同时刷新注册到此logger的调用点，
+// 调用者持有注册表锁
+void jumper::Logger::propagate()
+{
+    m_effective.store(m_level ? m_level : m_parent->m_effective.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    for (auto site: m_sites)
+    {
+        site->refresh();
+    }
+    for (auto child: m_children)
+    {
+        if (0 == child->m_level)
+        {
+            child->propagate();
+        }
+    }
+}
+
+/// 获取名为name的logger，不存在时创建（包括所有上级），空字符串表示根logger
+/// 只有获取时会加锁，应当获取一次后保存引用，而不是每次输出log前获取
+jumper::Logger& jumper::get_logger(const std::string& name)
+{
+    Logger* logger = &LogTracer::Root();
+    if (name.empty())
+    {
+        return *logger;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    auto& loggers = registry();
+    std::size_t pos = 0;
+
+    // 依次查找或创建"net"、"net.rpc"...
+    while (std::string::npos != pos)
+    {
+        pos = name.find('.', pos + 1);
+
+        auto prefix(name.substr(0, pos));
+        auto& slot = loggers[prefix];
+        if (!slot)
+        {
+            slot.reset(new Logger(prefix, logger, 0));
+            logger->m_children.push_back(slot.get());
+        }
+        logger = slot.get();
+    }
+
+    return *logger;
+}
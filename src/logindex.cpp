@@ -0,0 +1,98 @@
+#include <chrono>
+
+#include "logindex.h"
+
+namespace {
+
+// 当前时间，自1970-01-01 00:00:00 UTC以来的毫秒数
+std::int64_t now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+/// 打开log文件对应的索引文件，offset为log文件当前的长度，interval为每项索引包含的记录数
+bool jumper::LogIndexWriter::open(const std::string& logPath, std::uint64_t offset,
+    std::uint32_t interval)
+{
+    close();
+
+    auto path(log_index_path(logPath));
+    m_ofs.open(path, std::ios_base::app | std::ios_base::binary);
+    if (!m_ofs.is_open())
+    {
+        return false;
+    }
+
+    // 新建的索引文件先写入魔数
+    if (0 == m_ofs.tellp())
+    {
+        m_ofs.write(kLogIndexMagic, sizeof(kLogIndexMagic));
+    }
+
+    m_interval = interval ? interval : 1;
+    m_offset = offset;
+    m_entry = LogIndexEntry {};
+
+    return true;
+}
+
+/// 写入未满的索引项并关闭索引文件
+void jumper::LogIndexWriter::close()
+{
+    if (!m_ofs.is_open())
+    {
+        return;
+    }
+
+    flush_entry();
+    m_ofs.close();
+}
+
+/// log文件中写入了bytes字节的非log记录（例如会话分隔符）
+void jumper::LogIndexWriter::skip(std::uint64_t bytes)
+{
+    // 索引项只描述连续的log记录
+    flush_entry();
+    m_offset += bytes;
+}
+
+/// log文件中写入了一条level级别、bytes字节的log记录
+void jumper::LogIndexWriter::record(int level, std::uint64_t bytes)
+{
+    auto now = now_ms();
+
+    if (0 == m_entry.count)
+    {
+        m_entry.offset = m_offset;
+        m_entry.beginMs = now;
+        m_entry.seq = m_seq;
+    }
+    // 结束时间为最后一条记录的时间，不是写入索引项的时间（未满的索引项在关闭或者skip时才写入）
+    m_entry.endMs = now;
+
+    ++m_entry.count;
+    ++m_seq;
+    m_entry.length += bytes;
+    m_entry.levelMask |= 1u << (level - 1);
+    m_offset += bytes;
+
+    if (m_entry.count == m_interval)
+    {
+        flush_entry();
+    }
+}
+
+// 写入当前索引项
+void jumper::LogIndexWriter::flush_entry()
+{
+    if (0 == m_entry.count)
+    {
+        return;
+    }
+
+    m_ofs.write(reinterpret_cast<const char*>(&m_entry), sizeof(m_entry));
+    m_entry = LogIndexEntry {};
+}
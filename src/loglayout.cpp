@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "logtracer.h"
+
+namespace {
+
+// 当前线程的线程号和线程名，第一次使用时获取
+struct ThreadInfo {
+    char id[24];
+    std::size_t idLength = 0;
+    std::string name;
+    bool named = false;
+};
+
+ThreadInfo& thread_info()
+{
+    static thread_local ThreadInfo t_info;
+
+    if (0 == t_info.idLength)
+    {
+        t_info.idLength = static_cast<std::size_t>(std::snprintf(t_info.id, sizeof(t_info.id),
+            "%ld", static_cast<long>(::syscall(SYS_gettid))));
+    }
+
+    return t_info;
+}
+
+// 当前线程的线程名，没有通过SetThreadName设置时读取一次系统中的线程名
+const std::string& thread_name()
+{
+    auto& info = thread_info();
+
+    if (!info.named)
+    {
+        char name[16] = {};
+        ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+        info.name = name;
+        info.named = true;
+    }
+
+    return info.name;
+}
+
+// 先写入栈上的缓冲区，最后一次追加到std::string，每个输出操作只是一次memcpy
+class LineWriter {
+public:
+    explicit LineWriter(std::string& out)
+        : m_out(out) {}
+
+    ~LineWriter()
+    {
+        m_out.append(m_buf, m_len);
+    }
+
+    inline void put(const char* str, std::size_t len)
+    {
+        if (len > sizeof(m_buf) - m_len)
+        {
+            m_out.append(m_buf, m_len);
+            m_len = 0;
+            if (len > sizeof(m_buf))
+            {
+                m_out.append(str, len);
+                return;
+            }
+        }
+        std::memcpy(m_buf + m_len, str, len);
+        m_len += len;
+    }
+
+    inline void put(const char* str)
+    {
+        put(str, std::strlen(str));
+    }
+
+    inline void put(char c)
+    {
+        put(&c, 1);
+    }
+
+private:
+    std::string& m_out;
+    char m_buf[256];
+    std::size_t m_len = 0;
+};
+
+// 输出当前时间，精确到秒的部分每个线程每秒只格式化一次
+void put_time(LineWriter& out)
+{
+    struct TimeCache {
+        std::time_t sec = -1;
+        char text[20];
+    };
+    static thread_local TimeCache t_time;
+
+    struct timespec ts;
+    ::clock_gettime(CLOCK_REALTIME, &ts);
+    if (ts.tv_sec != t_time.sec)
+    {
+        std::tm tm;
+        ::localtime_r(&ts.tv_sec, &tm);
+        ::strftime(t_time.text, sizeof(t_time.text), "%Y-%m-%d %H:%M:%S", &tm);
+        t_time.sec = ts.tv_sec;
+    }
+
+    auto ms = static_cast<unsigned>(ts.tv_nsec / 1000000);
+    char frac[4] = { '.', static_cast<char>('0' + ms / 100),
+        static_cast<char>('0' + ms / 10 % 10), static_cast<char>('0' + ms % 10) };
+    out.put(t_time.text, 19);
+    out.put(frac, sizeof(frac));
+}
+
+// 输出非负整数
+void put_uint(LineWriter& out, unsigned value)
+{
+    char digits[10];
+    char* p = digits + sizeof(digits);
+
+    do
+    {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (0 != value);
+    out.put(p, static_cast<std::size_t>(digits + sizeof(digits) - p));
+}
+
+// 各级别的名称，下标为log级别
+const char* const kLevelNames[] = { "", "DEBUG", "INFO", "WARNING", "ERROR" };
+
+} // namespace
+
+/// 编译模式串，失败时返回false，error为出错的原因，原有的布局不变
+bool jumper::LogLayout::Compile(const std::string& pattern, std::string& error)
+{
+    // 先解析为通用的操作，LEVEL对应'l'
+    std::vector<char> ops;
+    std::vector<std::string> texts;
+    bool hasMessage = false;
+
+    for (std::size_t i = 0; i < pattern.size(); ++i)
+    {
+        if ('%' != pattern[i] || (i + 1 < pattern.size() && '%' == pattern[i + 1]))
+        {
+            if (ops.empty() || '\0' != ops.back())
+            {
+                ops.push_back('\0');
+                texts.emplace_back();
+            }
+            texts.back().push_back(pattern[i]);
+            i += ('%' == pattern[i]);
+            continue;
+        }
+        if (++i == pattern.size())
+        {
+            error = "pattern ends with '%'";
+            return false;
+        }
+        if (std::string::npos == std::string("mTlntNs#f").find(pattern[i]))
+        {
+            error = std::string("unknown placeholder '%") + pattern[i] + "'";
+            return false;
+        }
+        if ('m' == pattern[i] && hasMessage)
+        {
+            error = "duplicate %m";
+            return false;
+        }
+        hasMessage = hasMessage || ('m' == pattern[i]);
+        ops.push_back(pattern[i]);
+        texts.emplace_back();
+    }
+
+    if (!hasMessage)
+    {
+        error = "missing %m";
+        return false;
+    }
+
+    // 再为每个级别生成一组操作：级别名称作为文本与相邻的文本合并，
+    // 与默认布局相同的"[%l]:%m"只需要一次追加
+    std::string text;
+    std::vector<Step> steps[kLevels];
+    std::size_t message[kLevels] = {};
+
+    for (int level = 0; level != kLevels; ++level)
+    {
+        auto& out = steps[level];
+        // %m两侧的文本分别输出到head和tail，不能合并
+        auto add_text = [&](const std::string& str) {
+            if (out.size() > message[level] && Op::TEXT == out.back().op)
+            {
+                out.back().length += static_cast<std::uint32_t>(str.size());
+            }
+            else
+            {
+                out.push_back({ Op::TEXT, static_cast<std::uint32_t>(text.size()),
+                    static_cast<std::uint32_t>(str.size()) });
+            }
+            text.append(str);
+        };
+
+        for (std::size_t i = 0; i != ops.size(); ++i)
+        {
+            switch (ops[i])
+            {
+            case '\0': add_text(texts[i]); break;
+            case 'l': add_text(kLevelNames[level]); break;
+            case 'm': message[level] = out.size(); break;
+            case 'T': out.push_back({ Op::TIME, 0, 0 }); break;
+            case 'n': out.push_back({ Op::LOGGER, 0, 0 }); break;
+            case 't': out.push_back({ Op::THREAD_ID, 0, 0 }); break;
+            case 'N': out.push_back({ Op::THREAD_NAME, 0, 0 }); break;
+            case 's': out.push_back({ Op::FILE, 0, 0 }); break;
+            case '#': out.push_back({ Op::LINE, 0, 0 }); break;
+            case 'f': out.push_back({ Op::FUNCTION, 0, 0 }); break;
+            }
+        }
+    }
+
+    m_pattern = pattern;
+    m_text.swap(text);
+    for (int level = 0; level != kLevels; ++level)
+    {
+        m_steps[level].swap(steps[level]);
+        m_message[level] = message[level];
+        // %m之前只有文本时，头部对每个级别都是常量，输出时直接使用
+        m_constHead[level] = std::all_of(m_steps[level].begin(),
+            m_steps[level].begin() + message[level],
+            [](const Step& step) { return Op::TEXT == step.op; });
+        m_heads[level].clear();
+        if (m_constHead[level])
+        {
+            run(m_heads[level], m_steps[level].data(), m_steps[level].data() + message[level],
+                std::string(), nullptr);
+        }
+    }
+
+    return true;
+}
+
+/// 按布局输出一条log记录除log内容以外的部分：%m之后的部分覆盖写入tail，返回%m之前的部分
+/// 头部不是常量时覆盖写入head并返回head
+const std::string& jumper::LogLayout::Render(std::string& head, std::string& tail, int level,
+    const std::string& name, const LogLocation* where) const
+{
+    const auto& steps = m_steps[level];
+    const Step* message = steps.data() + m_message[level];
+
+    tail.clear();
+    if (message != steps.data() + steps.size())
+    {
+        run(tail, message, steps.data() + steps.size(), name, where);
+    }
+    if (m_constHead[level])
+    {
+        return m_heads[level];
+    }
+
+    head.clear();
+    run(head, steps.data(), message, name, where);
+
+    return head;
+}
+
+// 执行[first, last)之间的输出操作
+void jumper::LogLayout::run(std::string& buf, const Step* first, const Step* last,
+    const std::string& name, const LogLocation* where) const
+{
+    LineWriter out(buf);
+
+    for (; first != last; ++first)
+    {
+        const Step& step = *first;
+
+        switch (step.op)
+        {
+        case Op::TEXT:
+            out.put(m_text.data() + step.offset, step.length);
+            break;
+        case Op::TIME:
+            put_time(out);
+            break;
+        case Op::LOGGER:
+            out.put(name.data(), name.size());
+            break;
+        case Op::THREAD_ID:
+            {
+                const auto& info = thread_info();
+                out.put(info.id, info.idLength);
+            }
+            break;
+        case Op::THREAD_NAME:
+            {
+                const auto& name = thread_name();
+                out.put(name.data(), name.size());
+            }
+            break;
+        case Op::FILE:
+            if (where)
+            {
+                const char* slash = std::strrchr(where->file, '/');
+                out.put(slash ? slash + 1 : where->file);
+            }
+            else
+            {
+                out.put('-');
+            }
+            break;
+        case Op::LINE:
+            if (where)
+            {
+                put_uint(out, static_cast<unsigned>(where->line));
+            }
+            else
+            {
+                out.put('-');
+            }
+            break;
+        case Op::FUNCTION:
+            out.put(where ? where->function : "-");
+            break;
+        }
+    }
+}
+
+/// 设置当前线程在log布局（%N）中显示的线程名，同时设置系统中的线程名（最多15个字符）
+void jumper::LogTracer::SetThreadName(const std::string& name)
+{
+    auto& info = thread_info();
+
+    info.name = name;
+    info.named = true;
+    ::pthread_setname_np(::pthread_self(), name.substr(0, 15).c_str());
+}
@@ -0,0 +1,422 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "logsink.h"
+
+namespace {
+
+// 压缩方式下最多等待压缩的数据块个数，超过时写入log的线程等待后台线程
+const std::size_t kMaxPendingBlocks = 64;
+// 压缩方式下最小的数据块大小
+const std::size_t kMinBlockSize = 1024;
+
+} // namespace
+
+/// 以追加方式打开log文件，indexInterval不为0时同时打开索引文件
+jumper::FileSink::FileSink(const std::string& path, std::uint32_t indexInterval)
+{
+    m_ofs.open(path, std::ios_base::app);
+    if (!m_ofs.is_open())
+    {
+        return;
+    }
+
+    m_syncFd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (0 == indexInterval)
+    {
+        return;
+    }
+
+    // 索引记录的是log记录在文件中的偏移量，从文件当前长度开始累计
+    struct stat st;
+    std::uint64_t offset = (0 == ::stat(path.c_str(), &st)) ? st.st_size : 0;
+
+    if (!m_index.open(path, offset, indexInterval))
+    {
+        std::cerr << "[logtracer]: can't open log index file:" << log_index_path(path) << "\n";
+    }
+}
+
+jumper::FileSink::~FileSink()
+{
+    m_index.close();
+    if (m_syncFd >= 0)
+    {
+        ::close(m_syncFd);
+    }
+}
+
+std::size_t jumper::FileSink::write(int level, const std::string& header,
+    const std::string& body, bool newline)
+{
+    m_ofs << header << body;
+    if (newline)
+    {
+        m_ofs << "\n";
+    }
+
+    auto bytes = header.length() + body.length() + newline;
+    index(level, bytes);
+
+    return bytes;
+}
+
+bool jumper::FileSink::write_begin(int level, const std::string& header)
+{
+    m_ofs << header;
+    m_partLevel = level;
+    m_partBytes = header.length();
+
+    return true;
+}
+
+std::size_t jumper::FileSink::write_end(bool newline)
+{
+    if (newline)
+    {
+        m_ofs << "\n";
+    }
+
+    auto bytes = m_partBytes + newline;
+    index(m_partLevel, bytes);
+
+    return bytes;
+}
+
+// 记录写入的字节数后更新索引
+void jumper::FileSink::index(int level, std::size_t bytes)
+{
+    if (!m_index.is_open())
+    {
+        return;
+    }
+
+    if (level > 0)
+    {
+        m_index.record(level, bytes);
+    }
+    else
+    {
+        m_index.skip(bytes);
+    }
+}
+
+jumper::AppendFileSink::AppendFileSink(const std::string& path, std::size_t atomicSize)
+    : m_fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+      // 至少要放得下拆分标记和一部分内容
+      m_atomicSize(std::max<std::size_t>(atomicSize, 64))
+{
+}
+
+jumper::AppendFileSink::~AppendFileSink()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+    }
+}
+
+std::size_t jumper::AppendFileSink::write(int, const std::string& header,
+    const std::string& body, bool newline)
+{
+    m_record.assign(header).append(body);
+    if (newline)
+    {
+        m_record.push_back('\n');
+    }
+
+    auto bytes = m_record.size();
+    if (bytes <= m_atomicSize)
+    {
+        jumper_inner::write_fd(m_fd, m_record.data(), bytes);
+    }
+    else
+    {
+        m_split = false;
+        write_pieces(true);
+    }
+
+    return bytes;
+}
+
+bool jumper::AppendFileSink::write_begin(int, const std::string& header)
+{
+    m_record.assign(header);
+    m_split = false;
+    m_partBytes = header.size();
+
+    return true;
+}
+
+void jumper::AppendFileSink::write_part(const char* data, std::size_t len)
+{
+    m_record.append(data, len);
+    m_partBytes += len;
+    if (m_record.size() > m_atomicSize)
+    {
+        write_pieces(false);
+    }
+}
+
+std::size_t jumper::AppendFileSink::write_end(bool newline)
+{
+    if (newline)
+    {
+        m_record.push_back('\n');
+        ++m_partBytes;
+    }
+    if (!m_split && m_record.size() <= m_atomicSize)
+    {
+        jumper_inner::write_fd(m_fd, m_record.data(), m_record.size());
+    }
+    else
+    {
+        write_pieces(true);
+    }
+
+    return m_partBytes;
+}
+
+// 拆分写入m_record中的内容，last为false时后面还有内容，只写入满atomicSize字节的段，
+// 剩余的内容留在m_record中
+void jumper::AppendFileSink::write_pieces(bool last)
+{
+    const char* data = m_record.data();
+    auto len = m_record.size();
+    // fork之后进程号会变化，每次拆分时重新获取
+    auto pid = std::to_string(::getpid());
+    std::string head("[" + pid + "->]:");
+    std::string tail("[->" + pid + "]\n");
+    std::size_t pos = 0;
+
+    while (pos < len)
+    {
+        m_piece.clear();
+        if (m_split)
+        {
+            m_piece.append(head);
+        }
+
+        auto n = len - pos;
+        auto room = m_atomicSize - m_piece.size();
+        if (n <= room && !last)
+        {
+            // 可能是最后一段，等待之后的内容
+            break;
+        }
+        if (n > room)
+        {
+            n = room - tail.size();
+            // 不在UTF-8字符的中间拆分
+            auto cut = n;
+            while (cut > 0 && 0x80 == (static_cast<unsigned char>(data[pos + cut]) & 0xC0))
+            {
+                --cut;
+            }
+            n = cut ? cut : n;
+        }
+
+        m_piece.append(data + pos, n);
+        pos += n;
+        if (pos < len)
+        {
+            m_piece.append(tail);
+        }
+        jumper_inner::write_fd(m_fd, m_piece.data(), m_piece.size());
+        m_split = true;
+    }
+    m_record.erase(0, pos);
+}
+
+std::size_t jumper::ShmSink::write(int level, const std::string& header,
+    const std::string& body, bool newline)
+{
+    auto len = std::min(header.length() + body.length() + newline, m_ring.max_record());
+    char* p = m_ring.reserve(len, level);
+    if (!p)
+    {
+        return 0;
+    }
+
+    // 截断时保留末尾的换行符
+    auto headLen = std::min(header.length(), len - newline);
+    auto bodyLen = len - newline - headLen;
+    std::memcpy(p, header.data(), headLen);
+    std::memcpy(p + headLen, body.data(), bodyLen);
+    if (newline)
+    {
+        p[len - 1] = '\n';
+    }
+    m_ring.commit();
+
+    return len;
+}
+
+jumper::CompressedFileSink::CompressedFileSink(const std::string& path, std::size_t blockSize)
+    : m_fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)),
+      m_blockSize(std::min(std::max(blockSize, kMinBlockSize), kLzMaxBlockSize))
+{
+    if (m_fd >= 0)
+    {
+        m_block.reserve(m_blockSize);
+        m_thread = std::thread(&CompressedFileSink::run, this);
+    }
+}
+
+jumper::CompressedFileSink::~CompressedFileSink()
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+
+    // 写入所有数据块后再关闭文件
+    submit();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_ready.notify_one();
+    m_thread.join();
+    ::close(m_fd);
+}
+
+std::size_t jumper::CompressedFileSink::write(int, const std::string& header,
+    const std::string& body, bool newline)
+{
+    auto bytes = header.length() + body.length() + newline;
+
+    if (m_due.load(std::memory_order_relaxed))
+    {
+        m_due.store(false, std::memory_order_relaxed);
+        submit();
+    }
+    // 放不下时先提交当前数据块，使记录不跨数据块
+    if (m_block.size() + bytes > m_blockSize)
+    {
+        submit();
+    }
+
+    append(header.data(), header.length());
+    append(body.data(), body.length());
+    if (newline)
+    {
+        append("\n", 1);
+    }
+
+    return bytes;
+}
+
+bool jumper::CompressedFileSink::write_begin(int, const std::string& header)
+{
+    append(header.data(), header.length());
+    m_partBytes = header.length();
+
+    return true;
+}
+
+std::size_t jumper::CompressedFileSink::write_end(bool newline)
+{
+    if (newline)
+    {
+        append("\n", 1);
+    }
+
+    return m_partBytes + newline;
+}
+
+void jumper::CompressedFileSink::flush()
+{
+    submit();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_written == m_submitted; });
+}
+
+// 追加到当前数据块，满时提交
+void jumper::CompressedFileSink::append(const char* data, std::size_t len)
+{
+    while (len > 0)
+    {
+        auto n = std::min(len, m_blockSize - m_block.size());
+        m_block.append(data, n);
+        data += n;
+        len -= n;
+        if (m_block.size() == m_blockSize)
+        {
+            submit();
+        }
+    }
+}
+
+// 将当前数据块交给后台线程，待压缩的数据块过多时等待
+void jumper::CompressedFileSink::submit()
+{
+    if (m_block.empty())
+    {
+        return;
+    }
+
+    std::string next;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending.size() < kMaxPendingBlocks; });
+        m_pending.push_back(std::move(m_block));
+        ++m_submitted;
+        if (!m_free.empty())
+        {
+            next = std::move(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    m_ready.notify_one();
+
+    m_block = std::move(next);
+    m_block.clear();
+    m_block.reserve(m_blockSize);
+}
+
+// 后台线程：压缩并写入数据块
+void jumper::CompressedFileSink::run()
+{
+    std::string out;
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        if (m_pending.empty())
+        {
+            if (m_stop)
+            {
+                break;
+            }
+            // 空闲超过1秒时请求提交未满的数据块
+            if (!m_ready.wait_for(lock, std::chrono::seconds(1),
+                [this] { return !m_pending.empty() || m_stop; }))
+            {
+                m_due.store(true, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        auto block = std::move(m_pending.front());
+        m_pending.pop_front();
+        lock.unlock();
+
+        out.clear();
+        lz_encode_block(block.data(), block.size(), out);
+        jumper_inner::write_fd(m_fd, out.data(), out.size());
+
+        lock.lock();
+        block.clear();
+        m_free.push_back(std::move(block));
+        ++m_written;
+        m_done.notify_all();
+    }
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "logsite.h"
+
+using jumper::jumper_inner::registry_mutex;
+
+namespace {
+
+// 所有已注册的调用点，由注册表锁保护
+std::vector<jumper::LogSite*>& sites()
+{
+    static std::vector<jumper::LogSite*> s_sites;
+
+    return s_sites;
+}
+
+// 开关规则，由注册表锁保护
+std::map<std::string, bool>& rules()
+{
+    static std::map<std::string, bool> s_rules;
+
+    return s_rules;
+}
+
+// 解析后的规则："file"或者"file:line"，line为0表示匹配整个文件
+struct SitePattern {
+    std::string file;
+    int line = 0;
+
+    explicit SitePattern(const std::string& pattern)
+        : file(pattern)
+    {
+        auto colon = pattern.rfind(':');
+        if (std::string::npos == colon || colon + 1 == pattern.size())
+        {
+            return;
+        }
+        for (auto pos = colon + 1; pos != pattern.size(); ++pos)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(pattern[pos])))
+            {
+                return;
+            }
+        }
+        file = pattern.substr(0, colon);
+        line = std::atoi(pattern.c_str() + colon + 1);
+    }
+
+    // 匹配完整路径或者路径末尾的若干级
+    bool match(const char* path, int siteLine) const
+    {
+        if (0 != line && line != siteLine)
+        {
+            return false;
+        }
+
+        std::size_t len = ::strlen(path);
+        if (file.size() > len || 0 != file.compare(0, std::string::npos, path + len - file.size()))
+        {
+            return false;
+        }
+
+        return file.size() == len || '/' == path[len - file.size() - 1];
+    }
+};
+
+// 调用点匹配的规则，1表示on，-1表示off，0表示没有规则，调用者持有注册表锁
+// 带行号的规则优先，其次是更长的规则
+int match_rule(const char* file, int line)
+{
+    int rule = 0;
+    std::size_t bestLength = 0;
+    bool bestLine = false;
+
+    for (const auto& kv: rules())
+    {
+        SitePattern pattern(kv.first);
+        if (!pattern.match(file, line))
+        {
+            continue;
+        }
+
+        bool hasLine = (0 != pattern.line);
+        if (0 == rule || hasLine > bestLine
+            || (hasLine == bestLine && pattern.file.size() > bestLength))
+        {
+            rule = kv.second ? 1 : -1;
+            bestLine = hasLine;
+            bestLength = pattern.file.size();
+        }
+    }
+
+    return rule;
+}
+
+} // namespace
+
+jumper::LogSite::LogSite(Logger& logger, LogLevel level, const char* file, int line,
+    const char* function, const char* fmt)
+    : m_logger(logger), m_level(level), m_file(file), m_line(line), m_function(function),
+      m_fmt(fmt)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    rematch();
+    sites().push_back(this);
+    m_logger.m_sites.push_back(this);
+}
+
+jumper::LogSite::~LogSite()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    auto& all = sites();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+    auto& own = m_logger.m_sites;
+    own.erase(std::remove(own.begin(), own.end(), this), own.end());
+}
+
+// 按logger级别和规则重新计算是否输出，调用者持有注册表锁
+void jumper::LogSite::refresh()
+{
+    bool enabled = (m_rule > 0) || (0 == m_rule && m_logger.IsEnabled(m_level));
+
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+// 重新匹配规则并计算是否输出，调用者持有注册表锁
+void jumper::LogSite::rematch()
+{
+    m_rule = match_rule(m_file, m_line);
+    refresh();
+}
+
+/// 添加（或者替换）一条规则，返回当前匹配此规则的调用点数量
+std::size_t jumper::LogSite::SetRule(const std::string& pattern, bool on)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    SitePattern parsed(pattern);
+    std::size_t count = 0;
+
+    rules()[pattern] = on;
+    for (auto site: sites())
+    {
+        if (parsed.match(site->m_file, site->m_line))
+        {
+            ++count;
+        }
+        site->rematch();
+    }
+
+    return count;
+}
+
+/// 删除一条规则，匹配的调用点恢复按logger级别输出
+void jumper::LogSite::ClearRule(const std::string& pattern)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    rules().erase(pattern);
+    for (auto site: sites())
+    {
+        site->rematch();
+    }
+}
+
+/// 替换全部规则，由LogTracer应用配置时调用
+void jumper::LogSite::SetRules(const std::map<std::string, bool>& newRules)
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+
+    rules() = newRules;
+    for (auto site: sites())
+    {
+        site->rematch();
+    }
+}
+
+/// 所有已注册的调用点
+std::vector<jumper::LogSiteInfo> jumper::LogSite::List()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex());
+    std::vector<LogSiteInfo> infos;
+
+    infos.reserve(sites().size());
+    for (auto site: sites())
+    {
+        infos.push_back({ site->m_file, site->m_line, site->m_function, site->m_level,
+            site->m_fmt.to_str(), site->IsEnabled() });
+    }
+
+    return infos;
+}
@@ -1,28 +1,263 @@
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
 #include <chrono>
+#include <thread>
+#include <unordered_map>
 
-#include "logtracer.h"
+#include "logsite.h"
 
-jumper::LogLevel jumper::LogTracer::s_level = jumper::LV_INFO;
-std::ofstream jumper::LogTracer::s_ofs;
+std::unique_ptr<jumper::LogSink> jumper::LogTracer::s_file;
+std::uint64_t jumper::LogTracer::s_fileSeq = 0;
 std::mutex jumper::LogTracer::s_mutex;
+const jumper::LogConfig jumper::LogTracer::s_defaultConfig;
+std::atomic<const jumper::LogConfig*> jumper::LogTracer::s_config { &s_defaultConfig };
+jumper::LogTracer::ReaderCount jumper::LogTracer::s_readers[kReaderStripes] {};
+std::atomic<unsigned> jumper::LogTracer::s_readerEpoch { 0 };
+std::atomic<unsigned> jumper::LogTracer::s_nextStripe { 0 };
+std::mutex jumper::LogTracer::s_configMutex;
+jumper::jumper_inner::LogCounters jumper::LogTracer::s_counters {};
+std::atomic<bool> jumper::LogTracer::s_sanitize { false };
+std::atomic<bool> jumper::LogTracer::s_profile { false };
+std::unique_ptr<const jumper::LogLayout> jumper::LogTracer::s_layout;
+std::string jumper::LogTracer::s_head;
+std::string jumper::LogTracer::s_tail;
+std::string jumper::LogTracer::s_record;
+
+namespace {
+
+// 截断标记"...(N more bytes)"的最大长度
+const std::size_t kOmittedMarkerSize = 36;
+
+// 调用点耗时统计表，只在抽样的调用中加锁，与输出log的锁分开
+struct ProfileTable {
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, jumper::LogSiteProfile> sites;
+};
+
+ProfileTable& profile_table()
+{
+    static ProfileTable table;
+
+    return table;
+}
+
+// FNV-1a
+inline std::uint64_t fnv1a(std::uint64_t hash, const void* data, std::size_t len)
+{
+    auto p = static_cast<const unsigned char*>(data);
+
+    for (std::size_t i = 0; i != len; ++i)
+    {
+        hash = (hash ^ p[i]) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+const std::uint64_t kFnvOffset = 14695981039346656037ull;
+
+} // namespace
 
 /// 初始化LogTracer环境
 /// 设置log输出路径，并添加时间戳，设置log输出级别，默认Info级别
 /// 如果没有将log记录到文件的需要，可不调用此函数
-void jumper::LogTracer::InitialTracer(LogLevel level, const std::string& logPath)
+/// 新的log文件在锁外打开，之后只在交换时短暂持有锁，不会阻塞其它线程输出log
+/// layout不为空时同时设置log记录的布局（见LogLayout），模式串在这里编译一次，错误时保持原有布局
+void jumper::LogTracer::InitialTracer(LogLevel level, const std::string& logPath,
+    const std::string& layout)
 {
-    std::lock_guard<std::mutex> lock(s_mutex);
+    std::lock_guard<std::mutex> lock(s_configMutex);
+    LogConfig config(*s_config.load(std::memory_order_relaxed));
 
-    FinalTracer();
-    s_ofs.open(logPath, std::ios_base::app);
-    if (s_ofs.is_open())
+    config.level = level;
+    config.filePath = logPath;
+    if (!layout.empty())
     {
-        s_ofs << "--------------------\n" << TimeStamp() << "\n";
+        LogLayout compiled;
+        std::string error;
+        if (compiled.Compile(layout, error))
+        {
+            config.layout = layout;
+        }
+        else
+        {
+            std::cerr << "[logtracer]: bad layout:" << layout << ", " << error << "\n";
+        }
     }
-    else
+    apply(config, true);
+}
+
+/// 应用一份配置：设置根logger和命名logger的级别，log文件的设置改变时重新打开log文件，
+/// 最后发布为新的配置快照，输出log的线程在加锁之前登记并通过一次原子读取获得快照，不会被阻塞；
+/// 发布者等待仍在读取旧快照的线程输出完当前的log后释放旧快照
+void jumper::LogTracer::ApplyConfig(const LogConfig& config)
+{
+    std::lock_guard<std::mutex> lock(s_configMutex);
+
+    apply(config, !config.SameFile(*s_config.load(std::memory_order_relaxed)));
+}
+
+/// 当前配置快照的副本
+jumper::LogConfig jumper::LogTracer::Config()
+{
+    std::lock_guard<std::mutex> lock(s_configMutex);
+
+    return *s_config.load(std::memory_order_relaxed);
+}
+
+/// 设置log文件的索引间隔，每interval条log在log文件路径加".idx"的索引文件中生成一项索引
+/// 0表示不生成索引（默认），在InitialTracer之前调用，之后打开的log文件生效
+void jumper::LogTracer::SetIndexInterval(std::uint32_t interval)
+{
+    std::lock_guard<std::mutex> lock(s_configMutex);
+    std::unique_ptr<LogConfig> config(new LogConfig(*s_config.load(std::memory_order_relaxed)));
+
+    config->indexInterval = interval;
+    publish(config.release());
+}
+
+/// 设置log文件的写入方式，在InitialTracer之前调用，之后打开的log文件生效
+void jumper::LogTracer::SetFileMode(FileMode mode, std::size_t atomicSize)
+{
+    std::lock_guard<std::mutex> lock(s_configMutex);
+    std::unique_ptr<LogConfig> config(new LogConfig(*s_config.load(std::memory_order_relaxed)));
+
+    config->fileMode = mode;
+    config->atomicSize = atomicSize;
+    publish(config.release());
+}
+
+// 应用配置并发布快照，reopen为true时重新打开log文件，调用者持有s_configMutex
+void jumper::LogTracer::apply(const LogConfig& config, bool reopen)
+{
+    const auto& prev = *s_config.load(std::memory_order_relaxed);
+
+    s_sanitize.store(config.sanitize, std::memory_order_relaxed);
+    s_profile.store(config.profile, std::memory_order_relaxed);
+    s_root.SetLevel(config.level);
+    for (const auto& kv: config.loggers)
     {
-        std::cerr << "[logtracer]: can't open log file:" << logPath << "\n";
+        get_logger(kv.first).SetLevel(kv.second);
+    }
+    // 之前配置过、现在没有配置的命名logger恢复继承
+    for (const auto& kv: prev.loggers)
+    {
+        if (0 == config.loggers.count(kv.first))
+        {
+            get_logger(kv.first).ResetLevel();
+        }
+    }
+    // 调用点规则改变时整体替换，不影响通过LogSite::SetRule单独设置的规则
+    if (config.sites != prev.sites)
+    {
+        LogSite::SetRules(config.sites);
+    }
+
+    if (config.layout != prev.layout)
+    {
+        swap_layout(config.layout);
+    }
+
+    if (reopen)
+    {
+        reopen_file(config);
+    }
+    publish(new LogConfig(config));
+}
+
+// 编译并替换log记录的布局，只在交换时持有s_mutex，调用者持有s_configMutex
+void jumper::LogTracer::swap_layout(const std::string& pattern)
+{
+    std::unique_ptr<const LogLayout> layout;
+
+    if (!pattern.empty())
+    {
+        std::unique_ptr<LogLayout> compiled(new LogLayout);
+        std::string error;
+        // 配置在解析时已经检查过模式串，这里只会因为直接构造的错误配置而失败
+        if (compiled->Compile(pattern, error))
+        {
+            layout = std::move(compiled);
+        }
+        else
+        {
+            std::cerr << "[logtracer]: bad layout:" << pattern << ", " << error << "\n";
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_layout.swap(layout);
+    }
+    // 旧的布局在锁外释放
+}
+
+// 按配置打开新的log文件并替换当前的log文件，只在交换时持有s_mutex
+void jumper::LogTracer::reopen_file(const LogConfig& config)
+{
+    std::unique_ptr<LogSink> file;
+
+    if (!config.filePath.empty())
+    {
+        bool opened = false;
+        if (FileMode::FILE_SHM == config.fileMode)
+        {
+            std::unique_ptr<ShmSink> sink(new ShmSink(config.filePath, config.ringSize));
+            opened = sink->is_open();
+            file = std::move(sink);
+        }
+        else if (FileMode::FILE_COMPRESSED == config.fileMode)
+        {
+            std::unique_ptr<CompressedFileSink> sink(new CompressedFileSink(config.filePath,
+                config.blockSize));
+            opened = sink->is_open();
+            file = std::move(sink);
+        }
+        else if (FileMode::FILE_SHARED == config.fileMode)
+        {
+            std::unique_ptr<AppendFileSink> sink(new AppendFileSink(config.filePath,
+                config.atomicSize));
+            opened = sink->is_open();
+            file = std::move(sink);
+        }
+        else
+        {
+            std::unique_ptr<FileSink> sink(new FileSink(config.filePath, config.indexInterval));
+            opened = sink->is_open();
+            file = std::move(sink);
+        }
+
+        if (opened)
+        {
+            file->write(0, "--------------------\n", TimeStamp(), true);
+        }
+        else
+        {
+            file.reset();
+            jumper_inner::count(s_counters.fileOpenFailures);
+            std::cerr << "[logtracer]: can't open log file:" << config.filePath << "\n";
+        }
+    }
+
+    swap_file(file);
+    // 旧的log文件在锁外关闭
+}
+
+// 发布新的配置快照，等待读取旧快照的线程退出后释放旧快照，调用者持有s_configMutex
+void jumper::LogTracer::publish(const LogConfig* config)
+{
+    auto prev = s_config.exchange(config, std::memory_order_seq_cst);
+
+    // 读到旧快照的线程在替换之前已经登记，登记在哪个奇偶下取决于它读取纪元的时刻，
+    // 因此翻转两次纪元，每次等待翻转前的奇偶下登记的线程退出；之后登记的线程只会读到新快照
+    for (int i = 0; i < 2; ++i)
+    {
+        wait_readers(s_readerEpoch.fetch_add(1, std::memory_order_seq_cst) & 1);
+    }
+    if (prev != &s_defaultConfig)
+    {
+        delete prev;
     }
 }
 
@@ -40,3 +275,293 @@ std::string jumper::LogTracer::TimeStamp()
 
     return std::string(buffer);
 }
+
+// 等待纪元为parity时登记的读取者全部退出，读取者持有快照的时间只是输出一条log
+void jumper::LogTracer::wait_readers(unsigned parity)
+{
+    for (auto& readers : s_readers)
+    {
+        while (readers.count[parity].load(std::memory_order_acquire) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+/// 获取运行时统计数据的快照，可被监控程序周期性调用
+jumper::LogStats jumper::LogTracer::Stats()
+{
+    LogStats stats;
+    auto load = [](const std::atomic<std::uint64_t>& counter) {
+        return counter.load(std::memory_order_relaxed);
+    };
+
+    for (int i = 0; i != kLogLevelCount; ++i)
+    {
+        stats.emitted[i] = load(s_counters.emitted[i]);
+        stats.filtered[i] = load(s_counters.filtered[i]);
+    }
+    stats.consoleBytes = load(s_counters.consoleBytes);
+    stats.fileBytes = load(s_counters.fileBytes);
+    stats.lockWaitNs = load(s_counters.lockWaitNs);
+    stats.lockWaitSamples = load(s_counters.lockWaitSamples);
+    stats.formatNs = load(s_counters.formatNs);
+    stats.formatSamples = load(s_counters.formatSamples);
+    stats.flushes = load(s_counters.flushes);
+    stats.fileOpenFailures = load(s_counters.fileOpenFailures);
+    stats.syncRequests = load(s_counters.syncRequests);
+    stats.syncs = load(s_counters.syncs);
+    stats.nestedDropped = load(s_counters.nestedDropped);
+
+    return stats;
+}
+
+/// 所有调用点的抽样耗时统计，按总耗时（格式化 + 写入）从高到低排列
+std::vector<jumper::LogSiteProfile> jumper::LogTracer::Profile()
+{
+    std::vector<LogSiteProfile> sites;
+    auto& table = profile_table();
+    {
+        std::lock_guard<std::mutex> lock(table.mutex);
+        sites.reserve(table.sites.size());
+        for (const auto& kv: table.sites)
+        {
+            sites.push_back(kv.second);
+        }
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const LogSiteProfile& a, const LogSiteProfile& b) {
+        return a.formatNs + a.writeNs > b.formatNs + b.writeNs;
+    });
+
+    return sites;
+}
+
+/// 输出总耗时最高的top个调用点：估计的调用次数、平均格式化和写入耗时、平均字节数
+void jumper::LogTracer::DumpProfile(std::ostream& os, std::size_t top)
+{
+    auto sites = Profile();
+    char line[128];
+
+    os << "[logtracer]: profile of " << sites.size() << " sites, 1 in " << kProfileSampleRate
+       << " calls sampled\n";
+    std::snprintf(line, sizeof(line), "%12s %10s %10s %10s %8s  %s\n",
+        "calls", "total_ms", "format_ns", "write_ns", "bytes", "site");
+    os << line;
+    for (std::size_t i = 0; i != std::min(top, sites.size()); ++i)
+    {
+        const auto& site = sites[i];
+        auto samples = static_cast<double>(site.samples);
+
+        // 估计值：抽样的总耗时乘以抽样间隔
+        std::snprintf(line, sizeof(line), "%12llu %10.1f %10.0f %10.0f %8.0f  ",
+            static_cast<unsigned long long>(site.samples * kProfileSampleRate),
+            (site.formatNs + site.writeNs) * 1e-6 * kProfileSampleRate,
+            site.formatNs / samples, site.writeNs / samples, site.bytes / samples);
+        os << line;
+        if (!site.site.empty())
+        {
+            os << site.site << " ";
+        }
+        os << "\"" << jumper::sanitize(site.format) << "\"\n";
+    }
+}
+
+/// 清空调用点的耗时统计
+void jumper::LogTracer::ResetProfile()
+{
+    auto& table = profile_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    table.sites.clear();
+}
+
+// 记录一次抽样的调用点耗时，where为nullptr时按格式串的内容区分调用点
+void jumper::LogTracer::profile(const LogLocation* where, const char* fmt, std::size_t bytes,
+    std::chrono::steady_clock::duration formatTime, std::chrono::steady_clock::duration writeTime)
+{
+    // 调用点的文件名为__FILE__字面量，按地址和行号区分即可
+    std::uint64_t key = where
+        ? fnv1a(fnv1a(kFnvOffset, &where->file, sizeof(where->file)), &where->line,
+            sizeof(where->line))
+        : fnv1a(kFnvOffset ^ 1, fmt, std::strlen(fmt));
+    // 0保留给合并的一项
+    key |= 1;
+    auto& table = profile_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+
+    auto iter = table.sites.find(key);
+    if (table.sites.end() == iter && table.sites.size() >= kProfileMaxSites)
+    {
+        // 统计表已满，新的调用点合并到一项中
+        iter = table.sites.find(0);
+        if (table.sites.end() == iter)
+        {
+            LogSiteProfile site {};
+            site.format = "(other)";
+            iter = table.sites.emplace(0, std::move(site)).first;
+        }
+    }
+    else if (table.sites.end() == iter)
+    {
+        LogSiteProfile site {};
+        if (where)
+        {
+            site.site = jumper::format("{}:{}", where->file, where->line);
+        }
+        site.format = fmt;
+        iter = table.sites.emplace(key, std::move(site)).first;
+    }
+
+    auto& site = iter->second;
+    ++site.samples;
+    site.bytes += bytes;
+    site.formatNs += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(formatTime).count());
+    site.writeNs += static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(writeTime).count());
+}
+
+// 超长记录的一段内容，第一段时加锁并写入头部
+bool jumper::LogTracer::RecordStream::flush(const char* data, std::size_t len)
+{
+    if (!m_started)
+    {
+        begin(data, len);
+    }
+    if (!m_lock.owns_lock())
+    {
+        return true;
+    }
+
+    if (s_file)
+    {
+        if (m_fileParts)
+        {
+            s_file->write_part(data, len);
+        }
+        else
+        {
+            auto n = std::min(len, m_wholeLimit - m_whole.size());
+            m_whole.append(data, n);
+            m_omitted += len - n;
+        }
+    }
+    if (m_config->console)
+    {
+        jumper_inner::count(s_counters.consoleBytes, len);
+        m_os.write(data, static_cast<std::streamsize>(len));
+    }
+
+    return true;
+}
+
+// 第一次输出：交给飞行记录器，加锁后写入头部
+void jumper::LogTracer::RecordStream::begin(const char* data, std::size_t len)
+{
+    const auto& header(m_logger.header(m_lv));
+
+    m_started = true;
+    FlightRecorder::Record(header, std::string(data, std::min(len, FlightRecorder::kSlotSize)));
+    // 格式化时又输出的超长log不能再次加锁，与write_log相同只交给飞行记录器
+    if (!m_enabled)
+    {
+        jumper_inner::count(s_counters.filtered[static_cast<int>(m_lv) - 1]);
+        return;
+    }
+    if (streaming())
+    {
+        jumper_inner::count(s_counters.nestedDropped);
+        return;
+    }
+
+    m_config = &m_reader.acquire();
+    m_lock = lock_tracer();
+    streaming() = true;
+    m_head = &header;
+    if (s_layout)
+    {
+        m_head = &s_layout->Render(s_head, s_tail, static_cast<int>(m_lv), m_logger.Name(),
+            m_where);
+    }
+
+    jumper_inner::count(s_counters.emitted[static_cast<int>(m_lv) - 1]);
+    if (s_file)
+    {
+        m_fileParts = s_file->write_begin(static_cast<int>(m_lv), *m_head);
+        if (!m_fileParts)
+        {
+            // 为头部、换行和截断标记留出空间
+            auto reserved = m_head->size() + 1 + kOmittedMarkerSize;
+            auto limit = s_file->max_record();
+            m_wholeLimit = limit > reserved ? limit - reserved : 0;
+        }
+    }
+    if (m_config->console)
+    {
+        if (m_config->consoleColor)
+        {
+            jumper_inner::count(s_counters.consoleBytes, log_color(m_lv).length());
+            m_os << log_color(m_lv);
+        }
+        jumper_inner::count(s_counters.consoleBytes, m_head->length());
+        m_os << *m_head;
+    }
+}
+
+// 写入尾部并解锁，按策略等待持久化
+void jumper::LogTracer::RecordStream::finish()
+{
+    if (close())
+    {
+        FlushDurable().wait();
+    }
+}
+
+// 格式化中途抛出异常时结束已经开始的记录（内容被截断），解除流式输出的状态并解锁
+jumper::LogTracer::RecordStream::~RecordStream()
+{
+    close();
+}
+
+// 写入尾部和换行，结束分段输出并解锁，返回是否需要等待持久化；没有开始或者已经结束时不做任何事
+bool jumper::LogTracer::RecordStream::close()
+{
+    if (!m_lock.owns_lock())
+    {
+        return false;
+    }
+
+    // 布局中%m之后的部分
+    if (s_layout && !s_tail.empty())
+    {
+        flush(s_tail.data(), s_tail.size());
+    }
+
+    bool durable = false;
+    if (s_file)
+    {
+        if (m_omitted)
+        {
+            m_whole += jumper::format("...({} more bytes)", m_omitted);
+        }
+        auto bytes = m_fileParts ? s_file->write_end(m_newline)
+            : s_file->write(static_cast<int>(m_lv), *m_head, m_whole, m_newline);
+        jumper_inner::count(s_counters.fileBytes, bytes);
+        ++s_fileSeq;
+        durable = m_config->syncLevel && static_cast<int>(m_lv) >= m_config->syncLevel;
+    }
+    if (m_config->console)
+    {
+        const char* end = !m_config->consoleColor ? (m_newline ? "\n" : "")
+            : (m_newline ? "\e[0m\n" : "\e[0m");
+        jumper_inner::count(s_counters.consoleBytes, std::strlen(end));
+        m_os << end;
+    }
+
+    streaming() = false;
+    m_lock.unlock();
+    m_reader.release();
+
+    return durable;
+}
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cstring>
+
+#include "lzcodec.h"
+
+namespace {
+
+// 最短的匹配长度
+const std::size_t kMinMatch = 4;
+// 最大的匹配偏移量
+const std::size_t kMaxOffset = 65535;
+// 哈希表的位数，16K项
+const int kHashBits = 14;
+// 解压后的数据块超过此大小视为损坏
+const std::uint32_t kMaxRawSize = 64u << 20;
+
+inline std::uint32_t read32(const char* p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+inline std::uint32_t hash4(std::uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// 输出超过15的长度部分，每个255表示继续
+inline char* write_length(char* op, std::size_t n)
+{
+    for (; n >= 255; n -= 255)
+    {
+        *op++ = static_cast<char>(255);
+    }
+    *op++ = static_cast<char>(n);
+
+    return op;
+}
+
+// 读取超过15的长度部分，输入不完整时返回false
+inline bool read_length(const unsigned char*& ip, const unsigned char* end, std::size_t& n)
+{
+    unsigned char b;
+
+    do
+    {
+        if (ip == end)
+        {
+            return false;
+        }
+        b = *ip++;
+        n += b;
+    } while (255 == b);
+
+    return true;
+}
+
+// 输出一个序列：token、字面量，matchLen为0时为最后一个只有字面量的序列
+char* write_sequence(char* op, const char* literal, std::size_t literalLen,
+    std::size_t offset, std::size_t matchLen)
+{
+    char* token = op++;
+    std::size_t matchCode = matchLen ? matchLen - kMinMatch : 0;
+
+    if (literalLen >= 15)
+    {
+        op = write_length(op, literalLen - 15);
+    }
+    std::memcpy(op, literal, literalLen);
+    op += literalLen;
+
+    if (0 != matchLen)
+    {
+        op[0] = static_cast<char>(offset & 0xFF);
+        op[1] = static_cast<char>(offset >> 8);
+        op += 2;
+        if (matchCode >= 15)
+        {
+            op = write_length(op, matchCode - 15);
+        }
+    }
+
+    *token = static_cast<char>((std::min<std::size_t>(literalLen, 15) << 4)
+        | std::min<std::size_t>(matchCode, 15));
+
+    return op;
+}
+
+} // namespace
+
+/// LZ77系列的快速压缩，src最多kLzMaxBlockSize字节，dst至少有lz_bound(len)字节，返回压缩后的字节数
+std::size_t jumper::lz_compress(const char* src, std::size_t len, char* dst)
+{
+    // 保存位置的低16位，候选位置的内容总会再比较一次，截断不影响正确性
+    std::uint16_t table[1 << kHashBits] = {};
+    const char* ip = src;
+    const char* anchor = src;
+    const char* end = src + len;
+    char* op = dst;
+
+    while (len >= kMinMatch && ip <= end - kMinMatch)
+    {
+        std::uint32_t v = read32(ip);
+        std::uint32_t h = hash4(v);
+        const char* ref = src + table[h];
+        table[h] = static_cast<std::uint16_t>(ip - src);
+
+        if (ref >= ip || static_cast<std::size_t>(ip - ref) > kMaxOffset || read32(ref) != v)
+        {
+            // 连续没有匹配时加大步长，不可压缩的内容也能快速通过
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        const char* mp = ip + kMinMatch;
+        const char* mr = ref + kMinMatch;
+        while (mp < end && *mp == *mr)
+        {
+            ++mp;
+            ++mr;
+        }
+        // 向前扩展匹配，减少字面量
+        while (ip > anchor && ref > src && ip[-1] == ref[-1])
+        {
+            --ip;
+            --ref;
+        }
+
+        op = write_sequence(op, anchor, static_cast<std::size_t>(ip - anchor),
+            static_cast<std::size_t>(ip - ref), static_cast<std::size_t>(mp - ip));
+        ip = anchor = mp;
+        // 匹配末尾附近的位置也加入哈希表
+        if (ip - src >= 2 && ip - 2 <= end - kMinMatch)
+        {
+            table[hash4(read32(ip - 2))] = static_cast<std::uint16_t>(ip - 2 - src);
+        }
+    }
+
+    op = write_sequence(op, anchor, static_cast<std::size_t>(end - anchor), 0, 0);
+
+    return static_cast<std::size_t>(op - dst);
+}
+
+/// 解压到dst，解压后的长度必须恰好为dstLen，输入损坏时返回false，不会越界读写
+bool jumper::lz_decompress(const char* src, std::size_t len, char* dst, std::size_t dstLen)
+{
+    auto ip = reinterpret_cast<const unsigned char*>(src);
+    auto iend = ip + len;
+    char* op = dst;
+    char* oend = dst + dstLen;
+
+    while (true)
+    {
+        if (ip == iend)
+        {
+            return false;
+        }
+
+        unsigned token = *ip++;
+        std::size_t literalLen = token >> 4;
+        if (15 == literalLen && !read_length(ip, iend, literalLen))
+        {
+            return false;
+        }
+        if (literalLen > static_cast<std::size_t>(iend - ip)
+            || literalLen > static_cast<std::size_t>(oend - op))
+        {
+            return false;
+        }
+        // 短的字面量在两端都有余量时按固定长度复制，多写的部分之后会被覆盖
+        if (literalLen <= 16 && iend - ip >= 16 && oend - op >= 16)
+        {
+            std::memcpy(op, ip, 16);
+        }
+        else
+        {
+            std::memcpy(op, ip, literalLen);
+        }
+        op += literalLen;
+        ip += literalLen;
+
+        // 最后一个序列只有字面量
+        if (ip == iend)
+        {
+            return op == oend;
+        }
+
+        if (iend - ip < 2)
+        {
+            return false;
+        }
+        std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        std::size_t matchLen = token & 0x0F;
+        if (15 == matchLen && !read_length(ip, iend, matchLen))
+        {
+            return false;
+        }
+        matchLen += kMinMatch;
+        if (0 == offset || offset > static_cast<std::size_t>(op - dst)
+            || matchLen > static_cast<std::size_t>(oend - op))
+        {
+            return false;
+        }
+
+        const char* ref = op - offset;
+        char* mend = op + matchLen;
+        if (offset >= 8 && oend - mend >= 8)
+        {
+            // 每次复制8个字节，最多多写7个字节
+            for (; op < mend; op += 8, ref += 8)
+            {
+                std::memcpy(op, ref, 8);
+            }
+            op = mend;
+        }
+        else if (offset >= matchLen)
+        {
+            std::memcpy(op, ref, matchLen);
+            op = mend;
+        }
+        else
+        {
+            // 重叠的匹配（例如连续重复的字符）逐字节复制
+            for (; op != mend; ++op, ++ref)
+            {
+                *op = *ref;
+            }
+        }
+    }
+}
+
+/// FNV-1a方式的校验值，每次处理4个字节
+std::uint32_t jumper::lz_checksum(const char* data, std::size_t len)
+{
+    std::uint32_t hash = 2166136261u;
+    std::size_t i = 0;
+
+    for (; i + 4 <= len; i += 4)
+    {
+        hash = (hash ^ read32(data + i)) * 16777619u;
+    }
+    for (; i != len; ++i)
+    {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+
+    return hash;
+}
+
+/// 将[data, data + len)压缩为一个带头部的数据块，追加到out
+void jumper::lz_encode_block(const char* data, std::size_t len, std::string& out)
+{
+    auto base = out.size();
+    LzBlockHeader header;
+
+    out.resize(base + sizeof(header) + lz_bound(len));
+    char* body = &out[base + sizeof(header)];
+    auto packed = lz_compress(data, len, body);
+    // 压缩后没有变小时保存原始内容
+    if (packed >= len)
+    {
+        std::memcpy(body, data, len);
+        packed = len;
+    }
+
+    std::memcpy(header.magic, kLzBlockMagic, sizeof(header.magic));
+    header.rawSize = static_cast<std::uint32_t>(len);
+    header.packedSize = static_cast<std::uint32_t>(packed);
+    header.checksum = lz_checksum(data, len);
+    std::memcpy(&out[base], &header, sizeof(header));
+    out.resize(base + sizeof(header) + packed);
+}
+
+/// 解码data开头的一个数据块，内容追加到out，consumed为数据块的总字节数
+jumper::LzStatus jumper::lz_decode_block(const char* data, std::size_t len, std::string& out,
+    std::size_t& consumed)
+{
+    LzBlockHeader header;
+
+    if (len < sizeof(header))
+    {
+        return LzStatus::LZ_INCOMPLETE;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (0 != std::memcmp(header.magic, kLzBlockMagic, sizeof(header.magic))
+        || header.rawSize > kMaxRawSize || header.packedSize > header.rawSize)
+    {
+        return LzStatus::LZ_CORRUPT;
+    }
+    if (header.packedSize > len - sizeof(header))
+    {
+        return LzStatus::LZ_INCOMPLETE;
+    }
+
+    auto base = out.size();
+    const char* body = data + sizeof(header);
+    out.resize(base + header.rawSize);
+    char* raw = &out[base];
+    bool ok = (header.packedSize == header.rawSize)
+        ? (std::memcpy(raw, body, header.rawSize), true)
+        : lz_decompress(body, header.packedSize, raw, header.rawSize);
+
+    if (!ok || lz_checksum(raw, header.rawSize) != header.checksum)
+    {
+        out.resize(base);
+        return LzStatus::LZ_CORRUPT;
+    }
+    consumed = sizeof(header) + header.packedSize;
+
+    return LzStatus::LZ_OK;
+}
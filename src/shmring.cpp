@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "shmring.h"
+
+using jumper::jumper_inner::ShmRecordHeader;
+using jumper::jumper_inner::ShmRingHeader;
+using jumper::jumper_inner::kShmDataOffset;
+using jumper::jumper_inner::kShmWrap;
+
+namespace {
+
+const char kShmMagic[8] = { 'J', 'L', 'O', 'G', 'R', 'N', 'G', '1' };
+
+// 记录头部加内容，按8字节对齐后的长度
+inline std::size_t record_size(std::size_t len)
+{
+    return sizeof(ShmRecordHeader) + ((len + 7) & ~static_cast<std::size_t>(7));
+}
+
+} // namespace
+
+/// 创建名为name的共享内存，capacity向上取整为2的幂
+jumper::ShmRingWriter::ShmRingWriter(const std::string& name, std::size_t capacity)
+{
+    auto path(jumper_inner::shm_name(name));
+
+    m_capacity = 4096;
+    while (m_capacity < capacity)
+    {
+        m_capacity <<= 1;
+    }
+    m_mapSize = kShmDataOffset + m_capacity;
+
+    // 替换同名的旧缓冲区，仍在读取旧缓冲区的读取端不受影响
+    ::shm_unlink(path.c_str());
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    void* addr = MAP_FAILED;
+    if (0 == ::ftruncate(fd, static_cast<off_t>(m_mapSize)))
+    {
+        addr = ::mmap(nullptr, m_mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (MAP_FAILED == addr)
+    {
+        ::shm_unlink(path.c_str());
+        return;
+    }
+
+    // 控制块初始化完成后最后写入魔数，读取端看到魔数才附加
+    m_header = new (addr) ShmRingHeader();
+    m_header->capacity = m_capacity;
+    m_header->pid = ::getpid();
+    m_data = static_cast<char*>(addr) + kShmDataOffset;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(m_header->magic, kShmMagic, sizeof(kShmMagic));
+}
+
+jumper::ShmRingWriter::~ShmRingWriter()
+{
+    if (m_header)
+    {
+        m_header->closed.store(1, std::memory_order_release);
+        ::munmap(m_header, m_mapSize);
+    }
+}
+
+/// 预留一条len字节、level级别的记录，返回写入位置，空间不足或者超过max_record()时返回nullptr
+char* jumper::ShmRingWriter::reserve(std::size_t len, int level)
+{
+    std::uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    std::uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+    std::size_t size = record_size(len);
+    std::size_t offset = static_cast<std::size_t>(head & (m_capacity - 1));
+    // 数据区末尾放不下时，剩余部分作为填充，记录从数据区开头写入
+    std::size_t pad = (offset + size > m_capacity) ? m_capacity - offset : 0;
+
+    if (len > max_record() || head + pad + size - tail > m_capacity)
+    {
+        m_header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    if (0 != pad)
+    {
+        ShmRecordHeader wrap { kShmWrap, 0 };
+        std::memcpy(m_data + offset, &wrap, sizeof(wrap));
+        offset = 0;
+    }
+
+    ShmRecordHeader record { static_cast<std::uint32_t>(len), static_cast<std::uint32_t>(level) };
+    std::memcpy(m_data + offset, &record, sizeof(record));
+    m_pending = head + pad + size;
+
+    return m_data + offset + sizeof(record);
+}
+
+/// 发布reserve预留的记录，读取端之后才能看到
+void jumper::ShmRingWriter::commit()
+{
+    m_header->head.store(m_pending, std::memory_order_release);
+}
+
+jumper::ShmRingReader::~ShmRingReader()
+{
+    close();
+}
+
+/// 附加到名为name的环形缓冲区，不存在或者尚未初始化完成时返回false
+bool jumper::ShmRingReader::open(const std::string& name)
+{
+    close();
+
+    auto path(jumper_inner::shm_name(name));
+    int fd = ::shm_open(path.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    void* addr = MAP_FAILED;
+    if (0 == ::fstat(fd, &st) && static_cast<std::size_t>(st.st_size) > kShmDataOffset)
+    {
+        addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (MAP_FAILED == addr)
+    {
+        return false;
+    }
+
+    auto header = static_cast<ShmRingHeader*>(addr);
+    std::size_t mapSize = static_cast<std::size_t>(st.st_size);
+    if (0 != std::memcmp(header->magic, kShmMagic, sizeof(kShmMagic))
+        || kShmDataOffset + header->capacity != mapSize)
+    {
+        ::munmap(addr, mapSize);
+        return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    m_name = path;
+    m_header = header;
+    m_data = static_cast<const char*>(addr) + kShmDataOffset;
+    m_capacity = static_cast<std::size_t>(header->capacity);
+    m_mapSize = mapSize;
+    m_dev = st.st_dev;
+    m_ino = st.st_ino;
+
+    return true;
+}
+
+/// 解除映射，不删除共享内存
+void jumper::ShmRingReader::close()
+{
+    if (m_header)
+    {
+        ::munmap(m_header, m_mapSize);
+        m_header = nullptr;
+        m_data = nullptr;
+    }
+}
+
+/// 读取记录，内容依次追加到out，最多读取约maxBytes字节，返回读取的记录数
+std::size_t jumper::ShmRingReader::read(std::string& out, std::size_t maxBytes)
+{
+    std::uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    std::uint64_t head = m_header->head.load(std::memory_order_acquire);
+    std::size_t count = 0;
+    std::size_t bytes = 0;
+
+    while (tail != head && bytes < maxBytes)
+    {
+        std::size_t offset = static_cast<std::size_t>(tail & (m_capacity - 1));
+        ShmRecordHeader record;
+        std::memcpy(&record, m_data + offset, sizeof(record));
+
+        if (kShmWrap == record.size)
+        {
+            tail += m_capacity - offset;
+            continue;
+        }
+
+        out.append(m_data + offset + sizeof(record), record.size);
+        tail += record_size(record.size);
+        bytes += record.size;
+        ++count;
+    }
+
+    // 读完之后才归还空间，写入端不会覆盖正在读取的内容
+    m_header->tail.store(tail, std::memory_order_release);
+
+    return count;
+}
+
+/// 是否还有没有读取的记录
+bool jumper::ShmRingReader::empty() const
+{
+    return m_header->tail.load(std::memory_order_relaxed)
+        == m_header->head.load(std::memory_order_acquire);
+}
+
+/// 写入端丢弃的记录数
+std::uint64_t jumper::ShmRingReader::dropped() const
+{
+    return m_header->dropped.load(std::memory_order_relaxed);
+}
+
+/// 写入端的进程号
+pid_t jumper::ShmRingReader::producer() const
+{
+    return m_header->pid;
+}
+
+/// 写入端是否还在使用：没有关闭并且进程仍然存在
+bool jumper::ShmRingReader::producer_alive() const
+{
+    if (0 != m_header->closed.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    return 0 == ::kill(m_header->pid, 0) || EPERM == errno;
+}
+
+/// 名称是否已经指向另一个环形缓冲区（写入端重新创建了同名的缓冲区）或者已被删除
+bool jumper::ShmRingReader::replaced() const
+{
+    int fd = ::shm_open(m_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return true;
+    }
+
+    struct stat st;
+    bool same = (0 == ::fstat(fd, &st) && st.st_dev == m_dev && st.st_ino == m_ino);
+    ::close(fd);
+
+    return !same;
+}
+
+/// 名称仍然指向此环形缓冲区时删除共享内存，之后新的写入端可以重新创建
+void jumper::ShmRingReader::unlink()
+{
+    if (!replaced())
+    {
+        ::shm_unlink(m_name.c_str());
+    }
+}
@@ -0,0 +1,124 @@
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "flightrecorder.h"
+#include "logtracer.h"
+
+using jumper::FlightRecorder;
+using jumper::LogTracer;
+
+// 读取整个文件内容
+static std::string read_file(const std::string& path)
+{
+    std::ifstream ifs(path);
+    std::ostringstream oss;
+
+    oss << ifs.rdbuf();
+
+    return oss.str();
+}
+
+// 将飞行记录器的内容转储到临时文件后读取
+static std::string dump_to_string()
+{
+    char path[] = "/tmp/flightrecorder_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0)
+    {
+        return std::string();
+    }
+
+    FlightRecorder::Dump(fd);
+    ::close(fd);
+    auto str(read_file(path));
+    ::unlink(path);
+
+    return str;
+}
+
+TEST(FlightRecorderTest, KeepsFilteredRecords)
+{
+    ASSERT_TRUE(FlightRecorder::Enable("/tmp/flightrecorder_test.crash", 4));
+
+    LogTracer::SetLogLevel(jumper::LV_ERROR);
+    // 低于当前级别的log不会显示，但会进入飞行记录器
+    for (auto i = 0; i != 10; ++i)
+    {
+        LogTracer::LoglnDebug("debug record {}", i);
+    }
+
+    auto dump(dump_to_string());
+
+    // 只保留最近的4条记录
+    EXPECT_EQ(dump.find("debug record 5"), std::string::npos);
+    EXPECT_NE(dump.find("[DEBUG]:debug record 6\n"), std::string::npos);
+    EXPECT_NE(dump.find("[DEBUG]:debug record 9\n"), std::string::npos);
+    EXPECT_LT(dump.find("debug record 6"), dump.find("debug record 9"));
+
+    FlightRecorder::Disable();
+    LogTracer::SetLogLevel(jumper::LV_INFO);
+}
+
+TEST(FlightRecorderTest, PerThreadRings)
+{
+    ASSERT_TRUE(FlightRecorder::Enable("/tmp/flightrecorder_test.crash", 4));
+
+    std::thread worker([]() {
+        FlightRecorder::Record("[INFO]:", "from worker");
+    });
+    worker.join();
+    FlightRecorder::Record("[INFO]:", "from main");
+
+    auto dump(dump_to_string());
+
+    EXPECT_NE(dump.find("from worker"), std::string::npos);
+    EXPECT_NE(dump.find("from main"), std::string::npos);
+
+    FlightRecorder::Disable();
+}
+
+TEST(FlightRecorderTest, TruncatesLongRecords)
+{
+    ASSERT_TRUE(FlightRecorder::Enable("/tmp/flightrecorder_test.crash", 4));
+
+    FlightRecorder::Record("[INFO]:", std::string(1024, 'x'));
+    auto dump(dump_to_string());
+
+    EXPECT_NE(dump.find(std::string(FlightRecorder::kSlotSize - 7, 'x')), std::string::npos);
+    EXPECT_EQ(dump.find(std::string(FlightRecorder::kSlotSize, 'x')), std::string::npos);
+
+    FlightRecorder::Disable();
+}
+
+TEST(FlightRecorderDeathTest, DumpOnAbort)
+{
+    const std::string path("/tmp/flightrecorder_death_test.crash");
+    std::remove(path.c_str());
+
+    EXPECT_DEATH({
+        FlightRecorder::Enable(path, 8);
+        FlightRecorder::Record("[DEBUG]:", "last words");
+        std::abort();
+    }, "");
+
+    auto dump(read_file(path));
+    std::remove(path.c_str());
+
+    EXPECT_NE(dump.find("==== flight recorder: signal " + std::to_string(SIGABRT)),
+        std::string::npos);
+    EXPECT_NE(dump.find("[DEBUG]:last words"), std::string::npos);
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Running main() from << " << __FILE__ << "\n";
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -2,6 +2,26 @@
 #include "fmt.h"
 
 using jumper::Fmt;
+using jumper::FmtView;
+
+// 将FmtView的片段按子串拼接，便于与Fmt::subs()比较
+static std::deque<std::string> view_subs(const FmtView& view)
+{
+    std::deque<std::string> subs;
+    std::string sub;
+
+    for (const auto& piece: view.pieces())
+    {
+        sub.append(view.data() + piece.off, piece.len);
+        if (piece.last)
+        {
+            subs.push_back(sub);
+            sub.clear();
+        }
+    }
+
+    return subs;
+}
 
 TEST(FmtTest, Normal)
 {
@@ -60,6 +80,175 @@ TEST(FmtTest, Abnormal)
     }
 }
 
+// 比较两个Fmt对象的解析结果
+static void expect_same(const Fmt& lhs, const Fmt& rhs, const std::string& what)
+{
+    ASSERT_EQ(lhs.is_ok(), rhs.is_ok()) << what;
+    EXPECT_EQ(lhs.to_str(), rhs.to_str()) << what;
+    EXPECT_EQ(lhs.buf(), rhs.buf()) << what;
+    EXPECT_EQ(lhs.subs(), rhs.subs()) << what;
+    for (std::size_t i = 0; i <= lhs.subs().size(); ++i)
+    {
+        EXPECT_EQ(lhs.spec(i), rhs.spec(i)) << what;
+    }
+}
+
+TEST(FmtTest, Append)
+{
+    {
+        // 追加的结果与直接解析拼接后的格式串相同，左侧的转义不会被重新解析
+        Fmt fmt("{{x}} {}");
+
+        fmt += " = {}";
+        ASSERT_TRUE(fmt.is_ok());
+        EXPECT_EQ(fmt.to_str(), "{x} {} = {}");
+        EXPECT_EQ(fmt.subs().size(), 3);
+    }
+
+    {
+        // 左侧末尾的'{'和'}'在追加后可以构成转义或者配对
+        Fmt open("a {");
+        ASSERT_FALSE(open.is_ok());
+        EXPECT_EQ(open.buf(), "a {");
+
+        open += "name} b";
+        ASSERT_TRUE(open.is_ok());
+        std::deque<std::string> subs { "a ", " b" };
+        EXPECT_EQ(open.subs(), subs);
+        EXPECT_EQ(open.spec(0), "name");
+
+        Fmt escaped("{} x}");
+        escaped += "}";
+        ASSERT_TRUE(escaped.is_ok());
+        EXPECT_EQ(escaped.to_str(), "{} x}");
+    }
+
+    {
+        // 多余的'}'无法恢复，之后追加的格式会被忽略
+        Fmt fmt("so }{{}");
+
+        fmt += "{}";
+        ASSERT_FALSE(fmt.is_ok());
+        EXPECT_EQ(fmt.buf(), "so }");
+    }
+
+    {
+        // 被移动后可以重新追加格式
+        Fmt fmt("a = {}");
+        Fmt other(std::move(fmt));
+
+        fmt += "b = {}";
+        ASSERT_TRUE(fmt.is_ok());
+        EXPECT_EQ(fmt.subs().size(), 2);
+    }
+
+    {
+        // 追加自身的内容，追加过程中格式串重新分配内存
+        Fmt fmt("abcdefghijklmnopqrstuvwxyz {} 0123456789");
+        std::string whole(fmt.to_str() + fmt.to_str());
+
+        fmt += fmt;
+        ASSERT_TRUE(fmt.is_ok());
+        EXPECT_EQ(fmt.to_str(), whole);
+        EXPECT_EQ(fmt.subs().size(), 3);
+
+        fmt + fmt.to_str();
+        ASSERT_TRUE(fmt.is_ok());
+        EXPECT_EQ(fmt.to_str(), whole + whole);
+        EXPECT_EQ(fmt.subs().size(), 5);
+    }
+}
+
+TEST(FmtTest, AppendSameAsWhole)
+{
+    // 穷举由'{'、'}'、'a'组成的短格式串，任意切分为三段追加，结果都与整体解析相同
+    const char alphabet[] = { '{', '}', 'a' };
+    const std::size_t kMaxLen = 7;
+
+    for (std::size_t len = 0; len <= kMaxLen; ++len)
+    {
+        std::size_t total = 1;
+        for (std::size_t i = 0; i != len; ++i)
+        {
+            total *= 3;
+        }
+
+        for (std::size_t code = 0; code != total; ++code)
+        {
+            std::string str;
+            for (std::size_t i = 0, c = code; i != len; ++i, c /= 3)
+            {
+                str.push_back(alphabet[c % 3]);
+            }
+
+            Fmt whole(str);
+            for (std::size_t i = 0; i <= len; ++i)
+            {
+                for (std::size_t j = i; j <= len; ++j)
+                {
+                    Fmt pieces(str.substr(0, i));
+                    pieces += str.substr(i, j - i);
+                    pieces + str.substr(j);
+
+                    expect_same(pieces, whole, str + " @" + std::to_string(i) + "," + std::to_string(j));
+                    if (HasFailure())
+                    {
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(FmtViewTest, SameAsFmt)
+{
+    const char* formats[] = {
+        "", "plain text", "{} + {  } = {}. ", "this is {{ {} sdsd", "ok{}} isd}",
+        "{{}}", "a{{b}}c{x}d", "{a{{b}", "{a{}b}", "so }{{}", "tail {", "}", "{{{}}}",
+        "{}{}{}", "{ {} }",
+    };
+
+    for (auto str: formats)
+    {
+        Fmt fmt(str);
+        FmtView view(str);
+
+        ASSERT_EQ(view.is_ok(), fmt.is_ok()) << str;
+        EXPECT_EQ(view.to_str(), fmt.to_str()) << str;
+        std::string appended("prefix:");
+        view.append_to(appended);
+        EXPECT_EQ(appended, "prefix:" + fmt.to_str()) << str;
+        if (fmt.is_ok())
+        {
+            EXPECT_EQ(view.size(), fmt.subs().size()) << str;
+            EXPECT_EQ(view_subs(view), fmt.subs()) << str;
+            for (std::size_t i = 0; i != fmt.subs().size(); ++i)
+            {
+                EXPECT_EQ(view.spec(i), fmt.spec(i)) << str;
+            }
+        }
+    }
+}
+
+TEST(FmtViewTest, ReferencesCallerStorage)
+{
+    static const char str[] = "id={{{}}} name={}";
+    FmtView view(str);
+
+    ASSERT_TRUE(view.is_ok());
+    EXPECT_EQ(view.data(), str);
+    for (const auto& piece: view.pieces())
+    {
+        EXPECT_LE(piece.off + piece.len, sizeof(str) - 1);
+    }
+
+    std::string owned("a = {}");
+    FmtView fromString(owned);
+    ASSERT_TRUE(fromString.is_ok());
+    EXPECT_EQ(fromString.data(), owned.data());
+}
+
 int main(int argc, char *argv[])
 {
     std::cout << "Running main() from << " << __FILE__ << "\n";
@@ -1,6 +1,16 @@
+#include <array>
+#include <list>
+#include <map>
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 #include "fmt.h"
 #include "format.h"
@@ -24,6 +34,102 @@ std::ostream& operator<<(std::ostream& oss, const User& user)
     return oss << "id:" << user.m_id << ",name:" << user.m_name;
 }
 
+// 价格，以整数分存储
+struct Price {
+    long long m_cents;
+};
+
+// 订单号，同时提供了formatter特化和<<运算符
+struct OrderId {
+    unsigned m_id;
+};
+
+std::ostream& operator<<(std::ostream& oss, const OrderId& id)
+{
+    return oss << "ostream:" << id.m_id;
+}
+
+// 可以遍历，同时重载了<<运算符，按<<运算符输出
+struct Series {
+    std::vector<int> m_values;
+
+    std::vector<int>::const_iterator begin() const
+    {
+        return m_values.begin();
+    }
+
+    std::vector<int>::const_iterator end() const
+    {
+        return m_values.end();
+    }
+};
+
+std::ostream& operator<<(std::ostream& oss, const Series& series)
+{
+    return oss << "series(" << series.m_values.size() << ")";
+}
+
+// 与std::filesystem::path类似，遍历得到的元素还是自身的类型
+struct PathLike {
+    std::string m_name;
+
+    const PathLike* begin() const
+    {
+        return this;
+    }
+
+    const PathLike* end() const
+    {
+        return this + 1;
+    }
+};
+
+std::ostream& operator<<(std::ostream& oss, const PathLike& path)
+{
+    return oss << "path:" << path.m_name;
+}
+
+// 输出时又调用println，输出到m_fp
+struct Traced {
+    std::FILE* m_fp;
+};
+
+std::ostream& operator<<(std::ostream& oss, const Traced& traced)
+{
+    jumper::println(traced.m_fp, "inner {}", 1);
+
+    return oss << "traced";
+}
+
+namespace jumper {
+// 特化formatter后，Price不经过std::ostream直接写入缓冲区
+template<>
+struct formatter<Price> {
+    void format(FmtBuffer& buf, const Price& price, const std::string& spec) const
+    {
+        if (price.m_cents < 0)
+        {
+            buf.push_back('-');
+        }
+        auto cents = price.m_cents < 0 ? -price.m_cents : price.m_cents;
+        buf.append(spec.empty() ? "$" : spec);
+        buf.append(std::to_string(cents / 100));
+        buf.push_back('.');
+        buf.push_back(static_cast<char>('0' + cents % 100 / 10));
+        buf.push_back(static_cast<char>('0' + cents % 10));
+    }
+};
+
+template<>
+struct formatter<OrderId> {
+    void format(FmtBuffer& buf, const OrderId& id, const std::string&) const
+    {
+        buf.append("#", 1);
+        buf.append(std::to_string(id.m_id));
+    }
+};
+} // namespace jumper
+
 TEST(FormatTest, Normal)
 {
     {
@@ -111,6 +217,239 @@ TEST(FormatTest, Normal)
     }
 }
 
+TEST(FormatTest, Scalars)
+{
+    {
+        // 内置类型不经过std::ostream，但输出与std::ostream一致
+        auto str(jumper::format("{} {} {} {} {}", -128, 18446744073709551615ull, true, 0.1f, 1e20));
+
+        EXPECT_EQ(str, "-128 18446744073709551615 1 0.1 1e+20");
+    }
+
+    {
+        const char* cstr = "c-str";
+        auto str(jumper::format("{}|{}|{}", cstr, std::string("str"), static_cast<unsigned char>('u')));
+
+        EXPECT_EQ(str, "c-str|str|u");
+    }
+
+    {
+        // 复用FmtBuffer，结果追加到缓冲区末尾
+        jumper::FmtBuffer buf;
+        Fmt fmt("[{}]");
+
+        EXPECT_TRUE(jumper::format_to(buf, fmt, 1));
+        EXPECT_TRUE(jumper::format_to(buf, fmt, 2));
+        EXPECT_FALSE(jumper::format_to(buf, fmt));
+        EXPECT_EQ(buf.str(), "[1][2]");
+    }
+}
+
+TEST(FormatTest, Containers)
+{
+    {
+        std::vector<int> ids { 1, 2, 3 };
+        std::list<std::string> names { "a", "b" };
+        std::array<double, 2> prices {{ 1.5, 2.25 }};
+        int raw[] = { 7, 8 };
+
+        EXPECT_EQ(jumper::format("{} {} {} {}", ids, names, prices, raw),
+            "[1, 2, 3] [a, b] [1.5, 2.25] [7, 8]");
+        EXPECT_EQ(jumper::format("{}", std::vector<int>()), "[]");
+    }
+
+    {
+        std::map<std::string, int> shards { { "a", 1 }, { "b", 2 } };
+        std::unordered_map<int, int> single { { 3, 4 } };
+
+        EXPECT_EQ(jumper::format("{} {}", shards, single), "{a: 1, b: 2} {3: 4}");
+    }
+
+    {
+        auto str(jumper::format("{} {}", std::make_pair(1, "one"), std::make_tuple('x', 2, 3.5)));
+
+        EXPECT_EQ(str, "(1, one) (x, 2, 3.5)");
+        EXPECT_EQ(jumper::format("{}", std::tuple<>()), "()");
+    }
+
+    {
+        // 容器嵌套，元素为重载了<<运算符的类型
+        std::vector<std::vector<int>> nested { { 1 }, { 2, 3 } };
+        std::vector<User> users { User(1, "A"), User(2, "B") };
+
+        EXPECT_EQ(jumper::format("{}", nested), "[[1], [2, 3]]");
+        EXPECT_EQ(jumper::format("{}", users), "[id:1,name:A, id:2,name:B]");
+    }
+
+    {
+        // 类型自己重载的<<运算符优先于容器的默认输出
+        Series series { { 1, 2, 3 } };
+        PathLike path { "a" };
+
+        EXPECT_EQ(jumper::format("{}", series), "series(3)");
+        EXPECT_EQ(jumper::format("{}", path), "path:a");
+        EXPECT_EQ(jumper::format("{}", std::vector<Series> { series }), "[series(3)]");
+    }
+
+    {
+        // join和limit适配器
+        std::vector<int> batch { 10, 11, 12, 13, 14 };
+        std::map<int, char> m { { 1, 'a' }, { 2, 'b' }, { 3, 'c' } };
+
+        EXPECT_EQ(jumper::format("ids={}", jumper::join(batch, ",")), "ids=10,11,12,13,14");
+        EXPECT_EQ(jumper::format("ids={}", jumper::join(batch, "|", 2)), "ids=10|11|...");
+        EXPECT_EQ(jumper::format("{}", jumper::limit(batch, 3)), "[10, 11, 12, ...]");
+        EXPECT_EQ(jumper::format("{}", jumper::limit(batch, 5)), "[10, 11, 12, 13, 14]");
+        EXPECT_EQ(jumper::format("{}", jumper::limit(m, 1)), "{1: a, ...}");
+    }
+}
+
+TEST(FormatTest, Formatter)
+{
+    {
+        // 格式符中的内容作为格式说明传给formatter
+        EXPECT_EQ(jumper::format("{} {EUR }", Price { 1205 }, Price { -7 }), "$12.05 -EUR 0.07");
+    }
+
+    {
+        // 同时存在formatter特化和<<运算符时，优先使用formatter
+        EXPECT_EQ(jumper::format("order {}", OrderId { 42 }), "order #42");
+    }
+
+    {
+        // 作为容器元素时同样使用formatter
+        std::vector<Price> levels { { 100 }, { 250 } };
+
+        EXPECT_EQ(jumper::format("{}", levels), "[$1.00, $2.50]");
+        EXPECT_EQ(jumper::format("{}", std::make_pair(OrderId { 1 }, Price { 1 })), "(#1, $0.01)");
+    }
+
+    {
+        Fmt fmt("{a}{}{ b }");
+
+        ASSERT_TRUE(fmt.is_ok());
+        EXPECT_EQ(fmt.spec(0), "a");
+        EXPECT_EQ(fmt.spec(1), "");
+        EXPECT_EQ(fmt.spec(2), " b ");
+        EXPECT_EQ(fmt.spec(3), "");
+    }
+}
+
+// 读取FILE*中的全部内容
+static std::string read_all(std::FILE* fp)
+{
+    std::string str;
+    char buf[4096];
+
+    std::rewind(fp);
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), fp)) > 0; )
+    {
+        str.append(buf, n);
+    }
+
+    return str;
+}
+
+TEST(FormatTest, DirectOutput)
+{
+    {
+        std::FILE* fp = std::tmpfile();
+        ASSERT_NE(fp, nullptr);
+
+        Fmt fmt("{} -> {}");
+        EXPECT_TRUE(jumper::println(fp, fmt, 'a', 1));
+        EXPECT_TRUE(jumper::print(fp, "no newline {}", std::vector<int> { 1, 2 }));
+        EXPECT_TRUE(jumper::println(fp, std::string(" end")));
+        EXPECT_FALSE(jumper::println(fp, "{} {}", 1));
+
+        EXPECT_EQ(read_all(fp), "a -> 1\nno newline [1, 2] end\n\n");
+        std::fclose(fp);
+    }
+
+    {
+        int fds[2];
+        ASSERT_EQ(::pipe(fds), 0);
+
+        EXPECT_TRUE(jumper::println_fd(fds[1], "fd {}", 2));
+        EXPECT_TRUE(jumper::print_fd(fds[1], Fmt("{{raw}}")));
+        ::close(fds[1]);
+
+        char buf[64];
+        auto n = ::read(fds[0], buf, sizeof(buf));
+        ::close(fds[0]);
+
+        EXPECT_EQ(std::string(buf, n > 0 ? n : 0), "fd 2\n{raw}");
+    }
+
+    {
+        // 格式化参数时又调用println，外层已经格式化的内容不会丢失
+        std::FILE* fp = std::tmpfile();
+        std::FILE* inner = std::tmpfile();
+        ASSERT_NE(fp, nullptr);
+        ASSERT_NE(inner, nullptr);
+
+        EXPECT_TRUE(jumper::println(fp, "outer {} {} end", std::string(100, 'x'), Traced { inner }));
+        EXPECT_TRUE(jumper::println(fp, "nested {}", Traced { fp }));
+
+        EXPECT_EQ(read_all(inner), "inner 1\n");
+        EXPECT_EQ(read_all(fp), "outer " + std::string(100, 'x') + " traced end\n"
+            "inner 1\nnested traced\n");
+        std::fclose(inner);
+        std::fclose(fp);
+    }
+
+    {
+        // 多线程向同一FILE*输出，每一行都完整
+        std::FILE* fp = std::tmpfile();
+        ASSERT_NE(fp, nullptr);
+
+        const int kThreads = 4;
+        const int kLines = 2000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t != kThreads; ++t)
+        {
+            threads.emplace_back([fp, t]() {
+                Fmt fmt("thread {} line {} {}");
+                for (int i = 0; i != kLines; ++i)
+                {
+                    jumper::println(fp, fmt, t, i, std::string(64, static_cast<char>('a' + t)));
+                }
+            });
+        }
+        for (auto& th: threads)
+        {
+            th.join();
+        }
+
+        std::istringstream iss(read_all(fp));
+        std::string line;
+        int count = 0;
+        while (std::getline(iss, line))
+        {
+            ++count;
+            char c = static_cast<char>('a' + (line[7] - '0'));
+            EXPECT_EQ(line.substr(line.size() - 64), std::string(64, c)) << line;
+        }
+        EXPECT_EQ(count, kThreads * kLines);
+        std::fclose(fp);
+    }
+}
+
+TEST(FormatTest, FmtView)
+{
+    static const jumper::FmtView view("{{id}}={} price={EUR } tags={}");
+
+    ASSERT_TRUE(view.is_ok());
+    EXPECT_EQ(jumper::format(view, 7, Price { 150 }, std::vector<int> { 1, 2 }),
+        "{id}=7 price=EUR 1.50 tags=[1, 2]");
+    EXPECT_EQ(jumper::format(view, 1, 2, 3, 4), "{id}=1 price=2 tags=3");
+    EXPECT_TRUE(jumper::format(view, 1).empty());
+
+    jumper::FmtBuffer buf;
+    EXPECT_TRUE(jumper::format_to(buf, jumper::FmtView("x{}"), 1));
+    EXPECT_EQ(buf.str(), "x1");
+}
+
 TEST(FormatTest, Abnormal)
 {
     {
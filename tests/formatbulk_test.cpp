@@ -0,0 +1,135 @@
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "formatbulk.h"
+
+using jumper::BulkResult;
+using jumper::Fmt;
+
+namespace {
+
+// 值为负数时输出抛出异常
+struct Checked {
+    int value;
+
+    friend std::ostream& operator<<(std::ostream& os, const Checked& c)
+    {
+        if (c.value < 0)
+        {
+            throw std::runtime_error("negative value");
+        }
+        return os << c.value;
+    }
+};
+
+} // namespace
+
+TEST(FormatBulkTest, Normal)
+{
+    {
+        Fmt fmt("id={} sym={} px={}\n");
+        std::vector<std::tuple<int, std::string, double>> rows {
+            std::make_tuple(1, "AAPL", 1.5),
+            std::make_tuple(2, "MSFT", 2.25),
+            std::make_tuple(3, "", 0.0),
+        };
+        BulkResult out;
+
+        ASSERT_TRUE(jumper::format_bulk(fmt, rows, out));
+        ASSERT_EQ(out.size(), rows.size());
+        EXPECT_EQ(out.data, "id=1 sym=AAPL px=1.5\nid=2 sym=MSFT px=2.25\nid=3 sym= px=0\n");
+        for (std::size_t i = 0; i != rows.size(); ++i)
+        {
+            EXPECT_EQ(out.row(i), jumper::format(fmt, std::get<0>(rows[i]),
+                std::get<1>(rows[i]), std::get<2>(rows[i])));
+        }
+    }
+
+    {
+        // 单个参数、std::pair、std::array作为行
+        BulkResult out;
+        std::vector<int> ids { 7, 8 };
+        std::vector<std::pair<char, int>> pairs { { 'a', 1 } };
+        std::vector<std::array<int, 2>> arrays { {{ 3, 4 }} };
+
+        ASSERT_TRUE(jumper::format_bulk(jumper::FmtView("<{}>"), ids, out));
+        EXPECT_EQ(out.data, "<7><8>");
+        ASSERT_TRUE(jumper::format_bulk(Fmt("{}{}"), pairs, out));
+        EXPECT_EQ(out.data, "a1");
+        ASSERT_TRUE(jumper::format_bulk(Fmt("{}+{}"), arrays, out));
+        EXPECT_EQ(out.data, "3+4");
+    }
+
+    {
+        // 空区间
+        BulkResult out;
+        ASSERT_TRUE(jumper::format_bulk(Fmt("{}"), std::vector<int>(), out));
+        EXPECT_EQ(out.size(), 0);
+        EXPECT_TRUE(out.data.empty());
+    }
+}
+
+TEST(FormatBulkTest, Parallel)
+{
+    Fmt fmt("row {} value {}\n");
+    std::vector<std::tuple<std::size_t, std::string>> rows;
+    for (std::size_t i = 0; i != 100003; ++i)
+    {
+        rows.emplace_back(i, std::string(i % 17, 'x'));
+    }
+
+    BulkResult serial;
+    BulkResult parallel;
+    ASSERT_TRUE(jumper::format_bulk(fmt, rows, serial, 1));
+    ASSERT_TRUE(jumper::format_bulk(fmt, rows, parallel, 8));
+
+    EXPECT_EQ(parallel.data, serial.data);
+    EXPECT_EQ(parallel.offsets, serial.offsets);
+    EXPECT_EQ(parallel.row(12345), "row 12345 value " + std::string(12345 % 17, 'x') + "\n");
+
+    // 第一行（例如表头）很长时按多行的平均长度预估，不会按第一行的长度预留内存
+    std::vector<std::string> lines(200000, "x");
+    lines[0].assign(1 << 20, 'h');
+    for (auto threads: { 1u, 4u })
+    {
+        BulkResult out;
+        ASSERT_TRUE(jumper::format_bulk(Fmt("{}"), lines, out, threads));
+        EXPECT_EQ(out.data.size(), lines[0].size() + lines.size() - 1);
+        EXPECT_LT(out.data.capacity(), 8 * out.data.size());
+    }
+}
+
+TEST(FormatBulkTest, Abnormal)
+{
+    // 参数不足，返回false
+    BulkResult out;
+    std::vector<std::tuple<int>> rows(5000, std::make_tuple(1));
+
+    EXPECT_FALSE(jumper::format_bulk(Fmt("{} {}"), rows, out));
+    EXPECT_FALSE(jumper::format_bulk(Fmt("{} {}"), rows, out, 4));
+    EXPECT_EQ(out.size(), 0);
+    EXPECT_FALSE(jumper::format_bulk(Fmt("{"), rows, out));
+
+    // 格式化时抛出的异常在调用的线程中重新抛出，包括其它线程处理的段
+    std::vector<Checked> values(5000, Checked { 1 });
+    values[10].value = -1;
+    EXPECT_THROW(jumper::format_bulk(Fmt("{}\n"), values, out), std::runtime_error);
+    EXPECT_EQ(out.size(), 0);
+    EXPECT_THROW(jumper::format_bulk(Fmt("{}\n"), values, out, 4), std::runtime_error);
+    EXPECT_EQ(out.size(), 0);
+    values[10].value = 1;
+    ASSERT_TRUE(jumper::format_bulk(Fmt("{}\n"), values, out, 4));
+    EXPECT_EQ(out.size(), values.size());
+}
+
+int main(int argc, char *argv[])
+{
+    std::cout << "Running main() from << " << __FILE__ << "\n";
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
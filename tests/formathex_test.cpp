@@ -0,0 +1,89 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "formathex.h"
+
+namespace {
+
+// 逐字节使用snprintf的参考版本
+std::string hex_bytewise(const std::vector<std::uint8_t>& data)
+{
+    std::string out;
+    char digits[3];
+
+    for (auto byte: data)
+    {
+        std::snprintf(digits, sizeof(digits), "%02x", byte);
+        out += digits;
+    }
+
+    return out;
+}
+
+} // namespace
+
+TEST(FormatHexTest, Hex)
+{
+    const unsigned char packet[] = { 0xde, 0xad, 0xbe, 0xef, 0x00, 0x7f };
+
+    EXPECT_EQ(jumper::format("{}", jumper::hex(packet, sizeof(packet))), "deadbeef007f");
+    EXPECT_EQ(jumper::format("{X}", jumper::hex(packet, sizeof(packet))), "DEADBEEF007F");
+    EXPECT_EQ(jumper::format("[{}]", jumper::hex(packet, 0)), "[]");
+
+    // 连续存储的容器
+    std::string str("AZ");
+    std::vector<std::uint8_t> bytes { 1, 2, 255 };
+    std::array<std::uint16_t, 1> words {{ 0x0102 }};
+    EXPECT_EQ(jumper::format("{} {}", jumper::hex(str), jumper::hex(bytes)), "415a 0102ff");
+    EXPECT_EQ(jumper::format("{}", jumper::hex(words)).size(), 4u);
+}
+
+TEST(FormatHexTest, Blocks)
+{
+    // 覆盖SIMD块和栈上分块的边界，所有字节值都出现
+    for (std::size_t len: { 1u, 15u, 16u, 17u, 31u, 255u, 256u, 257u, 1000u })
+    {
+        std::vector<std::uint8_t> data(len);
+        for (std::size_t i = 0; i != len; ++i)
+        {
+            data[i] = static_cast<std::uint8_t>(i * 37 + 11);
+        }
+        EXPECT_EQ(jumper::format("{}", jumper::hex(data, 0)), hex_bytewise(data)) << len;
+    }
+}
+
+TEST(FormatHexTest, Truncate)
+{
+    std::vector<std::uint8_t> data(10, 0xab);
+
+    EXPECT_EQ(jumper::format("{}", jumper::hex(data, 4)), "abababab...(6 more bytes)");
+    EXPECT_EQ(jumper::format("{}", jumper::hex(data, 10)), "abababababababababab");
+
+    // 默认最多输出kHexMaxBytes个字节
+    std::vector<std::uint8_t> large(jumper::kHexMaxBytes + 100);
+    auto str = jumper::format("{}", jumper::hex(large));
+    EXPECT_EQ(str.size(), 2 * jumper::kHexMaxBytes + std::string("...(100 more bytes)").size());
+}
+
+TEST(FormatHexTest, Hexdump)
+{
+    std::string text("Hello, world.\n\x01\xff!");
+
+    EXPECT_EQ(jumper::format("{}", jumper::hexdump(text)),
+        "00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 2e 0a 01 ff  |Hello, world....|\n"
+        "00000010  21                                                |!|");
+
+    EXPECT_EQ(jumper::format("{X}", jumper::hexdump(text.data(), 10, 8)),
+        "00000000  48 65 6C 6C 6F 2C 20 77  |Hello, w|\n"
+        "00000008  6F 72                    |or|");
+
+    EXPECT_EQ(jumper::format("{}", jumper::hexdump(text, 4, 6)),
+        "00000000  48 65 6c 6c  |Hell|\n"
+        "00000004  6f 2c        |o,|\n"
+        "...(11 more bytes)");
+    EXPECT_EQ(jumper::format("[{}]", jumper::hexdump(text.data(), 0)), "[]");
+}
@@ -0,0 +1,288 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "formathex.h"
+#include "logtracer.h"
+#include "shmring.h"
+#include "test_util.h"
+
+using jumper::FmtSink;
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper_test::read_file;
+
+namespace {
+
+// 记录输出的内容以及每次输出的字节数
+class StringSink: public FmtSink {
+public:
+    bool flush(const char* data, std::size_t len) override
+    {
+        out.append(data, len);
+        sizes.push_back(len);
+
+        return len <= failAfter;
+    }
+
+    std::string out;
+    std::vector<std::size_t> sizes;
+    std::size_t failAfter = static_cast<std::size_t>(-1);
+};
+
+// 通过operator<<分多次输出count行
+struct Lines {
+    int count;
+};
+
+std::ostream& operator<<(std::ostream& os, const Lines& lines)
+{
+    for (int i = 0; i != lines.count; ++i)
+    {
+        os << "line " << i << "\n";
+    }
+
+    return os;
+}
+
+// 输出时又输出一条log
+struct Noisy {
+};
+
+std::ostream& operator<<(std::ostream& os, const Noisy&)
+{
+    LogTracer::LoglnInfo("{}", "nested");
+
+    return os << "noisy";
+}
+
+// 输出时抛出异常
+struct Throwing {
+};
+
+std::ostream& operator<<(std::ostream& os, const Throwing&)
+{
+    throw std::runtime_error("formatter failed");
+
+    return os;
+}
+
+} // namespace
+
+TEST(FormatSinkTest, Stream)
+{
+    // 短的结果只输出一次
+    StringSink small;
+    EXPECT_TRUE(jumper::format_to_sink(small, "{} + {} = {}", 1, 2, 3));
+    EXPECT_EQ(small.out, "1 + 2 = 3");
+    EXPECT_EQ(small.sizes.size(), 1u);
+
+    // 很长的字符串参数不复制到缓冲区
+    std::string big(10 << 20, 'x');
+    StringSink str;
+    EXPECT_TRUE(jumper::format_to_sink(str, "<{}>", big));
+    EXPECT_TRUE(str.out == "<" + big + ">");
+    EXPECT_EQ(str.sizes.size(), 3u);
+
+    // 容器、hexdump和operator<<的输出分段进行，每段不超过缓冲区大小
+    std::vector<int> numbers(1 << 20, 7);
+    std::vector<unsigned char> bytes(1 << 20, 0x41);
+    StringSink parts;
+    EXPECT_TRUE(jumper::format_to_sink(parts, "{}|{}|{}", numbers, jumper::hexdump(bytes),
+        Lines { 100000 }));
+    EXPECT_TRUE(parts.out == jumper::format("{}|{}|{}", numbers, jumper::hexdump(bytes),
+        Lines { 100000 }));
+    EXPECT_GT(parts.sizes.size(), 100u);
+    for (auto n: parts.sizes)
+    {
+        EXPECT_LE(n, jumper::kFmtSinkBufferSize);
+    }
+
+    // 格式串无效或者参数不足时不输出
+    StringSink bad;
+    EXPECT_FALSE(jumper::format_to_sink(bad, "{} {}", 1));
+    EXPECT_TRUE(bad.sizes.empty());
+
+    // 输出失败后不再输出
+    StringSink failing;
+    failing.failAfter = 0;
+    EXPECT_FALSE(jumper::format_to_sink(failing, "{}", numbers));
+    EXPECT_EQ(failing.sizes.size(), 1u);
+}
+
+TEST(FormatSinkTest, Print)
+{
+    std::string big(1 << 20, 'y');
+    std::FILE* fp = std::tmpfile();
+    ASSERT_NE(fp, nullptr);
+
+    EXPECT_TRUE(jumper::println(fp, "a{}b", big));
+    EXPECT_TRUE(jumper::print(fp, "{}", 1));
+    std::fflush(fp);
+    EXPECT_TRUE(jumper::println_fd(::fileno(fp), "c{}", std::vector<int>(100000, 3)));
+    std::fflush(fp);
+
+    std::string out(static_cast<std::size_t>(std::ftell(fp)), '\0');
+    std::rewind(fp);
+    ASSERT_EQ(std::fread(&out[0], 1, out.size(), fp), out.size());
+    std::fclose(fp);
+
+    EXPECT_TRUE(out == "a" + big + "b\n1" + jumper::format("c{}\n", std::vector<int>(100000, 3)));
+}
+
+TEST(FormatSinkTest, LogTracer)
+{
+    const std::string path("./formatsink_test.txt");
+    std::string big(3 << 20, 'z');
+    std::remove(path.c_str());
+
+    for (auto mode: { "buffered", "shared", "compressed" })
+    {
+        LogConfig config;
+        std::string error;
+        ASSERT_TRUE(config.Parse(jumper::format("file.mode = {}\nfile.atomic_size = 8388608\n"
+            "console = off\nfile.path = {}\nlayout = %l %m <%n>\n", mode, path), error)) << error;
+        LogTracer::ApplyConfig(config);
+
+        auto before = LogTracer::Stats().fileBytes;
+        LogTracer::LoglnInfo("short {}", 1);
+        LogTracer::LoglnWarning("big {} {}", big, Noisy {});
+        LogTracer::LoglnInfo("short {}", 2);
+        auto written = LogTracer::Stats().fileBytes - before;
+        LogTracer::FinalTracer();
+
+        auto expected = "INFO short 1 <>\nWARNING big " + big + " noisy <>\nINFO short 2 <>\n";
+        EXPECT_EQ(written, expected.size()) << mode;
+        auto content = read_file(path);
+        if (std::string("compressed") == mode)
+        {
+            std::string raw;
+            std::size_t pos = 0;
+            std::size_t consumed = 0;
+            while (jumper::LzStatus::LZ_OK == jumper::lz_decode_block(content.data() + pos,
+                content.size() - pos, raw, consumed))
+            {
+                pos += consumed;
+            }
+            EXPECT_EQ(pos, content.size());
+            content.swap(raw);
+        }
+        ASSERT_GE(content.size(), expected.size()) << mode;
+        EXPECT_TRUE(content.substr(content.size() - expected.size()) == expected) << mode;
+        std::remove(path.c_str());
+    }
+}
+
+TEST(FormatSinkTest, LogTracerThrow)
+{
+    const std::string path("./formatsink_throw.txt");
+    std::string big(1 << 20, 'q');
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse("console = off\nfile.path = " + path + "\n", error)) << error;
+    LogTracer::ApplyConfig(config);
+
+    // 已经开始分段输出后格式化抛出异常：截断的记录被结束，之后的log正常输出
+    EXPECT_THROW(LogTracer::LoglnWarning("big {} {}", big, Throwing {}), std::runtime_error);
+    EXPECT_THROW(LogTracer::LoglnWarning("small {}", Throwing {}), std::runtime_error);
+    auto before = LogTracer::Stats().fileBytes;
+    LogTracer::LoglnInfo("after {}", 1);
+    EXPECT_EQ(LogTracer::Stats().fileBytes - before, std::string("[INFO]:after 1\n").size());
+    LogTracer::FinalTracer();
+
+    auto content = read_file(path);
+    EXPECT_NE(content.find("[WARNING]:big " + big + "\n[INFO]:after 1\n"), std::string::npos);
+    EXPECT_EQ(content.find("small"), std::string::npos);
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
+
+TEST(FormatSinkTest, LogTracerShared)
+{
+    const std::string path("./formatsink_shared.txt");
+    const std::size_t kAtomicSize = 4096;
+    std::string big(1 << 20, 's');
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse(jumper::format("file.mode = shared\nfile.atomic_size = {}\n"
+        "console = off\nfile.path = {}\n", kAtomicSize, path), error)) << error;
+    LogTracer::ApplyConfig(config);
+
+    // 超长记录每满atomic_size字节写入一段；格式化中又输出的log被丢弃，单独计数
+    auto before = LogTracer::Stats();
+    LogTracer::LoglnWarning("big {} {}", big, Noisy {});
+    auto after = LogTracer::Stats();
+    LogTracer::FinalTracer();
+    EXPECT_EQ(after.nestedDropped - before.nestedDropped, 1u);
+    EXPECT_EQ(after.filtered[1], before.filtered[1]);
+
+    auto content = read_file(path);
+    std::size_t lineBegin = 0;
+    for (auto pos = content.find('\n'); std::string::npos != pos; pos = content.find('\n', pos + 1))
+    {
+        EXPECT_LE(pos + 1 - lineBegin, kAtomicSize);
+        lineBegin = pos + 1;
+    }
+
+    // 去掉拆分标记后为完整的记录
+    auto pid = std::to_string(::getpid());
+    std::string marker("[->" + pid + "]\n[" + pid + "->]:");
+    std::string joined;
+    std::size_t pieces = 1;
+    std::size_t pos = 0;
+    for (auto next = content.find(marker); std::string::npos != next;
+        next = content.find(marker, pos))
+    {
+        joined.append(content, pos, next - pos);
+        pos = next + marker.size();
+        ++pieces;
+    }
+    joined.append(content, pos, std::string::npos);
+    EXPECT_GE(pieces, big.size() / kAtomicSize);
+    std::string expected("[WARNING]:big " + big + " noisy\n");
+    ASSERT_GE(joined.size(), expected.size());
+    EXPECT_TRUE(joined.substr(joined.size() - expected.size()) == expected);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
+
+TEST(FormatSinkTest, LogTracerShm)
+{
+    const std::string name("/jlog.formatsink_shm");
+    std::string big(1 << 20, 'm');
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse(jumper::format("file.mode = shm\nfile.ring_size = 65536\n"
+        "console = off\nfile.path = {}\n", name), error)) << error;
+    LogTracer::ApplyConfig(config);
+
+    // 共享内存中的记录必须连续，超长记录只拼接单条记录的最大字节数，超出部分加上截断标记
+    LogTracer::LoglnWarning("big {}", big);
+    jumper::ShmRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+    std::string out;
+    reader.read(out, 1 << 20);
+    reader.unlink();
+    LogTracer::ApplyConfig(LogConfig());
+
+    auto pos = out.find("[WARNING]:big ");
+    ASSERT_NE(pos, std::string::npos);
+    auto record = out.substr(pos);
+    EXPECT_LE(record.size(), 65536u / 4);
+    auto kept = record.find("...(");
+    ASSERT_NE(kept, std::string::npos);
+    auto body = std::string("big ") + big;
+    EXPECT_EQ(record.substr(0, kept), "[WARNING]:" + body.substr(0, kept - 10));
+    EXPECT_EQ(record.substr(kept),
+        jumper::format("...({} more bytes)\n", body.size() - (kept - 10)));
+}
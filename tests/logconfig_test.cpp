@@ -0,0 +1,211 @@
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper_test::count;
+using jumper_test::file_config;
+using jumper_test::read_file;
+
+namespace {
+
+void write_file(const std::string& path, const std::string& content)
+{
+    std::ofstream ofs(path, std::ios_base::trunc);
+    ofs << content;
+}
+
+// 等待条件成立，最多等待约2秒
+template<typename Pred>
+bool wait_until(Pred pred)
+{
+    for (int i = 0; i != 200 && !pred(); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    return pred();
+}
+
+} // namespace
+
+TEST(LogConfigTest, Parse)
+{
+    LogConfig config;
+    std::string error;
+
+    ASSERT_TRUE(config.Parse(
+        "# comment\n"
+        "level = warning\n"
+        "logger.net.rpc = DEBUG   # trailing comment\n"
+        "\n"
+        "file.path = ./app.log\n"
+        "file.mode = shared\n"
+        "file.atomic_size = 512\n"
+        "file.index_interval = 100\n"
+        "console = off\n"
+        "console.color = off\n"
+        "profile = on\n", error)) << error;
+    EXPECT_EQ(config.level, jumper::LV_WARNING);
+    ASSERT_EQ(config.loggers.size(), 1);
+    EXPECT_EQ(config.loggers["net.rpc"], jumper::LV_DEBUG);
+    EXPECT_EQ(config.filePath, "./app.log");
+    EXPECT_EQ(config.fileMode, jumper::FileMode::FILE_SHARED);
+    EXPECT_EQ(config.atomicSize, 512);
+    EXPECT_EQ(config.indexInterval, 100);
+    EXPECT_FALSE(config.console);
+    EXPECT_FALSE(config.consoleColor);
+    EXPECT_TRUE(config.profile);
+
+    // 没有出现的项使用默认值
+    LogConfig empty;
+    ASSERT_TRUE(empty.Parse("", error));
+    EXPECT_EQ(empty.level, jumper::LV_INFO);
+    EXPECT_TRUE(empty.filePath.empty());
+    EXPECT_TRUE(empty.console);
+    EXPECT_FALSE(empty.profile);
+
+    EXPECT_FALSE(LogConfig().Parse("level INFO\n", error));
+    EXPECT_EQ(error, "line 1: missing '='");
+    EXPECT_FALSE(LogConfig().Parse("\nlevel = LOUD\n", error));
+    EXPECT_EQ(error, "line 2: bad value 'LOUD' for level");
+    EXPECT_FALSE(LogConfig().Parse("colour = on\n", error));
+    EXPECT_EQ(error, "line 1: unknown key 'colour'");
+    EXPECT_FALSE(LogConfig().Parse("file.atomic_size = -1\n", error));
+    EXPECT_FALSE(LogConfig().Parse("console = yes\n", error));
+
+    ASSERT_TRUE(config.Parse("file.mode = compressed\nfile.block_size = 32768\n", error)) << error;
+    EXPECT_EQ(config.fileMode, jumper::FileMode::FILE_COMPRESSED);
+    EXPECT_EQ(config.blockSize, 32768u);
+    // 数据块最大64KB
+    EXPECT_FALSE(LogConfig().Parse("file.block_size = 65537\n", error));
+}
+
+TEST(LogConfigTest, Apply)
+{
+    const std::string path("./logconfig_test.txt");
+    std::remove(path.c_str());
+
+    // InitialTracer使用传入的log级别
+    LogTracer::InitialTracer(jumper::LV_WARNING, path);
+    EXPECT_EQ(LogTracer::Root().EffectiveLevel(), jumper::LV_WARNING);
+    EXPECT_EQ(LogTracer::Config().filePath, path);
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse(jumper::format(
+        "level = ERROR\nlogger.cfg.a = DEBUG\nfile.path = {}\nconsole = off\n", path), error));
+    LogTracer::ApplyConfig(config);
+    EXPECT_EQ(LogTracer::Root().EffectiveLevel(), jumper::LV_ERROR);
+    EXPECT_EQ(jumper::get_logger("cfg.a").EffectiveLevel(), jumper::LV_DEBUG);
+    EXPECT_EQ(jumper::get_logger("cfg").EffectiveLevel(), jumper::LV_ERROR);
+
+    // log文件的设置没有改变，不会重新打开（没有新的会话分隔符）
+    jumper::get_logger("cfg.a").LoglnDebug("kept open");
+    LogTracer::LoglnWarning("filtered");
+
+    // 不再配置的命名logger恢复继承
+    config.loggers.clear();
+    config.level = jumper::LV_INFO;
+    LogTracer::ApplyConfig(config);
+    EXPECT_EQ(jumper::get_logger("cfg.a").EffectiveLevel(), jumper::LV_INFO);
+
+    // 关闭log文件
+    config.filePath.clear();
+    LogTracer::ApplyConfig(config);
+    LogTracer::LoglnInfo("not in file");
+
+    auto content(read_file(path));
+    EXPECT_EQ(content.find("--------------------"), content.rfind("--------------------"));
+    EXPECT_NE(content.find("[DEBUG]:[cfg.a] kept open\n"), std::string::npos);
+    EXPECT_EQ(content.find("filtered"), std::string::npos);
+    EXPECT_EQ(content.find("not in file"), std::string::npos);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
+
+// 输出log的同时反复发布新配置，旧快照在读取的线程退出后才释放
+TEST(LogConfigTest, Publish)
+{
+    const std::string path("./logconfig_publish.txt");
+    std::remove(path.c_str());
+
+    auto config(file_config(path));
+    LogTracer::ApplyConfig(config);
+
+    const int kThreads = 4;
+    const int kLines = 2000;
+    std::atomic<int> running { kThreads };
+    std::vector<std::thread> threads;
+    for (int t = 0; t != kThreads; ++t)
+    {
+        threads.emplace_back([t, &running]() {
+            for (int i = 0; i != kLines; ++i)
+            {
+                LogTracer::LoglnInfo("publish {} {}", t, i);
+            }
+            --running;
+        });
+    }
+    while (running)
+    {
+        config.consoleColor = !config.consoleColor;
+        LogTracer::ApplyConfig(config);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    LogTracer::ApplyConfig(LogConfig());
+    EXPECT_EQ(count(read_file(path), "[INFO]:publish "),
+        static_cast<std::size_t>(kThreads * kLines));
+    std::remove(path.c_str());
+}
+
+TEST(LogConfigTest, Watch)
+{
+    const std::string cfgPath("./logconfig_test.conf");
+    const std::string logPath("./logconfig_watch.txt");
+    std::remove(logPath.c_str());
+
+    write_file(cfgPath, "level = ERROR\nconsole = off\n");
+    ASSERT_TRUE(LogTracer::WatchConfig(cfgPath, std::chrono::milliseconds(10)));
+    EXPECT_EQ(LogTracer::Root().EffectiveLevel(), jumper::LV_ERROR);
+
+    // 修改配置文件后自动重新加载
+    write_file(cfgPath, jumper::format(
+        "level = DEBUG\nfile.path = {}\nconsole = off\n# modified\n", logPath));
+    EXPECT_TRUE(wait_until([]() {
+        return LogTracer::Root().EffectiveLevel() == jumper::LV_DEBUG;
+    }));
+    EXPECT_TRUE(wait_until([&]() { return LogTracer::Config().filePath == logPath; }));
+
+    // 格式错误的配置文件不会改变当前配置
+    write_file(cfgPath, "level = LOUD\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(LogTracer::Root().EffectiveLevel(), jumper::LV_DEBUG);
+
+    // 收到SIGHUP时重新加载
+    LogTracer::SetLogLevel(jumper::LV_ERROR);
+    write_file(cfgPath, "level = WARNING\nconsole = off\n");
+    std::raise(SIGHUP);
+    EXPECT_TRUE(wait_until([]() {
+        return LogTracer::Root().EffectiveLevel() == jumper::LV_WARNING;
+    }));
+
+    LogTracer::UnwatchConfig();
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(cfgPath.c_str());
+    std::remove(logPath.c_str());
+}
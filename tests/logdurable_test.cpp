@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper_test::file_config;
+using jumper_test::read_file;
+
+TEST(LogDurableTest, FlushDurable)
+{
+    // 没有写入任何记录时立即完成
+    EXPECT_TRUE(LogTracer::FlushDurable().wait());
+
+    const std::string path("./logdurable_test.txt");
+    std::remove(path.c_str());
+    LogTracer::ApplyConfig(file_config(path));
+
+    LogTracer::LoglnInfo("durable {}", 1);
+    auto syncs = LogTracer::Stats().syncs;
+    auto handle = LogTracer::FlushDurable();
+
+    ASSERT_TRUE(handle.wait_for(std::chrono::milliseconds(5000)));
+    EXPECT_TRUE(handle.ready());
+    EXPECT_GT(LogTracer::Stats().syncs, syncs);
+    // 同步之前缓冲的内容已经交给内核
+    EXPECT_NE(read_file(path).find("[INFO]:durable 1\n"), std::string::npos);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
+
+TEST(LogDurableTest, GroupCommit)
+{
+    const std::string path("./logdurable_group.txt");
+    const int kThreads = 8;
+    const int kRecords = 50;
+    std::remove(path.c_str());
+    LogTracer::ApplyConfig(file_config(path));
+
+    auto before = LogTracer::Stats();
+    std::vector<std::thread> workers;
+    std::vector<int> failures(kThreads, 0);
+
+    for (int t = 0; t != kThreads; ++t)
+    {
+        workers.emplace_back([t, &failures]() {
+            for (int i = 0; i != kRecords; ++i)
+            {
+                LogTracer::LoglnInfo("thread {} record {}", t, i);
+                failures[t] += !LogTracer::FlushDurable().wait();
+            }
+        });
+    }
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+
+    auto after = LogTracer::Stats();
+    for (auto failure: failures)
+    {
+        EXPECT_EQ(failure, 0);
+    }
+    EXPECT_EQ(after.syncRequests - before.syncRequests, kThreads * kRecords);
+    // 多个线程的请求共享fdatasync，同步次数不会超过请求次数
+    EXPECT_LE(after.syncs - before.syncs, after.syncRequests - before.syncRequests);
+    std::cout << "requests: " << after.syncRequests - before.syncRequests
+        << ", syncs: " << after.syncs - before.syncs << "\n";
+
+    auto content(read_file(path));
+    EXPECT_NE(content.find("thread 7 record 49\n"), std::string::npos);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
+
+TEST(LogDurableTest, SyncLevel)
+{
+    const std::string path("./logdurable_level.txt");
+    std::remove(path.c_str());
+
+    auto config(file_config(path));
+    std::string error;
+    ASSERT_TRUE(config.Parse("file.sync_level = ERROR\n", error)) << error;
+    EXPECT_EQ(config.syncLevel, static_cast<int>(jumper::LV_ERROR));
+    LogTracer::ApplyConfig(config);
+
+    // Error级别的log返回时已经同步，Info级别的不等待同步
+    auto requests = LogTracer::Stats().syncRequests;
+    LogTracer::LoglnInfo("not synced");
+    EXPECT_EQ(LogTracer::Stats().syncRequests, requests);
+    LogTracer::LoglnError("synced {}", 42);
+    EXPECT_EQ(LogTracer::Stats().syncRequests, requests + 1);
+    EXPECT_NE(read_file(path).find("[ERROR]:synced 42\n"), std::string::npos);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,105 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::Fmt;
+using jumper::Logger;
+using jumper::LogTracer;
+using jumper_test::read_file;
+
+TEST(LoggerTest, Hierarchy)
+{
+    LogTracer::SetLogLevel(jumper::LV_WARNING);
+
+    Logger& rpc = jumper::get_logger("net.rpc");
+    Logger& net = jumper::get_logger("net");
+    Logger& db = jumper::get_logger("db");
+
+    // 同名返回同一个对象，上级会被自动创建
+    EXPECT_EQ(&rpc, &jumper::get_logger("net.rpc"));
+    EXPECT_EQ(&jumper::get_logger(""), &LogTracer::Root());
+    EXPECT_EQ(rpc.Name(), "net.rpc");
+    EXPECT_EQ(net.Name(), "net");
+    EXPECT_EQ(LogTracer::Root().Name(), "");
+
+    // 没有单独设置级别时继承根logger
+    EXPECT_EQ(rpc.EffectiveLevel(), jumper::LV_WARNING);
+    EXPECT_FALSE(rpc.IsEnabled(jumper::LV_INFO));
+
+    // 只提高net.rpc的详细程度，其它logger不受影响
+    rpc.SetLevel(jumper::LV_DEBUG);
+    EXPECT_TRUE(rpc.IsEnabled(jumper::LV_DEBUG));
+    EXPECT_EQ(net.EffectiveLevel(), jumper::LV_WARNING);
+    EXPECT_EQ(db.EffectiveLevel(), jumper::LV_WARNING);
+
+    // 设置上级，继承的下级随之改变，单独设置过的下级保持不变
+    Logger& pool = jumper::get_logger("net.pool");
+    net.SetLevel(jumper::LV_ERROR);
+    EXPECT_EQ(pool.EffectiveLevel(), jumper::LV_ERROR);
+    EXPECT_EQ(rpc.EffectiveLevel(), jumper::LV_DEBUG);
+
+    // 设置根logger，只影响继承的logger
+    LogTracer::SetLogLevel(jumper::LV_INFO);
+    EXPECT_EQ(db.EffectiveLevel(), jumper::LV_INFO);
+    EXPECT_EQ(pool.EffectiveLevel(), jumper::LV_ERROR);
+
+    // 取消单独设置的级别，重新继承上级
+    net.ResetLevel();
+    EXPECT_EQ(pool.EffectiveLevel(), jumper::LV_INFO);
+    rpc.ResetLevel();
+    EXPECT_EQ(rpc.EffectiveLevel(), jumper::LV_INFO);
+
+    // 根logger不能取消级别
+    LogTracer::Root().ResetLevel();
+    EXPECT_EQ(LogTracer::Root().EffectiveLevel(), jumper::LV_INFO);
+}
+
+TEST(LoggerTest, Output)
+{
+    const std::string path("./logger_test.txt");
+    std::remove(path.c_str());
+
+    LogTracer::InitialTracer(jumper::LV_INFO, path);
+    LogTracer::SetLogLevel(jumper::LV_WARNING);
+
+    Logger& rpc = jumper::get_logger("svc.rpc");
+    rpc.SetLevel(jumper::LV_DEBUG);
+
+    Fmt fmt("call {} took {}us");
+    rpc.LoglnDebug(fmt, "Get", 12);
+    rpc.LoglnInfo("plain {{text}}");
+    jumper::get_logger("svc").LoglnInfo("filtered {}", 1);
+    jumper::get_logger("svc").LoglnError("failed {}", 2);
+    LogTracer::LoglnInfo("filtered too");
+    LogTracer::LoglnWarning("root {}", 3);
+
+    // 多个线程同时获取和使用logger
+    std::vector<std::thread> workers;
+    for (int i = 0; i != 4; ++i)
+    {
+        workers.emplace_back([i]() {
+            jumper::get_logger("svc.worker").LoglnWarning("worker {}", i);
+        });
+    }
+    for (auto& worker: workers)
+    {
+        worker.join();
+    }
+    LogTracer::FinalTracer();
+    rpc.ResetLevel();
+
+    auto content(read_file(path));
+    EXPECT_NE(content.find("[DEBUG]:[svc.rpc] call Get took 12us\n"), std::string::npos);
+    EXPECT_NE(content.find("[INFO]:[svc.rpc] plain {{text}}\n"), std::string::npos);
+    EXPECT_EQ(content.find("filtered"), std::string::npos);
+    EXPECT_NE(content.find("[ERROR]:[svc] failed 2\n"), std::string::npos);
+    EXPECT_NE(content.find("[WARNING]:root 3\n"), std::string::npos);
+    EXPECT_NE(content.find("[WARNING]:[svc.worker] worker 3\n"), std::string::npos);
+
+    std::remove(path.c_str());
+}
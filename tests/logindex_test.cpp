@@ -0,0 +1,200 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::LogIndexEntry;
+using jumper::LogTracer;
+using jumper_test::file_config;
+using jumper_test::read_file;
+
+namespace {
+
+// 读取索引文件中的所有索引项
+std::vector<LogIndexEntry> read_index(const std::string& logPath)
+{
+    auto data(read_file(jumper::log_index_path(logPath)));
+    std::vector<LogIndexEntry> entries;
+
+    if (data.size() < sizeof(jumper::kLogIndexMagic)
+        || 0 != data.compare(0, sizeof(jumper::kLogIndexMagic), jumper::kLogIndexMagic,
+            sizeof(jumper::kLogIndexMagic)))
+    {
+        return entries;
+    }
+
+    entries.resize((data.size() - sizeof(jumper::kLogIndexMagic)) / sizeof(LogIndexEntry));
+    data.copy(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(LogIndexEntry),
+        sizeof(jumper::kLogIndexMagic));
+
+    return entries;
+}
+
+// 运行jlog_query，返回标准输出
+std::string run_query(const std::string& args)
+{
+    std::string out;
+    FILE* fp = ::popen((std::string(JLOG_QUERY_PATH) + " " + args + " 2>/dev/null").c_str(), "r");
+    char buf[4096];
+    std::size_t n;
+
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        out.append(buf, n);
+    }
+    EXPECT_EQ(WEXITSTATUS(::pclose(fp)), 0) << args;
+
+    return out;
+}
+
+} // namespace
+
+TEST(LogIndexTest, Normal)
+{
+    const std::string path("./logindex_test.txt");
+    std::remove(path.c_str());
+    std::remove(jumper::log_index_path(path).c_str());
+
+    LogTracer::SetIndexInterval(4);
+    LogTracer::InitialTracer(jumper::LV_DEBUG, path);
+    for (int i = 0; i != 10; ++i)
+    {
+        if (i % 5 == 4)
+        {
+            LogTracer::LoglnError("record {}", i);
+        }
+        else
+        {
+            LogTracer::LoglnInfo("record {}", i);
+        }
+    }
+    LogTracer::FinalTracer();
+
+    auto log(read_file(path));
+    auto entries(read_index(path));
+
+    // 每4条一项，最后不满的一项在关闭时写入
+    ASSERT_EQ(entries.size(), 3);
+    EXPECT_EQ(entries[0].count, 4);
+    EXPECT_EQ(entries[1].count, 4);
+    EXPECT_EQ(entries[2].count, 2);
+    EXPECT_EQ(entries[0].levelMask, 1u << 1);
+    EXPECT_EQ(entries[1].levelMask, (1u << 1) | (1u << 3));
+    EXPECT_EQ(entries[2].levelMask, (1u << 1) | (1u << 3));
+
+    for (std::size_t i = 0; i != entries.size(); ++i)
+    {
+        const auto& entry = entries[i];
+        EXPECT_EQ(entry.seq, i * 4);
+        EXPECT_LE(entry.beginMs, entry.endMs);
+        ASSERT_LE(entry.offset + entry.length, log.size());
+
+        // 索引项描述的内容恰好是对应的log记录
+        auto text(log.substr(entry.offset, entry.length));
+        std::string expected;
+        for (std::uint64_t seq = entry.seq; seq != entry.seq + entry.count; ++seq)
+        {
+            expected += jumper::format("{}record {}\n",
+                seq % 5 == 4 ? "[ERROR]:" : "[INFO]:", seq);
+        }
+        EXPECT_EQ(text, expected);
+    }
+    EXPECT_EQ(entries[0].offset + entries[0].length, entries[1].offset);
+
+    // 追加到已有的log文件，偏移量从文件末尾开始
+    LogTracer::InitialTracer(jumper::LV_DEBUG, path);
+    LogTracer::LoglnWarning("appended");
+    auto loggedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // 未满的索引项在关闭时写入，结束时间仍为最后一条记录的时间
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    LogTracer::FinalTracer();
+    LogTracer::SetIndexInterval(0);
+
+    log = read_file(path);
+    entries = read_index(path);
+    ASSERT_EQ(entries.size(), 4);
+    EXPECT_EQ(entries[3].levelMask, 1u << 2);
+    EXPECT_LE(entries[3].endMs, loggedMs);
+    EXPECT_EQ(log.substr(entries[3].offset, entries[3].length), "[WARNING]:appended\n");
+
+    std::remove(path.c_str());
+    std::remove(jumper::log_index_path(path).c_str());
+}
+
+TEST(LogIndexTest, Query)
+{
+    const std::string path("./logindex_query.txt");
+    std::remove(path.c_str());
+    std::remove(jumper::log_index_path(path).c_str());
+
+    // 默认头部，多行记录；记录足够多时多个线程分段扫描，分段可能从记录的后续行开始
+    const int kRecords = 20000;
+    std::string errors;
+    auto config(file_config(path));
+    config.level = jumper::LV_DEBUG;
+    config.indexInterval = 1000;
+    LogTracer::ApplyConfig(config);
+    for (int i = 0; i != kRecords; ++i)
+    {
+        if (i % 5 == 4)
+        {
+            LogTracer::LoglnError("record {}\ncont {}", i, i);
+            errors += jumper::format("[ERROR]:record {}\ncont {}\n", i, i);
+        }
+        else
+        {
+            LogTracer::LoglnInfo("record {}\ncont {}", i, i);
+        }
+    }
+    LogTracer::FinalTracer();
+
+    auto log(read_file(path));
+    auto entries(read_index(path));
+    ASSERT_FALSE(entries.empty());
+    EXPECT_EQ(run_query(path), log.substr(entries[0].offset));
+    // 后续行跟随所在的记录
+    EXPECT_EQ(run_query(path + " --level ERROR --threads 8"), errors);
+    EXPECT_EQ(run_query(path + " --level ERROR --threads 1"), errors);
+    std::remove(jumper::log_index_path(path).c_str());
+    // 没有索引时扫描整个文件
+    EXPECT_EQ(run_query(path + " --level ERROR --threads 8"), errors);
+    std::remove(path.c_str());
+    std::remove(jumper::log_index_path(path).c_str());
+
+    // 使用布局时没有默认头部：不过滤级别时输出所有记录，过滤级别时按索引项的级别
+    LogTracer::SetIndexInterval(5);
+    LogTracer::InitialTracer(jumper::LV_DEBUG, path, "%T [%l] %m");
+    for (int i = 0; i != 10; ++i)
+    {
+        if (i < 5)
+        {
+            LogTracer::LoglnInfo("record {}", i);
+        }
+        else
+        {
+            LogTracer::LoglnError("record {}", i);
+        }
+    }
+    LogTracer::FinalTracer();
+    LogTracer::ApplyConfig(jumper::LogConfig());
+    LogTracer::SetIndexInterval(0);
+
+    log = read_file(path);
+    entries = read_index(path);
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(run_query(path), log.substr(entries[0].offset));
+    EXPECT_EQ(run_query(path + " --level ERROR"), log.substr(entries[1].offset));
+    EXPECT_EQ(run_query(path + " --level INFO"),
+        log.substr(entries[0].offset, entries[0].length));
+
+    std::remove(path.c_str());
+    std::remove(jumper::log_index_path(path).c_str());
+}
@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <regex>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "logsite.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogLayout;
+using jumper::LogTracer;
+using jumper_test::read_file;
+
+TEST(LogLayoutTest, Compile)
+{
+    LogLayout layout;
+    std::string error;
+
+    EXPECT_FALSE(layout.Compile("[%l]", error));
+    EXPECT_EQ(error, "missing %m");
+    EXPECT_FALSE(layout.Compile("%m %m", error));
+    EXPECT_FALSE(layout.Compile("%q %m", error));
+    EXPECT_EQ(error, "unknown placeholder '%q'");
+    EXPECT_FALSE(layout.Compile("%m %", error));
+
+    ASSERT_TRUE(layout.Compile("[%l] %m", error)) << error;
+    EXPECT_EQ(layout.Pattern(), "[%l] %m");
+    // 编译失败时原有的布局不变
+    EXPECT_FALSE(layout.Compile("%x", error));
+    EXPECT_EQ(layout.Pattern(), "[%l] %m");
+}
+
+TEST(LogLayoutTest, Render)
+{
+    LogLayout layout;
+    std::string error;
+    std::string buf;
+    std::string tail;
+    jumper::LogLocation where { "src/net/rpc.cpp", 120, "send" };
+
+    ASSERT_TRUE(layout.Compile("[%l] %n %s:%# %f: %m <100%%>", error)) << error;
+    EXPECT_EQ(layout.Render(buf, tail, static_cast<int>(jumper::LV_WARNING), "net.rpc", &where),
+        "[WARNING] net.rpc rpc.cpp:120 send: ");
+    EXPECT_EQ(tail, " <100%>");
+
+    // 没有来源位置时输出"-"，每次输出覆盖之前的内容
+    EXPECT_EQ(layout.Render(buf, tail, static_cast<int>(jumper::LV_INFO), "", nullptr),
+        "[INFO]  -:- -: ");
+
+    // 头部为常量时直接返回编译时生成的头部
+    ASSERT_TRUE(layout.Compile("[%l]:%m", error)) << error;
+    buf.clear();
+    const auto& head = layout.Render(buf, tail, static_cast<int>(jumper::LV_ERROR), "db", nullptr);
+    EXPECT_EQ(head, "[ERROR]:");
+    EXPECT_NE(&head, &buf);
+    EXPECT_TRUE(tail.empty());
+
+    ASSERT_TRUE(layout.Compile("%T %t %N|%m", error)) << error;
+    LogTracer::SetThreadName("layout-main");
+    EXPECT_TRUE(std::regex_match(
+        layout.Render(buf, tail, static_cast<int>(jumper::LV_INFO), "", nullptr),
+        std::regex(R"(\d{4}-\d\d-\d\d \d\d:\d\d:\d\d\.\d{3} \d+ layout-main\|)"))) << buf;
+}
+
+TEST(LogLayoutTest, LogTracer)
+{
+    const std::string path("./loglayout_test.txt");
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    // 布局中的"%#"不是注释，空白之后的'#'才是
+    ASSERT_TRUE(config.Parse("layout = %l|%n|%s:%#|%m|  # comment\nconsole = off\n", error))
+        << error;
+    EXPECT_EQ(config.layout, "%l|%n|%s:%#|%m|");
+    EXPECT_FALSE(config.Parse("layout = [%l]\n", error));
+
+    config.filePath = path;
+    LogTracer::ApplyConfig(config);
+    LogTracer::LoglnInfo("plain {}", 1);
+    jumper::get_logger("layout.db").LoglnWarning("named");
+    const int line = __LINE__ + 1;
+    JLOG_ERROR("site {}", 2);
+
+    // 去掉布局后恢复默认的头部
+    config.layout.clear();
+    LogTracer::ApplyConfig(config);
+    LogTracer::LoglnInfo("default");
+    LogTracer::ApplyConfig(LogConfig());
+
+    auto content(read_file(path));
+    EXPECT_NE(content.find("\nINFO||-:-|plain 1|\n"), std::string::npos);
+    EXPECT_NE(content.find("\nWARNING|layout.db|-:-|named|\n"), std::string::npos);
+    EXPECT_NE(content.find(jumper::format("\nERROR||loglayout_test.cpp:{}|site 2|\n", line)),
+        std::string::npos);
+    EXPECT_NE(content.find("\n[INFO]:default\n"), std::string::npos);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,149 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "logsite.h"
+
+using jumper::LogConfig;
+using jumper::LogSiteProfile;
+using jumper::LogTracer;
+
+namespace {
+
+void apply(const std::string& text)
+{
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse(text, error)) << error;
+    LogTracer::ApplyConfig(config);
+}
+
+// 按格式串查找调用点，没有时返回nullptr
+const LogSiteProfile* find(const std::vector<LogSiteProfile>& sites, const std::string& format)
+{
+    for (const auto& site: sites)
+    {
+        if (site.format == format)
+        {
+            return &site;
+        }
+    }
+
+    return nullptr;
+}
+
+} // namespace
+
+TEST(LogProfileTest, Sites)
+{
+    const int rate = LogTracer::kProfileSampleRate;
+    std::vector<int> numbers(5000, 42);
+
+    apply("profile = on\nconsole = off\n");
+    LogTracer::ResetProfile();
+
+    for (int i = 0; i != 100 * rate; ++i)
+    {
+        LogTracer::LoglnInfo("fast {}", i);
+    }
+    const int slowLine = __LINE__ + 3;
+    for (int i = 0; i != 10 * rate; ++i)
+    {
+        JLOG_INFO("slow {}", numbers);
+    }
+    // 内容相同的格式串合并统计
+    for (int i = 0; i != 10 * rate; ++i)
+    {
+        LogTracer::LoglnInfo(jumper::Fmt("fast {}"), i);
+    }
+
+    auto sites = LogTracer::Profile();
+    ASSERT_EQ(sites.size(), 2u);
+
+    auto slow = find(sites, "slow {}");
+    ASSERT_NE(slow, nullptr);
+    EXPECT_EQ(slow, &sites[0]);
+    EXPECT_EQ(slow->site, jumper::format("{}:{}", __FILE__, slowLine));
+    EXPECT_NEAR(static_cast<double>(slow->samples), 10, 1);
+    EXPECT_EQ(slow->bytes, slow->samples * jumper::format("slow {}", numbers).size());
+
+    auto fast = find(sites, "fast {}");
+    ASSERT_NE(fast, nullptr);
+    EXPECT_TRUE(fast->site.empty());
+    EXPECT_NEAR(static_cast<double>(fast->samples), 110, 1);
+    EXPECT_GT(slow->formatNs / slow->samples, fast->formatNs / fast->samples);
+
+    std::ostringstream oss;
+    LogTracer::DumpProfile(oss, 1);
+    auto report = oss.str();
+    EXPECT_NE(report.find("profile of 2 sites"), std::string::npos) << report;
+    EXPECT_NE(report.find(slow->site + " \"slow {}\""), std::string::npos) << report;
+    EXPECT_EQ(report.find("fast"), std::string::npos) << report;
+
+    LogTracer::ResetProfile();
+    EXPECT_TRUE(LogTracer::Profile().empty());
+}
+
+TEST(LogProfileTest, Overflow)
+{
+    const int rate = LogTracer::kProfileSampleRate;
+    const std::size_t extra = 100;
+
+    apply("profile = on\nconsole = off\n");
+    LogTracer::ResetProfile();
+
+    // 动态生成的格式串，每个格式串连续调用rate次，恰好抽样一次
+    for (std::size_t n = 0; n != LogTracer::kProfileMaxSites + extra; ++n)
+    {
+        std::string format(jumper::format("dynamic {} {{}}", n));
+        for (int i = 0; i != rate; ++i)
+        {
+            LogTracer::LoglnInfo(format, i);
+        }
+    }
+
+    auto sites = LogTracer::Profile();
+    ASSERT_EQ(sites.size(), LogTracer::kProfileMaxSites + 1);
+    auto other = find(sites, "(other)");
+    ASSERT_NE(other, nullptr);
+    EXPECT_TRUE(other->site.empty());
+    EXPECT_EQ(other->samples, extra);
+
+    // 已有的调用点继续单独统计
+    for (int i = 0; i != rate; ++i)
+    {
+        LogTracer::LoglnInfo(std::string("dynamic 0 {}"), i);
+    }
+    sites = LogTracer::Profile();
+    EXPECT_EQ(sites.size(), LogTracer::kProfileMaxSites + 1);
+    EXPECT_EQ(find(sites, "dynamic 0 {}")->samples, 2u);
+
+    apply("console = off\n");
+    LogTracer::ResetProfile();
+}
+
+TEST(LogProfileTest, Off)
+{
+    apply("console = off\n");
+    LogTracer::ResetProfile();
+
+    for (int i = 0; i != 10 * LogTracer::kProfileSampleRate; ++i)
+    {
+        LogTracer::LoglnInfo("value {}", i);
+    }
+    EXPECT_TRUE(LogTracer::Profile().empty());
+
+    // 格式串中的换行在报告中被转义
+    apply("profile = on\nconsole = off\n");
+    for (int i = 0; i != LogTracer::kProfileSampleRate; ++i)
+    {
+        LogTracer::LogInfo("a\nb {}", i);
+    }
+    std::ostringstream oss;
+    LogTracer::DumpProfile(oss);
+    EXPECT_NE(oss.str().find("\"a\\nb {}\""), std::string::npos) << oss.str();
+
+    apply("console = off\n");
+    LogTracer::ResetProfile();
+}
@@ -0,0 +1,147 @@
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+
+using jumper::LogTracer;
+
+namespace {
+
+// 第index条记录的内容，长度变化范围覆盖需要拆分的记录
+std::string record_body(int index)
+{
+    return std::string(static_cast<std::size_t>(index * 37 % 700),
+        static_cast<char>('a' + index % 26));
+}
+
+// 子进程：向同一个log文件追加count条记录
+void run_writer(const std::string& path, int count, std::size_t atomicSize)
+{
+    // 终端输出重定向到/dev/null
+    int devNull = ::open("/dev/null", O_WRONLY);
+    ::dup2(devNull, STDOUT_FILENO);
+    ::dup2(devNull, STDERR_FILENO);
+
+    LogTracer::SetFileMode(jumper::FileMode::FILE_SHARED, atomicSize);
+    LogTracer::InitialTracer(jumper::LV_DEBUG, path);
+    LogTracer::SetLogLevel(jumper::LV_DEBUG);
+    for (int i = 0; i != count; ++i)
+    {
+        LogTracer::LoglnInfo("p{} n{} {}", ::getpid(), i, record_body(i));
+    }
+    LogTracer::FinalTracer();
+    ::_exit(0);
+}
+
+bool starts_with(const std::string& str, const std::string& prefix)
+{
+    return 0 == str.compare(0, prefix.size(), prefix);
+}
+
+bool ends_with(const std::string& str, const std::string& suffix)
+{
+    return str.size() >= suffix.size()
+        && 0 == str.compare(str.size() - suffix.size(), suffix.size(), suffix);
+}
+
+} // namespace
+
+TEST(LogSinkTest, SharedAppend)
+{
+    const std::string path("./logsink_test.txt");
+    const int kProcesses = 8;
+    const int kRecords = 500;
+    const std::size_t kAtomicSize = 256;
+    std::vector<pid_t> pids;
+
+    std::remove(path.c_str());
+    std::cout << std::flush;
+    for (int i = 0; i != kProcesses; ++i)
+    {
+        pid_t pid = ::fork();
+        ASSERT_GE(pid, 0);
+        if (0 == pid)
+        {
+            run_writer(path, kRecords, kAtomicSize);
+        }
+        pids.push_back(pid);
+    }
+    for (auto pid: pids)
+    {
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        ASSERT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+    }
+
+    // 逐行检查：每一行都是完整的会话分隔符、时间戳、log记录或者拆分后的一段
+    std::ifstream ifs(path);
+    std::string line;
+    std::map<std::string, std::string> pending;
+    std::map<std::string, std::set<int>> seen;
+    int sessions = 0;
+
+    while (std::getline(ifs, line))
+    {
+        ASSERT_LE(line.size() + 1, kAtomicSize);
+        if ("--------------------" == line)
+        {
+            ++sessions;
+            continue;
+        }
+        if (19 == line.size() && '-' == line[4] && ':' == line[13])
+        {
+            continue;
+        }
+
+        std::string pid;
+        std::string text;
+        if (starts_with(line, "[INFO]:p"))
+        {
+            pid = line.substr(8, line.find(' ') - 8);
+            ASSERT_EQ(pending.count(pid), 0u) << line;
+            text = line.substr(7);
+        }
+        else
+        {
+            auto pos = line.find("->]:");
+            ASSERT_TRUE(starts_with(line, "[") && std::string::npos != pos) << line;
+            pid = line.substr(1, pos - 1);
+            ASSERT_EQ(pending.count(pid), 1u) << line;
+            text = pending[pid] + line.substr(pos + 4);
+            pending.erase(pid);
+        }
+
+        // 除最后一段外，每段以"[->pid]"结尾
+        std::string tail("[->" + pid + "]");
+        if (ends_with(text, tail))
+        {
+            pending[pid] = text.substr(0, text.size() - tail.size());
+            continue;
+        }
+
+        auto pos = text.find(" n");
+        ASSERT_NE(pos, std::string::npos) << text;
+        int index = std::stoi(text.substr(pos + 2));
+        EXPECT_EQ(text, jumper::format("p{} n{} {}", pid, index, record_body(index)));
+        EXPECT_TRUE(seen[pid].insert(index).second) << text;
+    }
+
+    EXPECT_EQ(sessions, kProcesses);
+    EXPECT_TRUE(pending.empty());
+    ASSERT_EQ(seen.size(), static_cast<std::size_t>(kProcesses));
+    for (const auto& kv: seen)
+    {
+        EXPECT_EQ(kv.second.size(), static_cast<std::size_t>(kRecords));
+    }
+
+    std::remove(path.c_str());
+}
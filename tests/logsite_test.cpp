@@ -0,0 +1,163 @@
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "logsite.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogSite;
+using jumper::LogTracer;
+using jumper_test::count;
+using jumper_test::file_config;
+using jumper_test::read_file;
+
+namespace {
+
+// 两个调用点，行号固定，供规则匹配
+const int kDebugLine = __LINE__ + 3;
+void debug_site(int value)
+{
+    JLOG_DEBUG("debug site {}", value);
+}
+
+const int kRpcLine = __LINE__ + 3;
+void rpc_site(jumper::Logger& rpc)
+{
+    JLOG_AT(rpc, jumper::LV_DEBUG, "rpc site");
+}
+
+// 每次调用返回下一个序号
+int g_nextId = 0;
+int next_id()
+{
+    return ++g_nextId;
+}
+
+// 参数有副作用的调用点
+void counted_site(jumper::Logger& logger)
+{
+    JLOG_AT(logger, jumper::LV_INFO, "id {}", next_id());
+}
+
+// 已注册的调用点中位于此行的调用点
+bool find_site(int line, jumper::LogSiteInfo& info)
+{
+    for (const auto& site: LogSite::List())
+    {
+        if (line == site.line)
+        {
+            info = site;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+TEST(LogSiteTest, Rule)
+{
+    const std::string path("./logsite_test.txt");
+    std::remove(path.c_str());
+    LogTracer::ApplyConfig(file_config(path));
+    jumper::Logger& rpc = jumper::get_logger("site.rpc");
+
+    // 规则可以在调用点注册之前设置
+    auto file = std::string("logsite_test.cpp:") + std::to_string(kDebugLine);
+    EXPECT_EQ(LogSite::SetRule(file, true), 0u);
+    debug_site(1);
+    rpc_site(rpc);
+
+    jumper::LogSiteInfo info;
+    ASSERT_TRUE(find_site(kDebugLine, info));
+    EXPECT_TRUE(info.enabled);
+    EXPECT_EQ(info.level, jumper::LV_DEBUG);
+    EXPECT_EQ(info.format, "debug site {}");
+    EXPECT_EQ(info.function, "debug_site");
+    ASSERT_TRUE(find_site(kRpcLine, info));
+    EXPECT_FALSE(info.enabled);
+
+    // 关闭单个调用点，带行号的规则优先于整个文件的规则
+    EXPECT_EQ(LogSite::SetRule("tests/logsite_test.cpp", true), 2u);
+    EXPECT_EQ(LogSite::SetRule(file, false), 1u);
+    debug_site(2);
+    rpc_site(rpc);
+
+    // 删除规则后恢复按logger级别输出，logger级别改变时调用点随之改变
+    LogSite::ClearRule(file);
+    LogSite::ClearRule("tests/logsite_test.cpp");
+    debug_site(3);
+    rpc.SetLevel(jumper::LV_DEBUG);
+    rpc_site(rpc);
+    rpc.ResetLevel();
+    rpc_site(rpc);
+
+    // 只匹配完整的路径分段
+    EXPECT_EQ(LogSite::SetRule("site_test.cpp", true), 0u);
+    LogSite::ClearRule("site_test.cpp");
+
+    LogTracer::ApplyConfig(LogConfig());
+    auto content(read_file(path));
+    EXPECT_NE(content.find("[DEBUG]:debug site 1\n"), std::string::npos);
+    EXPECT_EQ(content.find("debug site 2"), std::string::npos);
+    EXPECT_EQ(content.find("debug site 3"), std::string::npos);
+    // 文件规则开启时及logger级别为DEBUG时各输出一次
+    EXPECT_EQ(count(content, "[DEBUG]:[site.rpc] rpc site\n"), 2u);
+    std::remove(path.c_str());
+}
+
+TEST(LogSiteTest, Config)
+{
+    const std::string path("./logsite_config.txt");
+    std::remove(path.c_str());
+
+    auto config(file_config(path));
+    std::string error;
+    auto text = jumper::format("site.logsite_test.cpp:{} = on\n", kDebugLine);
+    ASSERT_TRUE(config.Parse(text, error)) << error;
+    EXPECT_TRUE(config.sites.at("logsite_test.cpp:" + std::to_string(kDebugLine)));
+    EXPECT_FALSE(config.Parse("site.a.cpp = maybe\n", error));
+
+    LogTracer::ApplyConfig(config);
+    debug_site(4);
+    // 配置中去掉规则后调用点恢复关闭
+    LogTracer::ApplyConfig(file_config(path));
+    debug_site(5);
+    LogTracer::ApplyConfig(LogConfig());
+
+    auto content(read_file(path));
+    EXPECT_NE(content.find("[DEBUG]:debug site 4\n"), std::string::npos);
+    EXPECT_EQ(content.find("debug site 5"), std::string::npos);
+    std::remove(path.c_str());
+}
+
+TEST(LogSiteTest, Arguments)
+{
+    const std::string path("./logsite_arguments.txt");
+    std::remove(path.c_str());
+    LogTracer::ApplyConfig(file_config(path));
+    jumper::Logger& logger = jumper::get_logger("site.counted");
+
+    // 关闭的调用点第一次执行时注册，但不求值参数
+    logger.SetLevel(jumper::LV_WARNING);
+    counted_site(logger);
+    EXPECT_EQ(g_nextId, 0);
+
+    // 开启后每次执行只求值一次参数
+    logger.SetLevel(jumper::LV_INFO);
+    counted_site(logger);
+    counted_site(logger);
+    EXPECT_EQ(g_nextId, 2);
+    // 没有参数时直接输出去除转义的格式串
+    JLOG_AT(logger, jumper::LV_INFO, "braces {{}} {}");
+    logger.ResetLevel();
+
+    LogTracer::ApplyConfig(LogConfig());
+    auto content(read_file(path));
+    EXPECT_NE(content.find("[INFO]:[site.counted] id 1\n[INFO]:[site.counted] id 2\n"),
+        std::string::npos) << content;
+    EXPECT_NE(content.find("[INFO]:[site.counted] braces {} {}\n"), std::string::npos) << content;
+    std::remove(path.c_str());
+}
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogStats;
+using jumper::LogTracer;
+using jumper_test::read_file;
+
+namespace {
+
+inline std::uint64_t level_count(const std::uint64_t (&counts)[jumper::kLogLevelCount],
+    jumper::LogLevel lv)
+{
+    return counts[static_cast<int>(lv) - 1];
+}
+
+} // namespace
+
+TEST(LogStatsTest, Counters)
+{
+    const std::string path("./logstats_test.txt");
+    const unsigned rate = LogTracer::kStatsSampleRate;
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse("console = off\nfile.path = " + path + "\n", error)) << error;
+    LogTracer::ApplyConfig(config);
+
+    auto before = LogTracer::Stats();
+    // 新线程的抽样计数从0开始，抽样次数是确定的
+    std::thread([rate]() {
+        for (unsigned i = 0; i != 100 * rate; ++i)
+        {
+            LogTracer::LoglnInfo("record {}", i);
+            LogTracer::LoglnDebug("hidden {}", i);
+        }
+        LogTracer::LoglnError("done");
+        LogTracer::FlushTracer();
+    }).join();
+    auto after = LogTracer::Stats();
+    LogTracer::FinalTracer();
+
+    EXPECT_EQ(level_count(after.emitted, jumper::LV_INFO)
+        - level_count(before.emitted, jumper::LV_INFO), 100 * rate);
+    EXPECT_EQ(level_count(after.emitted, jumper::LV_ERROR)
+        - level_count(before.emitted, jumper::LV_ERROR), 1u);
+    EXPECT_EQ(level_count(after.filtered, jumper::LV_DEBUG)
+        - level_count(before.filtered, jumper::LV_DEBUG), 100 * rate);
+    EXPECT_EQ(level_count(after.emitted, jumper::LV_DEBUG),
+        level_count(before.emitted, jumper::LV_DEBUG));
+
+    // 被过滤的log不格式化，格式化和加锁都是每kStatsSampleRate条输出的log抽样一次
+    EXPECT_EQ(after.formatSamples - before.formatSamples, 100u);
+    EXPECT_EQ(after.lockWaitSamples - before.lockWaitSamples, 100u);
+    EXPECT_GT(after.formatNs, before.formatNs);
+
+    EXPECT_EQ(after.consoleBytes, before.consoleBytes);
+    std::size_t bytes = std::string("[ERROR]:done\n").size();
+    for (unsigned i = 0; i != 100 * rate; ++i)
+    {
+        bytes += jumper::format("[INFO]:record {}\n", i).size();
+    }
+    EXPECT_EQ(after.fileBytes - before.fileBytes, bytes);
+    auto content = read_file(path);
+    ASSERT_GE(content.size(), bytes);
+    EXPECT_EQ(content.substr(content.size() - 13), "[ERROR]:done\n");
+    EXPECT_EQ(after.flushes - before.flushes, 1u);
+
+    LogTracer::ApplyConfig(LogConfig());
+    std::remove(path.c_str());
+}
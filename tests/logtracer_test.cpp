@@ -54,6 +54,11 @@ int main()
     // log级别低于当前设置的log级别，将不再输出显示（也不会被写入文件记录！）
     LogTracer::LoglnDebug("You can NOT see me! hahaha");
 
+    // 获取运行时统计数据，可以周期性地交给监控程序
+    auto stats(LogTracer::Stats());
+    LogTracer::LoglnInfo("emitted info: {}, filtered debug: {}, console bytes: {}",
+        stats.emitted[1], stats.filtered[0], stats.consoleBytes);
+
     // 立即关闭log文件，之后的log将不会写入文件，但仍然会在终端输出。
     // 可选，默认在程序结束时自动关闭
     LogTracer::FinalTracer();
@@ -0,0 +1,226 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "lzcodec.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper::LzStatus;
+using jumper_test::read_file;
+
+namespace {
+
+void write_file(const std::string& path, const std::string& data)
+{
+    std::ofstream ofs(path, std::ios_base::binary | std::ios_base::trunc);
+    ofs << data;
+}
+
+// 压缩后解压，返回压缩后的字节数
+std::size_t round_trip(const std::string& data)
+{
+    std::vector<char> packed(jumper::lz_bound(data.size()));
+    auto n = jumper::lz_compress(data.data(), data.size(), packed.data());
+    EXPECT_LE(n, packed.size());
+
+    std::string raw(data.size(), '\0');
+    EXPECT_TRUE(jumper::lz_decompress(packed.data(), n, &raw[0], raw.size()));
+    EXPECT_EQ(raw, data);
+
+    return n;
+}
+
+// 依次解码所有数据块
+std::string decode_all(const std::string& file)
+{
+    std::string out;
+    std::size_t pos = 0;
+
+    while (pos < file.size())
+    {
+        std::size_t consumed = 0;
+        auto status = jumper::lz_decode_block(file.data() + pos, file.size() - pos, out, consumed);
+        EXPECT_EQ(status, LzStatus::LZ_OK) << "offset " << pos;
+        if (LzStatus::LZ_OK != status)
+        {
+            break;
+        }
+        pos += consumed;
+    }
+
+    return out;
+}
+
+// 运行jlog_cat，返回标准输出，status为退出码
+std::string run_cat(const std::string& path, int& status)
+{
+    std::string out;
+    FILE* fp = ::popen((std::string(JLOG_CAT_PATH) + " " + path + " 2>/dev/null").c_str(), "r");
+    char buf[4096];
+    std::size_t n;
+
+    while ((n = std::fread(buf, 1, sizeof(buf), fp)) > 0)
+    {
+        out.append(buf, n);
+    }
+    status = WEXITSTATUS(::pclose(fp));
+
+    return out;
+}
+
+// 第index条log的内容，与真实的log一样有大量重复
+std::string line(int index)
+{
+    return jumper::format("request {} from 10.0.{}.{} handled in {} us, status=OK\n",
+        index, index % 7, index % 250, 100 + index % 900);
+}
+
+} // namespace
+
+TEST(LzCodecTest, RoundTrip)
+{
+    std::mt19937 rng(42);
+    std::string random(50000, '\0');
+    for (auto& c: random)
+    {
+        c = static_cast<char>(rng());
+    }
+    std::string text;
+    for (int i = 0; text.size() < jumper::kLzMaxBlockSize; ++i)
+    {
+        text += line(i);
+    }
+    text.resize(jumper::kLzMaxBlockSize);
+
+    EXPECT_EQ(round_trip(""), 1u);
+    round_trip("a");
+    round_trip("abcd");
+    round_trip("abcabcabcabcabcabcabc");
+    // 匹配与输出重叠，以及超过15的长度
+    EXPECT_LT(round_trip(std::string(10000, 'x')), 100u);
+    EXPECT_LT(round_trip(text), text.size() / 3);
+    // 不可压缩的内容最多增加lz_bound的开销
+    EXPECT_LE(round_trip(random), jumper::lz_bound(random.size()));
+    round_trip(random.substr(0, 300) + text.substr(0, 3000) + random.substr(0, 300));
+}
+
+TEST(LzCodecTest, Block)
+{
+    std::string text;
+    for (int i = 0; i != 500; ++i)
+    {
+        text += line(i);
+    }
+
+    std::string file;
+    jumper::lz_encode_block(text.data(), text.size(), file);
+    auto first = file.size();
+    // 无法压缩时原样保存
+    jumper::lz_encode_block("hello\n", 6, file);
+    EXPECT_EQ(file.size() - first, sizeof(jumper::LzBlockHeader) + 6);
+    EXPECT_EQ(decode_all(file), text + "hello\n");
+
+    // 不完整的数据块
+    std::string out;
+    std::size_t consumed = 0;
+    EXPECT_EQ(jumper::lz_decode_block(file.data(), 10, out, consumed), LzStatus::LZ_INCOMPLETE);
+    EXPECT_EQ(jumper::lz_decode_block(file.data(), first - 1, out, consumed),
+        LzStatus::LZ_INCOMPLETE);
+    EXPECT_TRUE(out.empty());
+
+    // 损坏的数据块被发现，不会越界
+    for (std::size_t i = 0; i < first; i += 7)
+    {
+        auto bad = file;
+        bad[i] = static_cast<char>(bad[i] ^ 0x5A);
+        auto status = jumper::lz_decode_block(bad.data(), first, out, consumed);
+        if (i >= 4 && i < 12)
+        {
+            // 修改长度可能表现为不完整
+            EXPECT_NE(status, LzStatus::LZ_OK) << i;
+        }
+        else
+        {
+            EXPECT_EQ(status, LzStatus::LZ_CORRUPT) << i;
+        }
+        EXPECT_TRUE(out.empty());
+    }
+
+    // 随机的输入不会越界读写
+    std::mt19937 rng(7);
+    std::string raw(4096, '\0');
+    for (int i = 0; i != 2000; ++i)
+    {
+        std::string junk(rng() % 200, '\0');
+        for (auto& c: junk)
+        {
+            c = static_cast<char>(rng() % 4 ? rng() % 16 : rng());
+        }
+        jumper::lz_decompress(junk.data(), junk.size(), &raw[0], rng() % raw.size());
+    }
+}
+
+TEST(LzCodecTest, LogTracer)
+{
+    const std::string path("./lzcodec_test.jlz");
+    const int count = 50000;
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse(jumper::format("file.mode = compressed\nconsole = off\n"
+        "file.path = {}\nlayout = %T [%l] %t %m\n", path), error)) << error;
+    LogTracer::ApplyConfig(config);
+
+    for (int i = 0; i != count; ++i)
+    {
+        LogTracer::LogInfo("{}", line(i));
+    }
+    // 持久化请求等待未满的数据块写入文件
+    EXPECT_TRUE(LogTracer::FlushDurable().wait());
+    auto content = decode_all(read_file(path));
+    EXPECT_NE(content.find(line(count - 1)), std::string::npos);
+    LogTracer::LoglnWarning("last");
+    LogTracer::FinalTracer();
+
+    // 所有记录完整且有序
+    auto file = read_file(path);
+    content = decode_all(file);
+    EXPECT_EQ(content.find("--------------------\n"), 0u);
+    std::size_t pos = 0;
+    for (int i = 0; i != count && std::string::npos != pos; ++i)
+    {
+        pos = content.find(" [INFO] ", pos);
+        pos = content.find(line(i), pos);
+        ASSERT_NE(pos, std::string::npos) << i;
+    }
+    EXPECT_NE(content.find(" [WARNING] ", pos), std::string::npos);
+    EXPECT_EQ(content.substr(content.size() - 6), " last\n");
+    EXPECT_GE(content.size(), 5 * file.size()) << "ratio " << 1.0 * content.size() / file.size();
+
+    int status = -1;
+    EXPECT_EQ(run_cat(path, status), content);
+    EXPECT_EQ(status, 0);
+
+    // 损坏中间的一个数据块后，jlog_cat跳过它并继续解码之后的数据块
+    std::size_t consumed = 0;
+    std::string out;
+    ASSERT_EQ(jumper::lz_decode_block(file.data(), file.size(), out, consumed), LzStatus::LZ_OK);
+    file[consumed + 100] = static_cast<char>(file[consumed + 100] ^ 0x5A);
+    write_file(path, file);
+    auto partial = run_cat(path, status);
+    EXPECT_EQ(status, 1);
+    EXPECT_EQ(partial.compare(0, out.size(), out), 0);
+    EXPECT_LT(partial.size(), content.size());
+    EXPECT_EQ(partial.substr(partial.size() - 6), " last\n");
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,127 @@
+#include <cstdio>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "format.h"
+#include "logtracer.h"
+#include "test_util.h"
+
+using jumper::FmtBuffer;
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper_test::read_file;
+
+namespace {
+
+// 逐字节实现的参考版本，与sanitize的结果比较
+std::string sanitize_bytewise(const std::string& str)
+{
+    std::string out;
+    auto bytes = reinterpret_cast<const unsigned char*>(str.data());
+
+    for (std::size_t i = 0; i < str.size();)
+    {
+        if (jumper::jumper_inner::is_plain(bytes[i]))
+        {
+            out.push_back(str[i++]);
+            continue;
+        }
+
+        auto n = jumper::jumper_inner::utf8_length(bytes + i, str.size() - i);
+        if (0 != n)
+        {
+            out.append(str, i, n);
+            i += n;
+            continue;
+        }
+        jumper::jumper_inner::write_escape(out, bytes[i++]);
+    }
+
+    return out;
+}
+
+} // namespace
+
+TEST(SanitizeTest, Escape)
+{
+    EXPECT_EQ(jumper::sanitize("plain text"), "plain text");
+    EXPECT_EQ(jumper::sanitize("a\nb\rc\td"), "a\\nb\\rc\\td");
+    // 终端控制序列和DEL
+    EXPECT_EQ(jumper::sanitize("\e[1;31mred\x7f"), "\\x1b[1;31mred\\x7f");
+    EXPECT_EQ(jumper::sanitize(std::string("nul\0end", 7)), "nul\\x00end");
+    // 反斜杠不转义
+    EXPECT_EQ(jumper::sanitize("C:\\path"), "C:\\path");
+}
+
+TEST(SanitizeTest, Utf8)
+{
+    // 合法的2/3/4字节字符原样保留
+    EXPECT_EQ(jumper::sanitize("caf\xc3\xa9 \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80"),
+        "caf\xc3\xa9 \xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80");
+    // 孤立的后续字节、截断的字符
+    EXPECT_EQ(jumper::sanitize("\x80x\xe4\xb8"), "\\x80x\\xe4\\xb8");
+    // 超长编码、代理区、超出U+10FFFF
+    EXPECT_EQ(jumper::sanitize("\xc0\xaf"), "\\xc0\\xaf");
+    EXPECT_EQ(jumper::sanitize("\xe0\x80\xaf"), "\\xe0\\x80\\xaf");
+    EXPECT_EQ(jumper::sanitize("\xed\xa0\x80"), "\\xed\\xa0\\x80");
+    EXPECT_EQ(jumper::sanitize("\xf4\x90\x80\x80"), "\\xf4\\x90\\x80\\x80");
+    // C1控制字符U+009B（CSI）
+    EXPECT_EQ(jumper::sanitize("\xc2\x9b"), "\\xc2\\x9b");
+    EXPECT_EQ(jumper::sanitize("\xc2\xa0"), "\xc2\xa0");
+}
+
+TEST(SanitizeTest, Blocks)
+{
+    // 在每个位置放置需要转义的字节或者多字节字符，覆盖SIMD块的边界
+    const char* specials[] = { "\n", "\e", "\xff", "\xc3\xa9", "\xe4\xb8\xad", "\xe4\xb8" };
+    std::string clean(100, 'x');
+
+    for (std::size_t pos = 0; pos <= clean.size(); ++pos)
+    {
+        for (auto special: specials)
+        {
+            auto str(clean);
+            str.insert(pos, special);
+            ASSERT_EQ(jumper::sanitize(str), sanitize_bytewise(str)) << "pos " << pos;
+        }
+    }
+}
+
+TEST(SanitizeTest, Format)
+{
+    std::string user("bob\n[ERROR]:forged");
+
+    // 只清理参数，格式串中的换行保留
+    EXPECT_EQ(jumper::format_sanitized("user={}\n", user), "user=bob\\n[ERROR]:forged\n");
+    EXPECT_EQ(jumper::format_sanitized("{} {} {}", "\e[2J", '\r', 42), "\\x1b[2J \\r 42");
+    // 单个字符不可能是UTF-8多字节字符，0x80以上的字节也被转义
+    EXPECT_EQ(jumper::format_sanitized("{}{}{}", 'a', '\xe9', static_cast<unsigned char>(0x7F)),
+        "a\\xe9\\x7f");
+    EXPECT_EQ(jumper::format("user={}", user), "user=" + user);
+
+    FmtBuffer buf;
+    buf.set_sanitize(true);
+    ASSERT_TRUE(jumper::format_to(buf, jumper::FmtView("{}|{}"), std::string("a\tb"), "c"));
+    EXPECT_EQ(buf.str(), "a\\tb|c");
+}
+
+TEST(SanitizeTest, LogTracer)
+{
+    const std::string path("./sanitize_test.txt");
+    std::remove(path.c_str());
+
+    LogConfig config;
+    std::string error;
+    ASSERT_TRUE(config.Parse("sanitize = on\nconsole = off\n", error)) << error;
+    EXPECT_TRUE(config.sanitize);
+    config.filePath = path;
+    LogTracer::ApplyConfig(config);
+
+    LogTracer::LoglnInfo("login user={}", "eve\n[ERROR]:root login");
+    LogTracer::ApplyConfig(LogConfig());
+
+    auto content(read_file(path));
+    EXPECT_NE(content.find("[INFO]:login user=eve\\n[ERROR]:root login\n"), std::string::npos);
+    EXPECT_EQ(content.find("\n[ERROR]:"), std::string::npos);
+    std::remove(path.c_str());
+}
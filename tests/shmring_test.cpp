@@ -0,0 +1,245 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "logtracer.h"
+#include "shmring.h"
+#include "test_util.h"
+
+using jumper::LogConfig;
+using jumper::LogTracer;
+using jumper::ShmRingReader;
+using jumper::ShmRingWriter;
+using jumper_test::read_file;
+
+namespace {
+
+// 写入一条记录，返回是否写入
+bool push(ShmRingWriter& ring, const std::string& str)
+{
+    char* p = ring.reserve(str.size(), 2);
+    if (!p)
+    {
+        return false;
+    }
+    str.copy(p, str.size());
+    ring.commit();
+
+    return true;
+}
+
+// 第index条记录的内容，长度变化范围覆盖数据区末尾的填充
+std::string record(int index)
+{
+    return jumper::format("r{}:{}\n", index,
+        std::string(static_cast<std::size_t>(index * 37 % 300), 'x'));
+}
+
+// 子进程：通过LogTracer写入count条记录后直接退出，不关闭LogTracer（模拟进程崩溃）
+void run_producer(const std::string& name, int count)
+{
+    LogConfig config;
+    std::string error;
+    if (!config.Parse(jumper::format("file.mode = shm\nfile.ring_size = 65536\n"
+        "console = off\nfile.path = {}\n", name), error))
+    {
+        ::_exit(1);
+    }
+    LogTracer::ApplyConfig(config);
+    for (int i = 0; i != count; ++i)
+    {
+        LogTracer::LoglnInfo("n{} {}", i, std::string(static_cast<std::size_t>(i % 200), 'y'));
+        // 让读取端跟上，不丢弃记录
+        if (0 == i % 64)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    ::_exit(0);
+}
+
+} // namespace
+
+TEST(ShmRingTest, Ring)
+{
+    const std::string name("/jlog.shmring_test");
+    ShmRingWriter writer(name, 4096);
+    ASSERT_TRUE(writer.is_open());
+    EXPECT_EQ(writer.max_record(), 1024u);
+
+    ShmRingReader reader;
+    ASSERT_TRUE(reader.open(name));
+    EXPECT_EQ(reader.producer(), ::getpid());
+    EXPECT_TRUE(reader.producer_alive());
+    EXPECT_FALSE(reader.replaced());
+
+    // 反复绕过数据区末尾
+    std::string expected;
+    std::string out;
+    for (int i = 0; i != 500; ++i)
+    {
+        ASSERT_TRUE(push(writer, record(i))) << i;
+        expected += record(i);
+        if (0 == i % 5)
+        {
+            reader.read(out, 1 << 20);
+        }
+    }
+    EXPECT_EQ(reader.read(out, 1 << 20), 4u);
+    EXPECT_EQ(out, expected);
+    EXPECT_TRUE(reader.empty());
+
+    // 没有读取时写满后丢弃并计数
+    int written = 0;
+    while (push(writer, std::string(100, 'z')))
+    {
+        ++written;
+    }
+    EXPECT_EQ(reader.dropped(), 1u);
+    EXPECT_GT(written, 30);
+    // 超过max_record()的记录同样丢弃
+    EXPECT_FALSE(push(writer, std::string(1025, 'z')));
+    EXPECT_EQ(reader.dropped(), 2u);
+
+    out.clear();
+    EXPECT_EQ(reader.read(out, 1 << 20), static_cast<std::size_t>(written));
+    EXPECT_TRUE(push(writer, "after\n"));
+
+    // 同名的缓冲区重新创建后，旧的读取端可以识别，删除时不影响新的缓冲区
+    ShmRingWriter next(name, 4096);
+    EXPECT_TRUE(reader.replaced());
+    reader.unlink();
+    ShmRingReader again;
+    EXPECT_TRUE(again.open(name));
+    again.unlink();
+    EXPECT_FALSE(ShmRingReader().open(name));
+}
+
+TEST(ShmRingTest, Process)
+{
+    const std::string name("/jlog.shmring_process");
+    const int count = 5000;
+    ::shm_unlink(name.c_str());
+
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (0 == pid)
+    {
+        run_producer(name, count);
+    }
+
+    // 另一个进程作为读取端，与写入端同时运行
+    ShmRingReader reader;
+    std::string out;
+    bool exited = false;
+    int status = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        if (!reader.is_open() && !reader.open(name))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (0 != reader.read(out, 1 << 20))
+        {
+            continue;
+        }
+        // 回收子进程后它才不再存在
+        exited = exited || pid == ::waitpid(pid, &status, WNOHANG);
+        if (!reader.producer_alive() && reader.empty())
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    ASSERT_TRUE(exited);
+    EXPECT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+    EXPECT_EQ(reader.producer(), pid);
+    reader.unlink();
+
+    // 记录完整且有序，丢弃的记录被计数
+    std::size_t pos = out.find("[INFO]:n0 ");
+    int received = 0;
+    for (int i = 0; i != count && std::string::npos != pos; ++i)
+    {
+        auto line = jumper::format("[INFO]:n{} {}\n", i,
+            std::string(static_cast<std::size_t>(i % 200), 'y'));
+        if (0 == out.compare(pos, line.size(), line))
+        {
+            pos += line.size();
+            ++received;
+        }
+    }
+    EXPECT_EQ(received + reader.dropped(), static_cast<std::uint64_t>(count));
+    EXPECT_EQ(pos, out.size());
+}
+
+TEST(ShmRingTest, Daemon)
+{
+    const std::string name("jlog.shmring_daemon");
+    const std::string path("./" + name + ".log");
+    const int count = 2000;
+    ::shm_unlink(("/" + name).c_str());
+    for (auto suffix: { "", ".1", ".2", ".3" })
+    {
+        std::remove((path + suffix).c_str());
+    }
+
+    // jlogd与写入端是两个独立的进程
+    pid_t daemon = ::fork();
+    ASSERT_GE(daemon, 0);
+    if (0 == daemon)
+    {
+        ::execl(JLOGD_PATH, "jlogd", "--dir", ".", "--max-size", "65536", "--max-files", "2",
+            "--interval", "1", name.c_str(), static_cast<char*>(nullptr));
+        ::_exit(127);
+    }
+    pid_t producer = ::fork();
+    ASSERT_GE(producer, 0);
+    if (0 == producer)
+    {
+        run_producer(name, count);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(producer, &status, 0), producer);
+    EXPECT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+
+    // jlogd发现写入端退出后写入标记
+    auto exited = jumper::format("[jlogd]: producer {} exited\n", producer);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (std::string::npos == read_file(path).find(exited)
+        && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ::kill(daemon, SIGTERM);
+    ASSERT_EQ(::waitpid(daemon, &status, 0), daemon);
+    EXPECT_TRUE(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+
+    // 轮转后只保留2个旧文件，最后的记录都在
+    auto content = read_file(path + ".2") + read_file(path + ".1") + read_file(path);
+    EXPECT_FALSE(std::ifstream(path + ".3").is_open());
+    EXPECT_LE(read_file(path + ".1").size(), 65536u);
+    EXPECT_NE(content.find(exited), std::string::npos);
+    EXPECT_NE(content.find(jumper::format("[INFO]:n{} ", count - 1)), std::string::npos);
+    EXPECT_EQ(content.find("records dropped"), std::string::npos);
+    // 共享内存已被删除
+    EXPECT_FALSE(ShmRingReader().open(name));
+
+    for (auto suffix: { "", ".1", ".2" })
+    {
+        std::remove((path + suffix).c_str());
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "logtracer.h"
+
+// 各测试共用的辅助函数
+namespace jumper_test {
+
+// 读取整个文件的内容，文件不存在时返回空串
+inline std::string read_file(const std::string& path)
+{
+    std::ifstream ifs(path, std::ios_base::binary);
+
+    return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+}
+
+// 只写文件，不输出到终端
+inline jumper::LogConfig file_config(const std::string& path)
+{
+    jumper::LogConfig config;
+
+    config.filePath = path;
+    config.console = false;
+
+    return config;
+}
+
+// str在content中出现的次数
+inline std::size_t count(const std::string& content, const std::string& str)
+{
+    std::size_t n = 0;
+
+    for (auto pos = content.find(str); std::string::npos != pos; pos = content.find(str, pos + 1))
+    {
+        ++n;
+    }
+
+    return n;
+}
+
+} // namespace jumper_test
+
+#endif // TEST_UTIL_H
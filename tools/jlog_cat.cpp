@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "lzcodec.h"
+
+namespace {
+
+// 每次读取的字节数
+const std::size_t kReadSize = 1 << 20;
+
+// 从pos开始查找下一个数据块头部的魔数，没有找到时跳过已读的内容，保留可能是魔数开头的几个字节
+std::size_t resync(const std::string& buf, std::size_t pos, bool eof)
+{
+    auto next = buf.find(std::string(jumper::kLzBlockMagic, sizeof(jumper::kLzBlockMagic)), pos);
+
+    if (std::string::npos != next)
+    {
+        return next;
+    }
+
+    return eof ? buf.size()
+        : std::max(pos, buf.size() - std::min(buf.size(), sizeof(jumper::kLzBlockMagic) - 1));
+}
+
+// 解压一个文件到标准输出，有损坏或不完整的数据块时返回false
+bool cat(int fd, const char* name)
+{
+    std::string buf;
+    std::string out;
+    std::size_t pos = 0;
+    // 已经从buf中移除的字节数，用于报告文件中的偏移量
+    std::uint64_t base = 0;
+    bool ok = true;
+    bool eof = false;
+    // 正在跳过损坏的内容，找到完好的数据块之前不再报告
+    bool skipping = false;
+
+    while (!eof || pos < buf.size())
+    {
+        if (!eof)
+        {
+            // 移除已经解码的内容后读取更多
+            buf.erase(0, pos);
+            base += pos;
+            pos = 0;
+
+            auto size = buf.size();
+            buf.resize(size + kReadSize);
+            auto n = ::read(fd, &buf[size], kReadSize);
+            buf.resize(size + static_cast<std::size_t>(std::max<ssize_t>(n, 0)));
+            if (n < 0 && EINTR == errno)
+            {
+                continue;
+            }
+            eof = (n <= 0);
+        }
+
+        out.clear();
+        while (pos < buf.size())
+        {
+            std::size_t consumed = 0;
+            auto status = jumper::lz_decode_block(buf.data() + pos, buf.size() - pos, out,
+                consumed);
+
+            if (jumper::LzStatus::LZ_OK == status)
+            {
+                pos += consumed;
+                skipping = false;
+                continue;
+            }
+            if (jumper::LzStatus::LZ_INCOMPLETE == status && !eof)
+            {
+                break;
+            }
+
+            // 损坏或者文件末尾不完整的数据块，从下一个魔数处继续
+            if (!skipping)
+            {
+                std::fprintf(stderr, "jlog_cat: %s: %s block at offset %llu\n", name,
+                    (jumper::LzStatus::LZ_CORRUPT == status) ? "corrupt" : "truncated",
+                    static_cast<unsigned long long>(base + pos));
+            }
+            ok = false;
+            skipping = true;
+            pos = resync(buf, pos + 1, eof);
+            if (!eof && buf.size() - pos < sizeof(jumper::LzBlockHeader))
+            {
+                break;
+            }
+        }
+
+        if (!out.empty() && !jumper::jumper_inner::write_fd(STDOUT_FILENO, out.data(), out.size()))
+        {
+            return false;
+        }
+    }
+
+    return ok;
+}
+
+} // namespace
+
+/// 用法：jlog_cat [FILE...]
+/// 解压file.mode = compressed写入的log文件到标准输出，没有参数或者参数为"-"时读取标准输入
+/// 损坏的数据块被跳过并在标准错误输出报告，从下一个完好的数据块继续，此时返回1
+int main(int argc, char *argv[])
+{
+    int status = 0;
+
+    if (argc < 2)
+    {
+        return cat(STDIN_FILENO, "-") ? 0 : 1;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (0 == std::strcmp(argv[i], "-"))
+        {
+            status |= cat(STDIN_FILENO, "-") ? 0 : 1;
+            continue;
+        }
+
+        int fd = ::open(argv[i], O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            std::fprintf(stderr, "jlog_cat: can't open %s: %s\n", argv[i], std::strerror(errno));
+            status = 1;
+            continue;
+        }
+        status |= cat(fd, argv[i]) ? 0 : 1;
+        ::close(fd);
+    }
+
+    return status;
+}
@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logindex.h"
+#include "logtracer.h"
+
+namespace {
+
+// 只读映射整个文件，文件为空或打开失败时data为nullptr
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        struct stat st;
+        if (0 == ::fstat(fd, &st) && st.st_size > 0)
+        {
+            void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED != p)
+            {
+                m_data = static_cast<const char*>(p);
+                m_size = static_cast<std::size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (m_data)
+        {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// 所有log级别
+const std::uint32_t kAllLevels = (1u << jumper::kLogLevelCount) - 1;
+
+// 查询条件
+struct Query {
+    std::int64_t fromMs = INT64_MIN;
+    std::int64_t toMs = INT64_MAX;
+    // 需要的log级别，第(level - 1)位表示该级别
+    std::uint32_t levelMask = kAllLevels;
+};
+
+// 向前查找所在记录头部的最大字节数，超过时按索引的级别判断
+const std::size_t kMaxLookBack = 1 << 20;
+
+// log文件中的一段[first, last)，levelMask为索引中这一段包含的log级别，
+// begin为这一段所在的连续索引段的起始位置，之前的内容不属于查询范围
+struct Range {
+    std::size_t first;
+    std::size_t last;
+    std::uint32_t levelMask;
+    std::size_t begin;
+};
+
+// 解析时间：本地时间"YYYY-mm-dd HH:MM:SS"或者毫秒时间戳
+bool parse_time(const char* str, std::int64_t& ms)
+{
+    std::tm tm {};
+    const char* end = ::strptime(str, "%Y-%m-%d %H:%M:%S", &tm);
+
+    if (end && '\0' == *end)
+    {
+        tm.tm_isdst = -1;
+        ms = static_cast<std::int64_t>(std::mktime(&tm)) * 1000;
+        return true;
+    }
+
+    char* numEnd = nullptr;
+    ms = std::strtoll(str, &numEnd, 10);
+
+    return numEnd != str && '\0' == *numEnd;
+}
+
+// 解析log级别："WARNING,ERROR"表示这两个级别，"INFO+"表示INFO及以上的级别
+bool parse_levels(const std::string& str, std::uint32_t& mask)
+{
+    mask = 0;
+    std::size_t begin = 0;
+
+    while (begin <= str.size())
+    {
+        auto end = std::min(str.find(',', begin), str.size());
+        std::string name(str, begin, end - begin);
+        bool above = !name.empty() && '+' == name.back();
+        bool found = false;
+
+        if (above)
+        {
+            name.pop_back();
+        }
+        for (const auto& kv: jumper::jumper_inner::logHeaderMap)
+        {
+            if ("[" + name + "]:" == kv.second.second)
+            {
+                int lv = static_cast<int>(kv.first);
+                mask |= above ? ((1u << jumper::kLogLevelCount) - 1) & ~((1u << (lv - 1)) - 1)
+                    : 1u << (lv - 1);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+        begin = end + 1;
+    }
+
+    return 0 != mask;
+}
+
+// 根据索引选出可能包含匹配记录的段，相邻的段合并
+std::vector<Range> select_ranges(const MappedFile& index, std::size_t logSize,
+    const Query& query)
+{
+    std::vector<Range> ranges;
+    auto count = (index.size() - sizeof(jumper::kLogIndexMagic)) / sizeof(jumper::LogIndexEntry);
+
+    for (std::size_t i = 0; i != count; ++i)
+    {
+        jumper::LogIndexEntry entry;
+        std::memcpy(&entry, index.data() + sizeof(jumper::kLogIndexMagic) + i * sizeof(entry),
+            sizeof(entry));
+
+        if (entry.endMs < query.fromMs || entry.beginMs > query.toMs
+            || 0 == (entry.levelMask & query.levelMask) || entry.offset >= logSize)
+        {
+            continue;
+        }
+
+        auto last = static_cast<std::size_t>(
+            std::min<std::uint64_t>(entry.offset + entry.length, logSize));
+        auto first = static_cast<std::size_t>(entry.offset);
+        // 相邻且级别相同的段合并，级别不同时保留各自的级别，供没有默认头部的记录使用
+        if (!ranges.empty() && ranges.back().last == first
+            && ranges.back().levelMask == entry.levelMask)
+        {
+            ranges.back().last = last;
+        }
+        else
+        {
+            auto begin = (!ranges.empty() && ranges.back().last == first)
+                ? ranges.back().begin : first;
+            ranges.push_back({ first, last, entry.levelMask, begin });
+        }
+    }
+
+    return ranges;
+}
+
+// 把过长的段按行切分，使每个线程的工作量大致相同，且每段不会太大，完成的段可以尽早输出
+std::vector<Range> split_ranges(const std::vector<Range>& ranges, const char* data,
+    unsigned threads)
+{
+    std::size_t total = 0;
+    for (const auto& r: ranges)
+    {
+        total += r.last - r.first;
+    }
+
+    // 每段64KB到4MB，段太小时并行得不偿失
+    auto chunk = std::min<std::size_t>(4 << 20,
+        std::max<std::size_t>(64 * 1024, total / threads + 1));
+    std::vector<Range> chunks;
+
+    for (const auto& r: ranges)
+    {
+        auto first = r.first;
+        while (r.last - first > chunk)
+        {
+            auto nl = static_cast<const char*>(std::memchr(data + first + chunk, '\n',
+                r.last - first - chunk));
+            if (!nl)
+            {
+                break;
+            }
+            auto last = static_cast<std::size_t>(nl - data) + 1;
+            chunks.push_back({ first, last, r.levelMask, r.begin });
+            first = last;
+        }
+        chunks.push_back({ first, r.last, r.levelMask, r.begin });
+    }
+
+    return chunks;
+}
+
+// 以默认头部"[LEVEL]:"开头的行返回该级别对应的位，其它行（多行记录的后续行，或者使用了布局）返回0
+std::uint32_t line_level(const char* line, std::size_t len)
+{
+    for (const auto& kv: jumper::jumper_inner::logHeaderMap)
+    {
+        const auto& header = kv.second.second;
+        if (len >= header.size() && 0 == std::memcmp(line, header.data(), header.size()))
+        {
+            return 1u << (static_cast<int>(kv.first) - 1);
+        }
+    }
+
+    return 0;
+}
+
+// 从行首pos向前查找最近的以默认头部开头的行，返回其级别
+// 到达begin或者向前超过kMaxLookBack仍没有找到时返回0
+std::uint32_t previous_level(const char* data, std::size_t begin, std::size_t pos)
+{
+    auto limit = std::max(begin, pos > kMaxLookBack ? pos - kMaxLookBack : 0);
+
+    while (pos > limit)
+    {
+        // 上一行为[start, pos)，data[pos - 1]是它的换行符
+        auto lineEnd = pos;
+        auto start = pos - 1;
+        while (start > limit && '\n' != data[start - 1])
+        {
+            --start;
+        }
+        // 超过查找范围的行不完整，无法判断
+        if (start == limit && limit != begin)
+        {
+            break;
+        }
+        if (auto level = line_level(data + start, lineEnd - start))
+        {
+            return level;
+        }
+        pos = start;
+    }
+
+    return 0;
+}
+
+// 扫描一段，把匹配的行追加到out中
+// 以默认头部开头的行按头部中的级别过滤，之后没有头部的行（多行记录的后续行）跟随所在的记录；
+// 段中找不到默认头部时（使用了布局），按索引中这一段的级别过滤，没有索引时不输出
+void scan_range(const char* data, const Range& range, std::uint32_t levelMask,
+    std::string& out)
+{
+    auto p = data + range.first;
+    auto end = data + range.last;
+
+    if (kAllLevels == levelMask)
+    {
+        out.append(p, end);
+        return;
+    }
+
+    auto level = previous_level(data, range.begin, range.first);
+    bool keep = level ? 0 != (level & levelMask) : 0 != (range.levelMask & levelMask);
+    while (p < end)
+    {
+        auto nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        auto lineEnd = nl ? nl + 1 : end;
+
+        if (auto lineLevel = line_level(p, lineEnd - p))
+        {
+            keep = 0 != (lineLevel & levelMask);
+        }
+        if (keep)
+        {
+            out.append(p, lineEnd);
+        }
+        p = lineEnd;
+    }
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+        "usage: jlog_query <log file> [--from TIME] [--to TIME] [--level LEVELS] [--threads N]\n"
+        "  TIME    local time \"YYYY-mm-dd HH:MM:SS\" or milliseconds since epoch\n"
+        "  LEVELS  e.g. \"WARNING,ERROR\" or \"INFO+\"\n");
+}
+
+} // namespace
+
+/// 用法：jlog_query <log file> [--from TIME] [--to TIME] [--level LEVELS] [--threads N]
+/// 使用LogTracer生成的索引文件（log文件路径加".idx"）按时间范围和log级别查询log
+/// 只扫描索引中时间和级别可能匹配的段，多个段由多个线程并行扫描，结果按文件顺序输出
+/// 时间的精度为索引项（每项SetIndexInterval条log），没有索引文件时扫描整个文件，忽略时间条件
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        usage();
+        return 2;
+    }
+
+    std::string logPath(argv[1]);
+    Query query;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 2; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+        bool ok = hasValue;
+
+        if (0 == std::strcmp(argv[i], "--from") && hasValue)
+        {
+            ok = parse_time(argv[++i], query.fromMs);
+        }
+        else if (0 == std::strcmp(argv[i], "--to") && hasValue)
+        {
+            ok = parse_time(argv[++i], query.toMs);
+        }
+        else if (0 == std::strcmp(argv[i], "--level") && hasValue)
+        {
+            ok = parse_levels(argv[++i], query.levelMask);
+        }
+        else if (0 == std::strcmp(argv[i], "--threads") && hasValue)
+        {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    MappedFile log(logPath);
+    if (!log.data())
+    {
+        return 0;
+    }
+
+    MappedFile index(jumper::log_index_path(logPath));
+    std::vector<Range> ranges;
+
+    if (index.size() >= sizeof(jumper::kLogIndexMagic)
+        && 0 == std::memcmp(index.data(), jumper::kLogIndexMagic, sizeof(jumper::kLogIndexMagic)))
+    {
+        ranges = select_ranges(index, log.size(), query);
+    }
+    else
+    {
+        if (INT64_MIN != query.fromMs || INT64_MAX != query.toMs)
+        {
+            std::fprintf(stderr, "[jlog_query]: no index for %s, time range ignored\n",
+                logPath.c_str());
+        }
+        // 没有索引时级别未知，只能按默认头部过滤，第一个头部之前的内容（文件开头的分隔行）不输出
+        ranges.push_back({ 0, log.size(), 0, 0 });
+    }
+
+    // 各线程依次领取段，当前线程按段的顺序输出完成的段
+    // 领取的段最多领先输出window段，输出较慢时限制缓存的结果
+    auto chunks = split_ranges(ranges, log.data(), threads);
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunks.size()));
+    const std::size_t window = 2 * static_cast<std::size_t>(threads);
+    std::vector<std::string> outputs(chunks.size());
+    std::vector<char> done(chunks.size(), 0);
+    std::size_t claimed = 0;
+    std::size_t written = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+    auto worker = [&]() {
+        for (;;)
+        {
+            std::size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() {
+                    return claimed == chunks.size() || claimed < written + window;
+                });
+                if (claimed == chunks.size())
+                {
+                    return;
+                }
+                i = claimed++;
+            }
+
+            scan_range(log.data(), chunks[i], query.levelMask, outputs[i]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = 1;
+            }
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+
+    for (unsigned i = 0; i != threads; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::size_t i = 0; i != chunks.size(); ++i)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return 0 != done[i]; });
+        }
+
+        std::fwrite(outputs[i].data(), 1, outputs[i].size(), stdout);
+        std::string().swap(outputs[i]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written = i + 1;
+        }
+        cv.notify_all();
+    }
+    for (auto& w: workers)
+    {
+        w.join();
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "shmring.h"
+
+namespace {
+
+// 收到SIGTERM/SIGINT后读完所有缓冲区再退出
+std::atomic<bool> s_stop { false };
+
+void on_stop(int)
+{
+    s_stop.store(true, std::memory_order_relaxed);
+}
+
+// 按大小轮转的log文件：超过maxSize时path依次改名为path.1、path.2...，最多保留maxFiles个
+class RotatingFile {
+public:
+    RotatingFile(const std::string& path, std::uint64_t maxSize, unsigned maxFiles)
+        : m_path(path), m_maxSize(maxSize), m_maxFiles(maxFiles)
+    {
+        open();
+    }
+
+    ~RotatingFile()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+    }
+
+    RotatingFile(const RotatingFile&) = delete;
+    RotatingFile& operator=(const RotatingFile&) = delete;
+
+    bool write(const std::string& data)
+    {
+        if (0 != m_maxSize && 0 != m_size && m_size + data.size() > m_maxSize)
+        {
+            rotate();
+        }
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        m_size += data.size();
+
+        return jumper::jumper_inner::write_fd(m_fd, data.data(), data.size());
+    }
+
+private:
+    void open()
+    {
+        m_fd = ::open(m_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (m_fd < 0)
+        {
+            std::fprintf(stderr, "[jlogd]: can't open log file:%s\n", m_path.c_str());
+            return;
+        }
+
+        struct stat st;
+        m_size = (0 == ::fstat(m_fd, &st)) ? static_cast<std::uint64_t>(st.st_size) : 0;
+    }
+
+    void rotate()
+    {
+        if (m_fd >= 0)
+        {
+            ::close(m_fd);
+        }
+
+        if (0 == m_maxFiles)
+        {
+            ::unlink(m_path.c_str());
+        }
+        for (unsigned i = m_maxFiles; i > 0; --i)
+        {
+            auto from = (1 == i) ? m_path : m_path + "." + std::to_string(i - 1);
+            ::rename(from.c_str(), (m_path + "." + std::to_string(i)).c_str());
+        }
+        open();
+    }
+
+    std::string m_path;
+    std::uint64_t m_maxSize;
+    unsigned m_maxFiles;
+    int m_fd = -1;
+    std::uint64_t m_size = 0;
+};
+
+// 一个环形缓冲区及其输出的log文件
+struct Channel {
+    std::string name;
+    std::unique_ptr<RotatingFile> file;
+    jumper::ShmRingReader ring;
+    // 已经报告过的丢弃记录数
+    std::uint64_t dropped = 0;
+    std::string buf;
+};
+
+// 读取一批记录写入文件，返回是否读到了记录
+bool drain(Channel& ch)
+{
+    ch.buf.clear();
+    bool busy = ch.ring.read(ch.buf, 1 << 20) > 0;
+
+    auto dropped = ch.ring.dropped();
+    if (dropped != ch.dropped)
+    {
+        ch.buf.append(jumper::format("[jlogd]: {} records dropped, ring buffer full\n",
+            dropped - ch.dropped));
+        ch.dropped = dropped;
+    }
+    if (!ch.buf.empty())
+    {
+        ch.file->write(ch.buf);
+    }
+
+    return busy;
+}
+
+// 处理一个环形缓冲区，返回是否读到了记录
+bool poll(Channel& ch)
+{
+    if (!ch.ring.is_open())
+    {
+        // 写入端可能还没有启动
+        if (!ch.ring.open(ch.name))
+        {
+            return false;
+        }
+        ch.dropped = 0;
+    }
+
+    if (drain(ch))
+    {
+        return true;
+    }
+
+    // 空闲时才检查写入端：进程退出或者名称指向了新的缓冲区时读完剩余的记录后释放
+    bool alive = ch.ring.producer_alive();
+    if (alive && !ch.ring.replaced())
+    {
+        return false;
+    }
+
+    while (drain(ch))
+    {
+    }
+    if (!alive)
+    {
+        ch.file->write(jumper::format("[jlogd]: producer {} exited\n", ch.ring.producer()));
+        ch.ring.unlink();
+    }
+    ch.ring.close();
+
+    return true;
+}
+
+void usage()
+{
+    std::fprintf(stderr,
+        "usage: jlogd [--dir DIR] [--max-size BYTES] [--max-files N] [--interval MS] RING...\n"
+        "  RING  shared memory name used as file.path with file.mode = shm\n");
+}
+
+} // namespace
+
+/// 用法：jlogd [--dir DIR] [--max-size BYTES] [--max-files N] [--interval MS] RING...
+/// 读取一个或多个共享内存环形缓冲区（file.mode = shm），每个写入DIR下的"名称.log"，
+/// 超过max-size字节时轮转，最多保留max-files个旧文件
+/// 写入端进程退出后读完剩余的记录并删除共享内存，同名的缓冲区重新创建后自动附加
+int main(int argc, char *argv[])
+{
+    std::string dir(".");
+    std::uint64_t maxSize = 64ull << 20;
+    unsigned maxFiles = 5;
+    auto interval = std::chrono::milliseconds(10);
+    std::vector<std::unique_ptr<Channel>> channels;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (0 == std::strcmp(argv[i], "--dir") && hasValue)
+        {
+            dir = argv[++i];
+        }
+        else if (0 == std::strcmp(argv[i], "--max-size") && hasValue)
+        {
+            maxSize = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (0 == std::strcmp(argv[i], "--max-files") && hasValue)
+        {
+            maxFiles = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (0 == std::strcmp(argv[i], "--interval") && hasValue)
+        {
+            interval = std::chrono::milliseconds(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if ('-' == argv[i][0])
+        {
+            usage();
+            return 2;
+        }
+        else
+        {
+            std::unique_ptr<Channel> ch(new Channel);
+            ch->name = argv[i];
+            auto file = jumper::jumper_inner::shm_name(ch->name).substr(1);
+            ch->file.reset(new RotatingFile(dir + "/" + file + ".log", maxSize, maxFiles));
+            channels.push_back(std::move(ch));
+        }
+    }
+
+    if (channels.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    struct sigaction action {};
+    action.sa_handler = on_stop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGTERM, &action, nullptr);
+    ::sigaction(SIGINT, &action, nullptr);
+
+    while (!s_stop.load(std::memory_order_relaxed))
+    {
+        bool busy = false;
+        for (auto& ch: channels)
+        {
+            busy = poll(*ch) || busy;
+        }
+        if (!busy)
+        {
+            std::this_thread::sleep_for(interval);
+        }
+    }
+
+    // 退出前读完所有缓冲区，写入端仍在运行时保留共享内存
+    for (auto& ch: channels)
+    {
+        if (ch->ring.is_open())
+        {
+            while (drain(*ch))
+            {
+            }
+        }
+    }
+
+    return 0;
+}